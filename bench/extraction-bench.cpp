@@ -0,0 +1,406 @@
+#include "extraction-engine/ArchiveExtractor.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Generates synthetic TAR corpora and measures listing and extraction on each.
+//
+// Corpora are deterministic: the same scale always produces byte-identical archives,
+// so results are comparable across builds and machines. They are written to the work
+// directory once and reused by later runs. Output is CSV, one line per corpus and
+// operation with the best of the repeats:
+//
+//   corpus,operation,entries,megabytes,seconds,mb_per_s,files_per_s,syscalls_per_entry,io_syscalls_per_entry
+//
+// syscalls_per_entry is the engine's own count of the system calls its output code
+// makes (directories, opens, writes, metadata, closes), summed over the phases of
+// ExtractionStats; extraction runs with collectStats for it. It is empty for listings
+// and off POSIX. io_syscalls_per_entry counts the read- and write-family calls the
+// kernel reports in /proc/self/io for the whole process, archive reads included
+// (Linux only; empty elsewhere).
+//
+// Usage: extraction-bench <work-dir> [scale] [repeats] [corpus...]
+//   scale    multiplies file counts and sizes (default 1; 0.1 for a quick run)
+//   corpus   any of tiny, huge, deep, longnames, mixed (default all)
+
+using namespace ArchiveEngine;
+
+namespace {
+
+    constexpr uint64_t FixedMtime = 1700000000;
+
+    // SplitMix64; the corpus depends on nothing but the seed
+    class Random {
+    public:
+        explicit Random(uint64_t seed) : m_state(seed) {}
+
+        uint64_t Next() {
+            uint64_t z = (m_state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        // Uniform in [low, high]
+        uint64_t Between(uint64_t low, uint64_t high) {
+            return low + Next() % (high - low + 1);
+        }
+
+    private:
+        uint64_t m_state;
+    };
+
+    // Writes ustar entries, with GNU long name records for names that do not fit
+    class TarWriter {
+    public:
+        explicit TarWriter(const std::filesystem::path& path) : m_file(path, std::ios::binary) {}
+
+        bool IsOpen() const { return m_file.is_open(); }
+
+        void AddDirectory(const std::string& name) {
+            WriteHeader(name + "/", '5', 0, 0755);
+        }
+
+        // Contents are pseudo-random words: compressible like text, never all zeros
+        void AddFile(const std::string& name, uint64_t size, Random& random) {
+            WriteHeader(name, '0', size, 0644);
+            char buffer[64 * 1024];
+            uint64_t remaining = size;
+            while (remaining > 0) {
+                size_t length = static_cast<size_t>(std::min<uint64_t>(remaining, sizeof(buffer)));
+                for (size_t i = 0; i < length; i += 8) {
+                    uint64_t word = random.Next() & 0x1F1F1F1F1F1F1F1Full;
+                    word += 0x6161616161616161ull;  // Lowercase letters and a few symbols
+                    std::memcpy(buffer + i, &word, std::min<size_t>(8, length - i));
+                }
+                m_file.write(buffer, static_cast<std::streamsize>(length));
+                remaining -= length;
+            }
+            Pad(size);
+        }
+
+        bool Close() {
+            // End of archive: two zero blocks
+            char zeros[1024] = {};
+            m_file.write(zeros, sizeof(zeros));
+            m_file.close();
+            return !m_file.fail();
+        }
+
+    private:
+        void WriteHeader(const std::string& name, char type, uint64_t size, uint32_t mode) {
+            if (name.size() > 99) {
+                WriteBlock("././@LongLink", 'L', name.size() + 1, 0644);
+                m_file.write(name.c_str(), static_cast<std::streamsize>(name.size() + 1));
+                Pad(name.size() + 1);
+            }
+            WriteBlock(name.substr(0, 99), type, size, mode);
+        }
+
+        void WriteBlock(const std::string& name, char type, uint64_t size, uint32_t mode) {
+            char header[512] = {};
+            std::memcpy(header, name.data(), std::min<size_t>(name.size(), 100));
+            std::snprintf(header + 100, 8, "%07o", mode);
+            std::snprintf(header + 108, 8, "%07o", 0);
+            std::snprintf(header + 116, 8, "%07o", 0);
+            std::snprintf(header + 124, 12, "%011llo", static_cast<unsigned long long>(size));
+            std::snprintf(header + 136, 12, "%011llo", static_cast<unsigned long long>(FixedMtime));
+            header[156] = type;
+            std::memcpy(header + 257, "ustar\0" "00", 8);
+
+            std::memset(header + 148, ' ', 8);
+            unsigned checksum = 0;
+            for (unsigned char byte : header) {
+                checksum += byte;
+            }
+            std::snprintf(header + 148, 8, "%06o", checksum);
+            m_file.write(header, sizeof(header));
+        }
+
+        void Pad(uint64_t size) {
+            static const char zeros[512] = {};
+            size_t padding = static_cast<size_t>((512 - size % 512) % 512);
+            m_file.write(zeros, static_cast<std::streamsize>(padding));
+        }
+
+        std::ofstream m_file;
+    };
+
+    std::string Numbered(const char* prefix, uint64_t number) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%s%05llu", prefix, static_cast<unsigned long long>(number));
+        return name;
+    }
+
+    uint64_t Scaled(uint64_t value, double scale) {
+        return std::max<uint64_t>(1, static_cast<uint64_t>(std::llround(value * scale)));
+    }
+
+    // Many tiny files, 64 to a directory
+    void GenerateTiny(TarWriter& tar, double scale) {
+        Random random(1);
+        uint64_t count = Scaled(20000, scale);
+        for (uint64_t i = 0; i < count; ++i) {
+            std::string directory = Numbered("dir", i / 64);
+            if (i % 64 == 0) {
+                tar.AddDirectory(directory);
+            }
+            tar.AddFile(directory + "/" + Numbered("file", i), random.Between(0, 1024), random);
+        }
+    }
+
+    // A few huge files
+    void GenerateHuge(TarWriter& tar, double scale) {
+        Random random(2);
+        for (uint64_t i = 0; i < 4; ++i) {
+            tar.AddFile(Numbered("huge", i), Scaled(256ull * 1024 * 1024, scale) + random.Between(0, 4096), random);
+        }
+    }
+
+    // Chains of nested directories 64 levels deep, files spread across every level
+    void GenerateDeep(TarWriter& tar, double scale) {
+        Random random(3);
+        uint64_t chains = Scaled(32, scale);
+        for (uint64_t chain = 0; chain < chains; ++chain) {
+            std::string path = Numbered("chain", chain);
+            tar.AddDirectory(path);
+            for (int level = 0; level < 64; ++level) {
+                path += "/" + Numbered("level", level);
+                tar.AddDirectory(path);
+                tar.AddFile(path + "/file", random.Between(0, 8192), random);
+            }
+        }
+    }
+
+    // Paths of 150 to 900 bytes, in components short enough for any file system
+    void GenerateLongNames(TarWriter& tar, double scale) {
+        Random random(4);
+        uint64_t count = Scaled(5000, scale);
+        std::string directory;
+        for (uint64_t i = 0; i < count; ++i) {
+            if (i % 50 == 0) {
+                // A new directory of several long components
+                directory.clear();
+                size_t components = static_cast<size_t>(random.Between(1, 4));
+                for (size_t c = 0; c < components; ++c) {
+                    directory += (c > 0 ? "/" : "") + Numbered("d", i + c) + std::string(random.Between(40, 180), 'x');
+                    tar.AddDirectory(directory);
+                }
+            }
+            std::string name = Numbered("f", i) + std::string(random.Between(100, 200), 'n');
+            tar.AddFile(directory + "/" + name, random.Between(0, 4096), random);
+        }
+    }
+
+    // Sizes spread across several orders of magnitude, as in a typical source or data tree
+    void GenerateMixed(TarWriter& tar, double scale) {
+        Random random(5);
+        uint64_t count = Scaled(5000, scale);
+        for (uint64_t i = 0; i < count; ++i) {
+            std::string directory = Numbered("mixed", i / 100);
+            if (i % 100 == 0) {
+                tar.AddDirectory(directory);
+            }
+            uint64_t bucket = random.Between(0, 99);
+            uint64_t size = bucket < 80 ? random.Between(0, 64 * 1024)
+                          : bucket < 99 ? random.Between(64 * 1024, 1024 * 1024)
+                          : Scaled(random.Between(1024 * 1024, 32 * 1024 * 1024), std::min(scale, 1.0));
+            tar.AddFile(directory + "/" + Numbered("file", i), size, random);
+        }
+    }
+
+    struct Corpus {
+        const char* name;
+        void (*generate)(TarWriter& tar, double scale);
+    };
+
+    const Corpus Corpora[] = {
+        { "tiny", GenerateTiny },
+        { "huge", GenerateHuge },
+        { "deep", GenerateDeep },
+        { "longnames", GenerateLongNames },
+        { "mixed", GenerateMixed },
+    };
+
+    // Read and write calls of this process so far, or -1 where the kernel does not say
+    int64_t CountIoSyscalls() {
+#ifdef __linux__
+        std::ifstream io("/proc/self/io");
+        std::string key;
+        int64_t value = 0;
+        int64_t total = 0;
+        int found = 0;
+        while (io >> key >> value) {
+            if (key == "syscr:" || key == "syscw:") {
+                total += value;
+                ++found;
+            }
+        }
+        return found == 2 ? total : -1;
+#else
+        return -1;
+#endif
+    }
+
+    struct Measurement {
+        uint64_t entries = 0;
+        uint64_t bytes = 0;
+        double seconds = 0;
+        int64_t syscalls = -1;        // Counted by the engine
+        int64_t ioSyscalls = -1;      // Reported by the kernel
+    };
+
+    // System calls the engine counted across every phase, or -1 without stats
+    int64_t EngineSyscalls(const ExtractionResult& result) {
+        if (!result.stats) {
+            return -1;
+        }
+        int64_t total = 0;
+        for (const PhaseStats& phase : result.stats->phases) {
+            total += static_cast<int64_t>(phase.systemCalls);
+        }
+        return total;
+    }
+
+    bool Measure(const std::function<bool(Measurement&)>& operation, Measurement& result) {
+        int64_t syscallsBefore = CountIoSyscalls();
+        auto start = std::chrono::steady_clock::now();
+        if (!operation(result)) {
+            return false;
+        }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        int64_t syscallsAfter = CountIoSyscalls();
+        result.ioSyscalls = syscallsBefore >= 0 && syscallsAfter >= 0 ? syscallsAfter - syscallsBefore : -1;
+        return true;
+    }
+
+    void Report(const char* corpus, const char* operation, const Measurement& best) {
+        double megabytes = best.bytes / (1024.0 * 1024.0);
+        std::printf("%s,%s,%llu,%.1f,%.3f,%.1f,%.0f,", corpus, operation,
+                    static_cast<unsigned long long>(best.entries), megabytes, best.seconds,
+                    best.seconds > 0 ? megabytes / best.seconds : 0.0,
+                    best.seconds > 0 ? best.entries / best.seconds : 0.0);
+        if (best.syscalls >= 0 && best.entries > 0) {
+            std::printf("%.2f", static_cast<double>(best.syscalls) / best.entries);
+        }
+        std::printf(",");
+        if (best.ioSyscalls >= 0 && best.entries > 0) {
+            std::printf("%.2f", static_cast<double>(best.ioSyscalls) / best.entries);
+        }
+        std::printf("\n");
+        std::fflush(stdout);
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::printf("Usage: extraction-bench <work-dir> [scale] [repeats] [corpus...]\n");
+        return 1;
+    }
+
+    std::filesystem::path workDirectory = argv[1];
+    double scale = argc > 2 ? std::atof(argv[2]) : 1.0;
+    int repeats = argc > 3 ? std::max(1, std::atoi(argv[3])) : 3;
+    if (scale <= 0) {
+        std::printf("Scale must be positive\n");
+        return 1;
+    }
+    std::vector<std::string> selected(argv + std::min(argc, 4), argv + argc);
+
+    std::error_code ec;
+    std::filesystem::create_directories(workDirectory, ec);
+
+    std::printf("corpus,operation,entries,megabytes,seconds,mb_per_s,files_per_s,syscalls_per_entry,"
+                "io_syscalls_per_entry\n");
+    for (const Corpus& corpus : Corpora) {
+        if (!selected.empty() && std::find(selected.begin(), selected.end(), corpus.name) == selected.end()) {
+            continue;
+        }
+
+        // Archives are named after their parameters and only generated when missing
+        char archiveName[64];
+        std::snprintf(archiveName, sizeof(archiveName), "%s-%g.tar", corpus.name, scale);
+        std::filesystem::path archive = workDirectory / archiveName;
+        if (!std::filesystem::exists(archive)) {
+            std::filesystem::path partial = archive;
+            partial += ".partial";
+            TarWriter tar(partial);
+            if (!tar.IsOpen()) {
+                std::printf("Cannot create %s\n", partial.string().c_str());
+                return 1;
+            }
+            corpus.generate(tar, scale);
+            if (!tar.Close()) {
+                std::printf("Cannot write %s\n", partial.string().c_str());
+                return 1;
+            }
+            std::filesystem::rename(partial, archive);
+        }
+
+        std::wstring archivePath = archive.wstring();
+        std::filesystem::path output = workDirectory / "output";
+        auto extractor = ArchiveExtractorFactory::CreateExtractor(archivePath);
+        if (!extractor) {
+            std::printf("No extractor for %s\n", archive.string().c_str());
+            return 1;
+        }
+        ExtractionOptions options;
+        options.collectStats = true;
+
+        Measurement bestList;
+        Measurement bestExtract;
+        for (int i = 0; i < repeats; ++i) {
+            Measurement list;
+            bool listed = Measure([&](Measurement& m) {
+                return extractor->VisitEntries(archivePath, options, [&](const ArchiveEntryView& entry) {
+                    ++m.entries;
+                    m.bytes += entry.size;
+                    return true;
+                });
+            }, list);
+
+            // Every extraction starts from an empty destination
+            std::filesystem::remove_all(output, ec);
+            Measurement extract;
+            bool extracted = Measure([&](Measurement& m) {
+                ExtractionResult result = extractor->Extract(archivePath, output.wstring(), options);
+                if (!result.success) {
+                    std::printf("Extraction of %s failed: %s\n", archive.string().c_str(),
+                                Utils::ToUtf8(result.errorMessage).c_str());
+                    return false;
+                }
+                m.entries = result.extractedFiles.size();
+                m.bytes = result.totalUncompressedSize;
+#ifndef _WIN32
+                m.syscalls = EngineSyscalls(result);
+#endif
+                return true;
+            }, extract);
+            if (!listed || !extracted) {
+                return 2;
+            }
+
+            if (i == 0 || list.seconds < bestList.seconds) {
+                bestList = list;
+            }
+            if (i == 0 || extract.seconds < bestExtract.seconds) {
+                bestExtract = extract;
+            }
+        }
+        std::filesystem::remove_all(output, ec);
+
+        Report(corpus.name, "list", bestList);
+        Report(corpus.name, "extract", bestExtract);
+    }
+
+    return 0;
+}
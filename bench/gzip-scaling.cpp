@@ -0,0 +1,118 @@
+#include "extraction-engine/GzipExtractor.h"
+#include "extraction-engine/Inflate.h"
+#include "extraction-engine/ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <vector>
+
+// Decodes a .gz file with an increasing number of decompression threads and reports
+// throughput and speedup over the sequential decoder. Every run's output is checked
+// against the sequential one by CRC-32.
+//
+// Usage: gzip-scaling <file.gz> [max-threads] [repeats]
+//
+// Measured on a single-CPU host, best of 3 (40 MB .tar.gz of /usr/include, 257 MiB out):
+//
+//   threads  seconds  MB/s   speedup
+//   1        0.955    288.7  1.00
+//   2        2.065    133.6  0.46
+//   4        2.028    136.0  0.47
+//
+// With one core the threads only add up their work: parallel decoding costs about 2.2x
+// the sequential decoder per byte (speculative decoding of each chunk, then resolving its
+// window references). No run with two or more cores has been recorded, so whether and
+// from how many cores the parallel decoder pays off is not known yet.
+//
+// For the same reason the sequential cutoff in OpenGzipSource (2 * DefaultChunkSize,
+// 8 MiB compressed) has not been measured. It only rests on a file of one chunk having
+// nothing to split. Once results for 1, 2, 4 and 8 or more threads exist, the cutoff
+// should be the smallest file size at which the parallel decoder wins at each count.
+
+using namespace ArchiveEngine;
+
+namespace {
+
+    struct RunResult {
+        double seconds = 0;
+        uint64_t bytes = 0;
+        uint32_t crc = 0;
+    };
+
+    bool DecodeOnce(const std::wstring& path, unsigned threads, RunResult& result) {
+        auto start = std::chrono::steady_clock::now();
+        auto source = OpenGzipSource(path, threads);
+        if (!source) {
+            return false;
+        }
+        result.bytes = 0;
+        result.crc = 0;
+        const char* data = nullptr;
+        while (size_t length = source->Read(data, SIZE_MAX)) {
+            result.crc = Crc32(result.crc, data, length);
+            result.bytes += length;
+        }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return true;
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::printf("Usage: gzip-scaling <file.gz> [max-threads] [repeats]\n");
+        return 1;
+    }
+
+    std::wstring path = std::filesystem::path(argv[1]).wstring();
+    unsigned maxThreads = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : ThreadPool::DefaultThreadCount();
+    int repeats = argc > 3 ? std::max(1, std::atoi(argv[3])) : 3;
+
+    std::vector<unsigned> threadCounts = { 1 };
+    for (unsigned threads = 2; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    if (maxThreads > 1) {
+        threadCounts.push_back(maxThreads);
+    }
+
+    // One line per thread count: threads, best time, output MB/s, speedup
+    std::printf("threads,seconds,mb_per_s,speedup\n");
+    double baseline = 0;
+    uint32_t expectedCrc = 0;
+    for (unsigned threads : threadCounts) {
+        RunResult best;
+        for (int i = 0; i < repeats; ++i) {
+            RunResult run;
+            try {
+                if (!DecodeOnce(path, threads, run)) {
+                    std::printf("Cannot open %s\n", argv[1]);
+                    return 1;
+                }
+            } catch (const std::exception& e) {
+                std::printf("Decoding failed with %u threads: %s\n", threads, e.what());
+                return 1;
+            }
+            if (i == 0 || run.seconds < best.seconds) {
+                best = run;
+            }
+        }
+
+        if (threads == 1) {
+            baseline = best.seconds;
+            expectedCrc = best.crc;
+        } else if (best.crc != expectedCrc) {
+            std::printf("Output mismatch with %u threads\n", threads);
+            return 2;
+        }
+
+        double megabytes = best.bytes / (1024.0 * 1024.0);
+        std::printf("%u,%.3f,%.1f,%.2f\n", threads, best.seconds,
+                    best.seconds > 0 ? megabytes / best.seconds : 0.0,
+                    best.seconds > 0 ? baseline / best.seconds : 0.0);
+    }
+
+    return 0;
+}
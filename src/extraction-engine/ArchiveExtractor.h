@@ -1,6 +1,10 @@
 #pragma once
 
+#include "CancellationToken.h"
+#include "ExtractionProgress.h"
+#include "ExtractionStats.h"
 #include <string>
+#include <string_view>
 #include <vector>
 #include <functional>
 #include <memory>
@@ -15,9 +19,94 @@ namespace ArchiveEngine {
     struct ExtractionResult {
         bool success;
         std::wstring errorMessage;
-        std::vector<std::wstring> extractedFiles;
+        std::vector<std::wstring> extractedFiles; // Files are listed only once on disk whole, also when the extraction fails
         uint64_t bytesProcessed;
+        uint64_t totalUncompressedSize; // Exact sum of entry sizes, known once the archive has been fully read
         double timeElapsed; // seconds
+        std::shared_ptr<const ExtractionStats> stats; // Per-phase costs, with ExtractionOptions::collectStats
+        bool cancelled = false; // Stopped through ExtractionOptions::cancellation or the progress callback
+    };
+
+    // Extraction options
+    struct ExtractionOptions {
+        // Read the archive exactly once: progress is reported as archive bytes consumed
+        // against the archive file size instead of pre-scanning for the uncompressed total
+        bool singlePass = false;
+
+        // Threads decoding gzip and bzip2 data: 1 decodes sequentially, 0 uses every hardware thread.
+        // Small archives are always decoded sequentially.
+        unsigned decompressionThreads = 1;
+
+        // Bytes of the archive kept read ahead of the parser by a background thread, for
+        // archives on slow or high-latency storage; 0 (the default) maps the archive into
+        // memory instead. Applies to plain TAR and sequential gzip input only. Parallel
+        // gzip decoding and all bzip2 decoding map the archive regardless: bzip2 blocks
+        // are located by bit position anywhere in the file, and decode far slower than
+        // storage delivers, so the kernel's own read-ahead on the mapping keeps up.
+        size_t readAheadWindow = 0;
+
+        // Threads creating and writing extracted files while the archive is read;
+        // 0 writes every file on the reading thread
+        unsigned writerThreads = 4;
+
+        // Upper bound on file data read ahead of the writers, in bytes
+        size_t writeBufferBudget = 64 * 1024 * 1024;
+
+        // Reuse the sidecar entry index (<archive>.idx) when it is current, and write one
+        // after a full listing or extraction otherwise. TAR-based formats only.
+        bool useIndex = false;
+
+        // Leave 4 KiB blocks of zeros in extracted files unwritten so they become holes on
+        // file systems with sparse file support. The gaps of sparse TAR entries are never
+        // written either way.
+        bool writeHoles = false;
+
+        // Regular files of at least this many bytes have their whole size reserved before
+        // they are written, so they are laid out contiguously; 0 reserves nothing. Linux only.
+        uint64_t preallocateThreshold = 1024 * 1024;
+
+        // Regular files of at least this many bytes are written with O_DIRECT in large
+        // aligned chunks, bypassing the page cache; 0 (the default) never does. Linux only.
+        uint64_t directWriteThreshold = 0;
+
+        // Regular files of at least this many bytes in uncompressed archives are copied
+        // from the archive file inside the kernel (reflink, copy_file_range or splice)
+        // rather than through the process; 0 never does. Linux only.
+        uint64_t kernelCopyThreshold = 1024 * 1024;
+
+        // Create and write small regular files in batches through io_uring, so many files
+        // cost one system call; off by default. The kernel hands file creation to its worker
+        // threads, so this pays off with cores to spare. Linux 5.17 or later only; elsewhere,
+        // or where io_uring is unavailable, files are written one at a time as usual.
+        bool batchSmallFiles = false;
+
+        // Time each phase of extraction (header parsing, path checks, directory and file
+        // creation, writing, closing) and each file into ExtractionResult::stats. Costs
+        // a few clock reads per entry. TAR-based extractors only.
+        bool collectStats = false;
+
+        // When set, spans for header parsing, decompression, directory creation and file
+        // open, write and close are recorded on every thread and written to this file as
+        // Chrome trace JSON (for Perfetto or chrome://tracing) once extraction ends. The
+        // extraction result does not depend on the trace being written. TAR-based
+        // extractors only.
+        std::wstring tracePath;
+
+        // Progress of the extraction, for other threads to poll or subscribe to; updated
+        // with atomic counters as entries complete (or, for single-file formats, as data
+        // is decoded). Optional.
+        std::shared_ptr<ExtractionProgress> progress;
+
+        // Minimum time between ProgressCallback calls, in milliseconds; 0 calls it for
+        // every entry. The final "Complete" call is always made.
+        uint32_t progressInterval = 0;
+
+        // Stops the extraction once cancelled, from any thread. Files finished before then
+        // are left complete; a file still being written is removed rather than left cut
+        // short. The result reports failure with `cancelled` set. Optional.
+        std::shared_ptr<CancellationToken> cancellation;
+
+        bool Cancelled() const { return cancellation && cancellation->IsCancelled(); }
     };
 
     // Archive entry information
@@ -31,6 +120,22 @@ namespace ArchiveEngine {
         std::wstring linkTarget; // For symbolic links
     };
 
+    // Archive entry as handed to an EntryVisitor. The name and link target are the bytes
+    // stored in the archive (UTF-8 for single-file formats, whose name comes from the
+    // archive file name); they point into the read buffer and are only valid during the call.
+    struct ArchiveEntryView {
+        std::string_view name;
+        std::string_view linkTarget;
+        uint64_t size;
+        uint64_t compressedSize;
+        bool isDirectory;
+        uint64_t lastModified; // Unix timestamp
+        uint32_t permissions;
+    };
+
+    // Called once per entry in archive order; return false to stop listing
+    using EntryVisitor = std::function<bool(const ArchiveEntryView& entry)>;
+
     // Abstract base class for archive extractors
     class IArchiveExtractor {
     public:
@@ -42,12 +147,42 @@ namespace ArchiveEngine {
         // Get archive information without extracting
         virtual bool GetArchiveInfo(const std::wstring& filePath, std::vector<ArchiveEntry>& entries) const = 0;
 
+        // Get archive information with explicit options
+        virtual bool GetArchiveInfo(const std::wstring& filePath, const ExtractionOptions& /*options*/,
+                                    std::vector<ArchiveEntry>& entries) const {
+            return GetArchiveInfo(filePath, entries);
+        }
+
+        // Stream archive entries to `visitor` without materializing a listing. Returns false
+        // if the archive cannot be read; stopping early is not an error.
+        virtual bool VisitEntries(const std::wstring& filePath, const ExtractionOptions& options,
+                                  const EntryVisitor& visitor) const = 0;
+
         // Extract archive to destination directory
         virtual ExtractionResult Extract(
             const std::wstring& archivePath,
             const std::wstring& destinationPath,
             ProgressCallback callback = nullptr) const = 0;
 
+        // Extract archive to destination directory with explicit options
+        virtual ExtractionResult Extract(
+            const std::wstring& archivePath,
+            const std::wstring& destinationPath,
+            const ExtractionOptions& options,
+            ProgressCallback callback = nullptr) const = 0;
+
+        // Extract only the entries selected by `paths`: exact entry paths or glob patterns
+        // ('*' and '?' within a path component, '**' across them). Selecting a directory
+        // selects everything below it. A path stored more than once is extracted from its
+        // last copy. Exact paths the archive does not hold fail the extraction once
+        // everything else selected has been extracted.
+        virtual ExtractionResult Extract(
+            const std::wstring& archivePath,
+            const std::wstring& destinationPath,
+            const std::vector<std::wstring>& paths,
+            const ExtractionOptions& options,
+            ProgressCallback callback = nullptr) const = 0;
+
         // Get supported file extensions
         virtual std::vector<std::wstring> GetSupportedExtensions() const = 0;
 
@@ -96,6 +231,12 @@ namespace ArchiveEngine {
         std::wstring ToLowerCase(const std::wstring& str);
         bool EndsWith(const std::wstring& str, const std::wstring& suffix);
         std::vector<std::wstring> SplitPath(const std::wstring& path);
+        std::string ToUtf8(const std::wstring& str);
+
+        // Archive names are carried as wide strings holding one byte per character, so any
+        // encoding survives unchanged; these convert between the two forms
+        std::wstring WidenBytes(std::string_view bytes);
+        std::string NarrowBytes(std::wstring_view str);
         
         // Time utilities
         std::wstring FormatDuration(double seconds);
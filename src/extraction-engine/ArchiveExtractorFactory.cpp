@@ -1,5 +1,7 @@
 #include "ArchiveExtractor.h"
 #include "TarExtractor.h"
+#include "GzipExtractor.h"
+#include "Bzip2Extractor.h"
 #include <algorithm>
 
 namespace ArchiveEngine {
@@ -26,15 +28,19 @@ namespace ArchiveEngine {
         switch (type) {
         case ArchiveType::Tar:
             return std::make_unique<TarExtractor>();
-        
+
         case ArchiveType::TarGzip:
-        case ArchiveType::TarBzip2:
+            return std::make_unique<TarGzipExtractor>();
+
         case ArchiveType::Gzip:
-        case ArchiveType::Bzip2:
-            // TODO: Implement compressed extractors in next iteration
-            // For now, return nullptr to indicate unsupported
-            return nullptr;
+            return std::make_unique<GzipExtractor>();
         
+        case ArchiveType::TarBzip2:
+            return std::make_unique<TarBzip2Extractor>();
+
+        case ArchiveType::Bzip2:
+            return std::make_unique<Bzip2Extractor>();
+
         default:
             return nullptr;
         }
@@ -54,14 +60,18 @@ namespace ArchiveEngine {
         auto tarExtractor = std::make_unique<TarExtractor>();
         auto tarExtensions = tarExtractor->GetSupportedExtensions();
         extensions.insert(extensions.end(), tarExtensions.begin(), tarExtensions.end());
-        
-        // TODO: Add other extractors when implemented
-        // extensions.push_back(L".gz");
-        // extensions.push_back(L".bz2");
-        // extensions.push_back(L".tar.gz");
-        // extensions.push_back(L".tar.bz2");
-        // extensions.push_back(L".tgz");
-        // extensions.push_back(L".tbz2");
+
+        // gzip extractors
+        auto tarGzipExtensions = TarGzipExtractor().GetSupportedExtensions();
+        extensions.insert(extensions.end(), tarGzipExtensions.begin(), tarGzipExtensions.end());
+        auto gzipExtensions = GzipExtractor().GetSupportedExtensions();
+        extensions.insert(extensions.end(), gzipExtensions.begin(), gzipExtensions.end());
+
+        // bzip2 extractors
+        auto tarBzip2Extensions = TarBzip2Extractor().GetSupportedExtensions();
+        extensions.insert(extensions.end(), tarBzip2Extensions.begin(), tarBzip2Extensions.end());
+        auto bzip2Extensions = Bzip2Extractor().GetSupportedExtensions();
+        extensions.insert(extensions.end(), bzip2Extensions.begin(), bzip2Extensions.end());
         
         // Remove duplicates
         std::sort(extensions.begin(), extensions.end());
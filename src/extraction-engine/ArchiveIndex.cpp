@@ -0,0 +1,230 @@
+#include "ArchiveIndex.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace ArchiveEngine {
+
+    // Index file layout (little-endian, like the hosts the engine targets):
+    //   IndexHeader
+    //   Record[entryCount]    entries in archive order
+    //   uint32_t[entryCount]  record numbers sorted by name
+    //   char[namesSize]       name and link target bytes
+    namespace {
+
+        constexpr char IndexMagic[8] = { 'T', 'A', 'R', 'I', 'D', 'X', '0', '2' };
+
+        struct IndexHeader {
+            char magic[8];
+            uint64_t archiveSize;
+            int64_t archiveMtime;  // File system timestamp ticks, compared for equality only
+            uint64_t entryCount;
+            uint64_t namesSize;
+        };
+
+        // Size and modification time identifying the archive contents an index describes
+        bool GetArchiveStamp(const std::wstring& archivePath, uint64_t& size, int64_t& mtime) {
+            std::error_code ec;
+            std::filesystem::path path(archivePath);
+            size = std::filesystem::file_size(path, ec);
+            if (ec) {
+                return false;
+            }
+            auto time = std::filesystem::last_write_time(path, ec);
+            if (ec) {
+                return false;
+            }
+            mtime = static_cast<int64_t>(time.time_since_epoch().count());
+            return true;
+        }
+
+    } // namespace
+
+    struct ArchiveIndex::Record {
+        uint64_t nameOffset;
+        uint32_t nameLength;
+        uint32_t linkLength;  // The link target follows the name
+        uint64_t headerOffset;
+        uint64_t dataOffset;
+        uint64_t size;
+        uint64_t storedSize;
+        uint64_t mtime;
+        uint32_t permissions;
+        char type;
+        char reserved[3];
+    };
+
+    // ArchiveIndex implementation
+    std::wstring ArchiveIndex::IndexPath(const std::wstring& archivePath) {
+        return archivePath + L".idx";
+    }
+
+    bool ArchiveIndex::Load(const std::wstring& archivePath) {
+        static_assert(sizeof(IndexHeader) % 8 == 0, "index records must stay 8-byte aligned");
+        static_assert(sizeof(Record) == 64, "index record layout is part of the file format");
+
+        m_count = 0;
+        uint64_t archiveSize = 0;
+        int64_t archiveMtime = 0;
+        if (!GetArchiveStamp(archivePath, archiveSize, archiveMtime) || !m_file.Open(IndexPath(archivePath))) {
+            return false;
+        }
+
+        const char* data = m_file.Data();
+        uint64_t fileSize = m_file.Size();
+        if (fileSize < sizeof(IndexHeader)) {
+            return false;
+        }
+        IndexHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        if (std::memcmp(header.magic, IndexMagic, sizeof(IndexMagic)) != 0 ||
+            header.archiveSize != archiveSize || header.archiveMtime != archiveMtime) {
+            return false;
+        }
+
+        // Sizes must add up exactly before any record is trusted
+        uint64_t count = header.entryCount;
+        if (count > (fileSize - sizeof(IndexHeader)) / (sizeof(Record) + sizeof(uint32_t)) ||
+            fileSize != sizeof(IndexHeader) + count * (sizeof(Record) + sizeof(uint32_t)) + header.namesSize) {
+            return false;
+        }
+
+        const Record* records = reinterpret_cast<const Record*>(data + sizeof(IndexHeader));
+        const uint32_t* sorted = reinterpret_cast<const uint32_t*>(records + count);
+        for (uint64_t i = 0; i < count; ++i) {
+            const Record& record = records[i];
+            if (record.nameOffset > header.namesSize ||
+                uint64_t(record.nameLength) + record.linkLength > header.namesSize - record.nameOffset ||
+                sorted[i] >= count) {
+                return false;
+            }
+        }
+
+        m_records = records;
+        m_sorted = sorted;
+        m_names = reinterpret_cast<const char*>(sorted + count);
+        m_count = static_cast<size_t>(count);
+        return true;
+    }
+
+    IndexEntry ArchiveIndex::Entry(size_t index) const {
+        const Record& record = m_records[index];
+        IndexEntry entry;
+        entry.name = std::string_view(m_names + record.nameOffset, record.nameLength);
+        entry.linkTarget = std::string_view(m_names + record.nameOffset + record.nameLength, record.linkLength);
+        entry.headerOffset = record.headerOffset;
+        entry.dataOffset = record.dataOffset;
+        entry.size = record.size;
+        entry.storedSize = record.storedSize;
+        entry.mtime = record.mtime;
+        entry.permissions = record.permissions;
+        entry.type = record.type;
+        return entry;
+    }
+
+    std::string_view ArchiveIndex::NameAt(uint32_t index) const {
+        const Record& record = m_records[index];
+        return std::string_view(m_names + record.nameOffset, record.nameLength);
+    }
+
+    size_t ArchiveIndex::Find(std::string_view path) const {
+        // Equal names keep archive order, so the last of a run is the latest entry
+        const uint32_t* end = m_sorted + m_count;
+        const uint32_t* it = std::upper_bound(m_sorted, end, path, [this](std::string_view value, uint32_t index) {
+            return value < NameAt(index);
+        });
+        if (it == m_sorted || NameAt(*(it - 1)) != path) {
+            return NotFound;
+        }
+        return *(it - 1);
+    }
+
+    // ArchiveIndexWriter implementation
+    void ArchiveIndexWriter::Add(std::string_view name, std::string_view linkTarget, uint64_t headerOffset,
+                                 uint64_t dataOffset, uint64_t size, uint64_t storedSize, uint64_t mtime,
+                                 uint32_t permissions, char type) {
+        PendingEntry entry;
+        entry.nameOffset = m_names.size();
+        entry.nameLength = static_cast<uint32_t>(name.size());
+        entry.linkLength = static_cast<uint32_t>(linkTarget.size());
+        entry.headerOffset = headerOffset;
+        entry.dataOffset = dataOffset;
+        entry.size = size;
+        entry.storedSize = storedSize;
+        entry.mtime = mtime;
+        entry.permissions = permissions;
+        entry.type = type;
+        m_entries.push_back(entry);
+        m_names.append(name);
+        m_names.append(linkTarget);
+    }
+
+    bool ArchiveIndexWriter::Save(const std::wstring& archivePath) const {
+        IndexHeader header;
+        std::memcpy(header.magic, IndexMagic, sizeof(IndexMagic));
+        if (!GetArchiveStamp(archivePath, header.archiveSize, header.archiveMtime)) {
+            return false;
+        }
+        header.entryCount = m_entries.size();
+        header.namesSize = m_names.size();
+
+        std::vector<ArchiveIndex::Record> records(m_entries.size());
+        for (size_t i = 0; i < m_entries.size(); ++i) {
+            const PendingEntry& entry = m_entries[i];
+            ArchiveIndex::Record& record = records[i];
+            std::memset(&record, 0, sizeof(record));
+            record.nameOffset = entry.nameOffset;
+            record.nameLength = entry.nameLength;
+            record.linkLength = entry.linkLength;
+            record.headerOffset = entry.headerOffset;
+            record.dataOffset = entry.dataOffset;
+            record.size = entry.size;
+            record.storedSize = entry.storedSize;
+            record.mtime = entry.mtime;
+            record.permissions = entry.permissions;
+            record.type = entry.type;
+        }
+
+        std::vector<uint32_t> sorted(m_entries.size());
+        for (size_t i = 0; i < sorted.size(); ++i) {
+            sorted[i] = static_cast<uint32_t>(i);
+        }
+        auto nameOf = [this](uint32_t index) {
+            const PendingEntry& entry = m_entries[index];
+            return std::string_view(m_names.data() + entry.nameOffset, entry.nameLength);
+        };
+        std::stable_sort(sorted.begin(), sorted.end(), [&](uint32_t a, uint32_t b) {
+            return nameOf(a) < nameOf(b);
+        });
+
+        // Written beside the final name and renamed over it, so readers never see a partial index
+        std::wstring indexPath = ArchiveIndex::IndexPath(archivePath);
+        std::filesystem::path tempPath(indexPath + L".tmp");
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                return false;
+            }
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(ArchiveIndex::Record));
+            file.write(reinterpret_cast<const char*>(sorted.data()), sorted.size() * sizeof(uint32_t));
+            file.write(m_names.data(), static_cast<std::streamsize>(m_names.size()));
+            file.close();
+            if (file.fail()) {
+                std::error_code ec;
+                std::filesystem::remove(tempPath, ec);
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tempPath, std::filesystem::path(indexPath), ec);
+        if (ec) {
+            std::filesystem::remove(tempPath, ec);
+            return false;
+        }
+        return true;
+    }
+
+} // namespace ArchiveEngine
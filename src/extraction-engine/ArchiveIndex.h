@@ -0,0 +1,89 @@
+#pragma once
+
+#include "ArchiveSource.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ArchiveEngine {
+
+    // Entry as recorded in an archive index. Names are the raw TAR path bytes.
+    struct IndexEntry {
+        std::string_view name;
+        std::string_view linkTarget;
+        uint64_t headerOffset; // Offset of the entry's first header in the (decompressed) TAR stream
+        uint64_t dataOffset;   // Offset of the entry data in the (decompressed) TAR stream
+        uint64_t size;         // Size of the extracted file
+        uint64_t storedSize;   // Data bytes in the archive; less than size for sparse files
+        uint64_t mtime;        // Unix timestamp
+        uint32_t permissions;
+        char type;             // TarFileType flag
+    };
+
+    // Read-only view of a sidecar entry index (<archive>.idx).
+    //
+    // The index is memory-mapped and used in place: entries are stored in archive order
+    // next to a permutation sorted by name, so listing is a sequential read and lookup by
+    // path is a binary search. An index is only accepted while the archive still has the
+    // size and modification time recorded in it.
+    class ArchiveIndex {
+    public:
+        static constexpr size_t NotFound = static_cast<size_t>(-1);
+
+        // Sidecar file holding the index of `archivePath`
+        static std::wstring IndexPath(const std::wstring& archivePath);
+
+        // Opens the index of `archivePath`; false if it is missing, malformed or stale
+        bool Load(const std::wstring& archivePath);
+
+        size_t Size() const { return m_count; }
+
+        // Entry `index` in archive order
+        IndexEntry Entry(size_t index) const;
+
+        // Archive-order index of the entry with exactly this path, or NotFound.
+        // When a path occurs more than once the last entry (the one extraction keeps) wins.
+        size_t Find(std::string_view path) const;
+
+    private:
+        friend class ArchiveIndexWriter;
+        struct Record;
+
+        std::string_view NameAt(uint32_t index) const;
+
+        MappedFile m_file;
+        const Record* m_records = nullptr;
+        const uint32_t* m_sorted = nullptr;
+        const char* m_names = nullptr;
+        size_t m_count = 0;
+    };
+
+    // Collects entries during a listing or extraction and writes them as a sidecar index
+    class ArchiveIndexWriter {
+    public:
+        void Add(std::string_view name, std::string_view linkTarget, uint64_t headerOffset,
+                 uint64_t dataOffset, uint64_t size, uint64_t storedSize, uint64_t mtime,
+                 uint32_t permissions, char type);
+
+        // Writes the index of `archivePath`, replacing any previous one atomically
+        bool Save(const std::wstring& archivePath) const;
+
+    private:
+        struct PendingEntry {
+            uint64_t nameOffset;
+            uint32_t nameLength;
+            uint32_t linkLength;
+            uint64_t headerOffset;
+            uint64_t dataOffset;
+            uint64_t size;
+            uint64_t storedSize;
+            uint64_t mtime;
+            uint32_t permissions;
+            char type;
+        };
+
+        std::vector<PendingEntry> m_entries;
+        std::string m_names;  // Each name is followed directly by its link target
+    };
+
+} // namespace ArchiveEngine
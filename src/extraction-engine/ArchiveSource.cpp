@@ -0,0 +1,428 @@
+#include "ArchiveSource.h"
+#include "ArchiveExtractor.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <climits>
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ArchiveEngine {
+
+    // MappedFile implementation
+    MappedFile::~MappedFile() {
+        Close();
+    }
+
+#ifdef _WIN32
+    bool MappedFile::Open(const std::wstring& filePath) {
+        Close();
+
+        HANDLE file = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+            CloseHandle(file);
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file); // The mapping keeps its own reference
+        if (mapping == nullptr) {
+            return false;
+        }
+
+        void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (view == nullptr) {
+            CloseHandle(mapping);
+            return false;
+        }
+
+        m_mapping = mapping;
+        m_data = static_cast<const char*>(view);
+        m_size = static_cast<uint64_t>(size.QuadPart);
+        return true;
+    }
+
+    void MappedFile::Close() {
+        if (m_data != nullptr) {
+            UnmapViewOfFile(m_data);
+            m_data = nullptr;
+        }
+        if (m_mapping != nullptr) {
+            CloseHandle(m_mapping);
+            m_mapping = nullptr;
+        }
+        m_size = 0;
+    }
+#else
+    bool MappedFile::Open(const std::wstring& filePath) {
+        Close();
+
+        // Anything but a regular file is left unopened: opening a FIFO connects it to its
+        // writer, which would see a broken pipe once this closes it again
+        std::filesystem::path path(filePath);
+        struct stat st;
+        if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+            return false;
+        }
+
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0 ||
+            static_cast<uint64_t>(st.st_size) > SIZE_MAX) {
+            ::close(fd);
+            return false;
+        }
+
+        void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+
+        // Archives are consumed front to back; let the kernel read ahead aggressively
+        madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+
+        // The descriptor stays open for copies made outside the mapping
+        m_fd = fd;
+        m_data = static_cast<const char*>(view);
+        m_size = static_cast<uint64_t>(st.st_size);
+        return true;
+    }
+
+    void MappedFile::Close() {
+        if (m_data != nullptr) {
+            munmap(const_cast<char*>(m_data), static_cast<size_t>(m_size));
+            m_data = nullptr;
+        }
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+        m_size = 0;
+    }
+#endif
+
+    // MappedArchiveSource implementation
+    bool MappedArchiveSource::Open(const std::wstring& filePath) {
+        m_position = 0;
+        return m_file.Open(filePath);
+    }
+
+    const char* MappedArchiveSource::ReadBlock(size_t length) {
+        if (m_file.Size() - m_position < length) {
+            return nullptr;
+        }
+        const char* block = m_file.Data() + m_position;
+        m_position += length;
+        return block;
+    }
+
+    size_t MappedArchiveSource::Read(const char*& data, size_t maxLength) {
+        size_t length = static_cast<size_t>(std::min<uint64_t>(maxLength, m_file.Size() - m_position));
+        data = m_file.Data() + m_position;
+        m_position += length;
+        return length;
+    }
+
+    bool MappedArchiveSource::Skip(uint64_t length) {
+        if (m_file.Size() - m_position < length) {
+            m_position = m_file.Size();
+            return false;
+        }
+        m_position += length;
+        return true;
+    }
+
+    // ReadAheadArchiveSource implementation
+    namespace {
+
+#ifdef _WIN32
+        int OpenForReading(const std::wstring& filePath) {
+            return _wopen(filePath.c_str(), _O_RDONLY | _O_BINARY);
+        }
+
+        int64_t ReadFrom(int fd, char* data, size_t length) {
+            return _read(fd, data, static_cast<unsigned>(std::min<size_t>(length, INT_MAX)));
+        }
+
+        bool SeekTo(int fd, uint64_t offset) {
+            return _lseeki64(fd, static_cast<__int64>(offset), SEEK_SET) >= 0;
+        }
+
+        void CloseFile(int fd) {
+            _close(fd);
+        }
+#else
+        int OpenForReading(const std::wstring& filePath) {
+            return ::open(std::filesystem::path(filePath).c_str(), O_RDONLY | O_CLOEXEC);
+        }
+
+        int64_t ReadFrom(int fd, char* data, size_t length) {
+            ssize_t bytesRead;
+            do {
+                bytesRead = ::read(fd, data, length);
+            } while (bytesRead < 0 && errno == EINTR);
+            return bytesRead;
+        }
+
+        bool SeekTo(int fd, uint64_t offset) {
+            return ::lseek(fd, static_cast<off_t>(offset), SEEK_SET) >= 0;
+        }
+
+        void CloseFile(int fd) {
+            ::close(fd);
+        }
+#endif
+
+    } // namespace
+
+    ReadAheadArchiveSource::ReadAheadArchiveSource(size_t window)
+        : m_buffers(BufferCount) {
+        size_t bufferSize = std::max<size_t>(window / BufferCount, 64 * 1024);
+        for (size_t i = 0; i < m_buffers.size(); ++i) {
+            m_buffers[i].data.resize(bufferSize);
+            m_free.push_back(i);
+        }
+    }
+
+    ReadAheadArchiveSource::~ReadAheadArchiveSource() {
+        if (m_reader.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stopping = true;
+            }
+            m_readerWake.notify_all();
+            m_reader.join();
+        }
+        if (m_fd >= 0) {
+            CloseFile(m_fd);
+        }
+    }
+
+    bool ReadAheadArchiveSource::Open(const std::wstring& filePath) {
+        m_fd = OpenForReading(filePath);
+        if (m_fd < 0) {
+            return false;
+        }
+
+        // Pipes and other streams are read through; regular files can be skipped in
+#ifdef _WIN32
+        struct _stat64 st;
+        m_seekable = _fstat64(m_fd, &st) == 0 && (st.st_mode & _S_IFREG) != 0;
+#else
+        struct stat st;
+        m_seekable = fstat(m_fd, &st) == 0 && S_ISREG(st.st_mode);
+#endif
+        m_size = m_seekable ? static_cast<uint64_t>(st.st_size) : 0;
+
+#if !defined(_WIN32) && defined(POSIX_FADV_SEQUENTIAL)
+        // Lets the kernel read ahead further on its own as well
+        posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+        m_reader = std::thread(&ReadAheadArchiveSource::ReaderLoop, this);
+        return true;
+    }
+
+    void ReadAheadArchiveSource::ReaderLoop() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        uint64_t filePosition = 0;
+        for (;;) {
+            m_readerWake.wait(lock, [&] { return m_stopping || (!m_finished && !m_free.empty()); });
+            if (m_stopping) {
+                return;
+            }
+            size_t index = m_free.front();
+            m_free.pop_front();
+            unsigned generation = m_generation;
+            uint64_t offset = m_readOffset;
+
+            // The file is read without the lock, filling the buffer unless the file ends
+            lock.unlock();
+            Buffer& buffer = m_buffers[index];
+            int error = 0;
+            bool failed = offset != filePosition && !SeekTo(m_fd, offset);
+            if (failed) {
+                error = errno;
+            }
+            filePosition = offset;
+            size_t length = 0;
+            while (!failed && length < buffer.data.size()) {
+                int64_t bytesRead = ReadFrom(m_fd, buffer.data.data() + length, buffer.data.size() - length);
+                if (bytesRead <= 0) {
+                    // The end of the file and a failed read both stop the reader; only the
+                    // latter is an error for the parser
+                    failed = true;
+                    if (bytesRead < 0) {
+                        error = errno;
+                    }
+                    break;
+                }
+                length += static_cast<size_t>(bytesRead);
+            }
+            filePosition += length;
+            lock.lock();
+
+            if (generation != m_generation) {
+                // The parser moved on while this was read
+                m_free.push_back(index);
+                continue;
+            }
+            buffer.length = length;
+            m_readOffset = offset + length;
+            if (length > 0) {
+                m_filled.push_back(index);
+            } else {
+                m_free.push_back(index);
+            }
+            m_finished = failed;
+            if (error != 0) {
+                m_readError = error;
+            }
+            m_bufferReady.notify_one();
+        }
+    }
+
+    bool ReadAheadArchiveSource::NextBuffer() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_current != NoBuffer) {
+            m_free.push_back(m_current);
+            m_current = NoBuffer;
+            m_readerWake.notify_one();
+        }
+        m_bufferReady.wait(lock, [&] { return !m_filled.empty() || m_finished; });
+        if (m_filled.empty()) {
+            // A read error must not pass for the end of the archive
+            if (m_readError != 0) {
+                throw ExtractionException(L"cannot read archive: " + Utils::WidenBytes(std::strerror(m_readError)));
+            }
+            return false;
+        }
+        m_current = m_filled.front();
+        m_filled.pop_front();
+        m_begin = 0;
+        return true;
+    }
+
+    void ReadAheadArchiveSource::Reposition(uint64_t offset) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_current != NoBuffer) {
+                m_free.push_back(m_current);
+                m_current = NoBuffer;
+            }
+            while (!m_filled.empty()) {
+                m_free.push_back(m_filled.front());
+                m_filled.pop_front();
+            }
+            ++m_generation;
+            m_readOffset = offset;
+            m_finished = false;
+        }
+        m_readerWake.notify_one();
+    }
+
+    const char* ReadAheadArchiveSource::ReadBlock(size_t length) {
+        if (Available() == 0 && !NextBuffer()) {
+            return nullptr;
+        }
+        if (Available() >= length) {
+            const char* block = m_buffers[m_current].data.data() + m_begin;
+            m_begin += length;
+            m_position += length;
+            return block;
+        }
+
+        // The block continues in the next buffer
+        m_joined.resize(length);
+        size_t joined = 0;
+        while (joined < length) {
+            if (Available() == 0 && !NextBuffer()) {
+                return nullptr;
+            }
+            size_t part = std::min(length - joined, Available());
+            std::memcpy(m_joined.data() + joined, m_buffers[m_current].data.data() + m_begin, part);
+            m_begin += part;
+            joined += part;
+        }
+        m_position += length;
+        return m_joined.data();
+    }
+
+    size_t ReadAheadArchiveSource::Read(const char*& data, size_t maxLength) {
+        if (Available() == 0 && !NextBuffer()) {
+            return 0;
+        }
+        size_t length = std::min(maxLength, Available());
+        data = m_buffers[m_current].data.data() + m_begin;
+        m_begin += length;
+        m_position += length;
+        return length;
+    }
+
+    bool ReadAheadArchiveSource::Skip(uint64_t length) {
+        // Anything beyond the window is cheaper to seek past than to read through
+        uint64_t window = m_buffers.size() * m_buffers[0].data.size();
+        while (length > 0) {
+            size_t skipped = static_cast<size_t>(std::min<uint64_t>(length, Available()));
+            m_begin += skipped;
+            m_position += skipped;
+            length -= skipped;
+            if (length == 0) {
+                break;
+            }
+
+            if (m_seekable && length > window) {
+                if (m_size - m_position < length) {
+                    m_position = m_size;
+                    Reposition(m_size);
+                    return false;
+                }
+                m_position += length;
+                Reposition(m_position);
+                return true;
+            }
+            if (!NextBuffer()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::unique_ptr<IArchiveSource> OpenArchiveSource(const std::wstring& filePath, size_t readAheadWindow) {
+        if (readAheadWindow == 0) {
+            auto mapped = std::make_unique<MappedArchiveSource>();
+            if (mapped->Open(filePath)) {
+                return mapped;
+            }
+        }
+
+        auto stream = std::make_unique<ReadAheadArchiveSource>(
+            readAheadWindow > 0 ? readAheadWindow : ReadAheadArchiveSource::DefaultWindow);
+        if (stream->Open(filePath)) {
+            return stream;
+        }
+        return nullptr;
+    }
+
+} // namespace ArchiveEngine
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "CancellationToken.h"
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ArchiveEngine {
+
+    class TraceRecorder;
+
+    // Read-only memory mapping of a whole file
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool Open(const std::wstring& filePath);
+        void Close();
+
+        const char* Data() const { return m_data; }
+        uint64_t Size() const { return m_size; }
+        bool IsOpen() const { return m_data != nullptr; }
+
+#ifndef _WIN32
+        // Descriptor of the mapped file, kept open alongside the mapping
+        int Descriptor() const { return m_fd; }
+#endif
+
+    private:
+        const char* m_data = nullptr;
+        uint64_t m_size = 0;
+#ifdef _WIN32
+        void* m_mapping = nullptr;
+#else
+        int m_fd = -1;
+#endif
+    };
+
+    // Sequential, forward-only byte stream that the TAR parser consumes.
+    // Pointers handed out by ReadBlock/Read point into the source's own storage
+    // and stay valid until the next call on the source.
+    class IArchiveSource {
+    public:
+        virtual ~IArchiveSource() = default;
+
+        // Returns exactly `length` contiguous bytes and advances past them,
+        // or nullptr if the stream ends first
+        virtual const char* ReadBlock(size_t length) = 0;
+
+        // Returns up to `maxLength` contiguous bytes and advances past them.
+        // Returns 0 only at end of stream.
+        virtual size_t Read(const char*& data, size_t maxLength) = 0;
+
+        // Advances past `length` bytes without handing them out
+        virtual bool Skip(uint64_t length) = 0;
+
+        // Offset of the next byte in the stream
+        virtual uint64_t Position() const = 0;
+
+        // Bytes consumed from the underlying archive file. Differs from Position()
+        // only for sources that decompress on the fly.
+        virtual uint64_t InputPosition() const { return Position(); }
+
+        // Open descriptor of the archive file when stream offsets are offsets in that file
+        // (an uncompressed archive), so payloads can be copied file to file in the kernel;
+        // -1 otherwise. Always -1 on Windows.
+        virtual int Descriptor() const { return -1; }
+
+        // Records decompression as spans into `trace` from now on; null stops recording
+        void SetTrace(TraceRecorder* trace) { m_trace = trace; }
+
+        // Decoding sources stop once `cancellation` is cancelled, ending the stream early
+        void SetCancellation(const CancellationToken* cancellation) { m_cancellation = cancellation; }
+
+    protected:
+        bool Cancelled() const { return m_cancellation && m_cancellation->IsCancelled(); }
+
+        TraceRecorder* m_trace = nullptr;
+        const CancellationToken* m_cancellation = nullptr;
+    };
+
+    // Archive source backed by a memory mapping: headers and payloads are
+    // handed out in place, without any copy
+    class MappedArchiveSource : public IArchiveSource {
+    public:
+        bool Open(const std::wstring& filePath);
+
+        const char* ReadBlock(size_t length) override;
+        size_t Read(const char*& data, size_t maxLength) override;
+        bool Skip(uint64_t length) override;
+        uint64_t Position() const override { return m_position; }
+#ifndef _WIN32
+        int Descriptor() const override { return m_file.Descriptor(); }
+#endif
+
+    private:
+        MappedFile m_file;
+        uint64_t m_position = 0;
+    };
+
+    // Archive source reading the file on a background thread. A window of buffers is
+    // kept filled ahead of the parser, which is handed pointers into them without a
+    // copy; only blocks straddling two buffers are joined. Skips past the window move
+    // the reader in seekable files instead of reading through. Used when the archive
+    // cannot be mapped (empty files, pipes, exhausted address space), and on request
+    // for slow or high-latency storage, where faults on a mapping stall the parser.
+    class ReadAheadArchiveSource : public IArchiveSource {
+    public:
+        static constexpr size_t DefaultWindow = 4 * 1024 * 1024;
+        static constexpr unsigned BufferCount = 4;  // The window is split into this many buffers
+
+        explicit ReadAheadArchiveSource(size_t window = DefaultWindow);
+        ~ReadAheadArchiveSource() override;  // Stops the reader
+
+        ReadAheadArchiveSource(const ReadAheadArchiveSource&) = delete;
+        ReadAheadArchiveSource& operator=(const ReadAheadArchiveSource&) = delete;
+
+        bool Open(const std::wstring& filePath);
+
+        const char* ReadBlock(size_t length) override;
+        size_t Read(const char*& data, size_t maxLength) override;
+        bool Skip(uint64_t length) override;
+        uint64_t Position() const override { return m_position; }
+#ifndef _WIN32
+        int Descriptor() const override { return m_seekable ? m_fd : -1; }
+#endif
+
+    private:
+        static constexpr size_t NoBuffer = static_cast<size_t>(-1);
+
+        struct Buffer {
+            std::vector<char> data;
+            size_t length = 0;
+        };
+
+        void ReaderLoop();
+
+        // Hands the current buffer back and waits for the next filled one; false at the end.
+        // Throws ExtractionException once everything read before a read error is consumed.
+        bool NextBuffer();
+
+        // Drops everything read ahead and has the reader continue at `offset`
+        void Reposition(uint64_t offset);
+
+        size_t Available() const { return m_current == NoBuffer ? 0 : m_buffers[m_current].length - m_begin; }
+
+        int m_fd = -1;
+        bool m_seekable = false;
+        uint64_t m_size = 0;  // Of seekable files
+        std::vector<Buffer> m_buffers;
+        size_t m_current = NoBuffer;  // Buffer being consumed, owned by the parser
+        size_t m_begin = 0;           // Consumed bytes of the current buffer
+        std::vector<char> m_joined;   // Blocks that straddle two buffers
+        uint64_t m_position = 0;
+
+        std::thread m_reader;
+        std::mutex m_mutex;
+        std::condition_variable m_readerWake;  // A buffer was freed, the reader moved, or stop
+        std::condition_variable m_bufferReady; // A buffer was filled or the reader reached the end
+        std::deque<size_t> m_free;
+        std::deque<size_t> m_filled;           // In file order
+        uint64_t m_readOffset = 0;             // Where the reader continues
+        unsigned m_generation = 0;             // Bumped on each move; reads begun before are dropped
+        bool m_finished = false;               // End of file or a read error
+        int m_readError = 0;                   // errno of the read that failed; kept once set
+        bool m_stopping = false;
+    };
+
+    // Opens the best available source for a file: a mapping when possible, reading
+    // ahead otherwise. A nonzero `readAheadWindow` asks for reading ahead with that
+    // window instead of a mapping. Returns nullptr if the file cannot be opened.
+    std::unique_ptr<IArchiveSource> OpenArchiveSource(const std::wstring& filePath, size_t readAheadWindow = 0);
+
+} // namespace ArchiveEngine
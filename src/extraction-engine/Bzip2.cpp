@@ -0,0 +1,442 @@
+#include "Bzip2.h"
+#include <algorithm>
+
+namespace ArchiveEngine {
+
+    namespace {
+
+        constexpr unsigned MaxGroups = 6;
+        constexpr unsigned MaxAlphabetSize = 258;
+        constexpr unsigned MaxCodeLength = 20;
+        constexpr unsigned MaxSelectors = 18002;
+        constexpr unsigned GroupSize = 50;  // Symbols coded with one selector
+
+        struct Bzip2CrcTables {
+            uint32_t table[8][256];
+
+            Bzip2CrcTables() {
+                for (uint32_t i = 0; i < 256; ++i) {
+                    uint32_t c = i << 24;
+                    for (int k = 0; k < 8; ++k) {
+                        c = (c & 0x80000000u) ? (c << 1) ^ 0x04C11DB7u : c << 1;
+                    }
+                    table[0][i] = c;
+                }
+                for (uint32_t i = 0; i < 256; ++i) {
+                    for (int t = 1; t < 8; ++t) {
+                        table[t][i] = (table[t - 1][i] << 8) ^ table[0][table[t - 1][i] >> 24];
+                    }
+                }
+            }
+        };
+
+        const Bzip2CrcTables& GetBzip2CrcTables() {
+            static const Bzip2CrcTables tables;
+            return tables;
+        }
+
+        inline uint32_t LoadBE32(const uint8_t* p) {
+            return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+        }
+
+        // 48 bits starting `bit` bits into `data`; bytes past the end read as zero
+        uint64_t ReadBits48(const uint8_t* data, size_t length, uint64_t bit) {
+            size_t byte = static_cast<size_t>(bit / 8);
+            uint64_t word = 0;
+            for (size_t i = 0; i < 7; ++i) {
+                word = (word << 8) | (byte + i < length ? data[byte + i] : 0);
+            }
+            return (word >> (8 - bit % 8)) & 0xFFFFFFFFFFFFull;
+        }
+
+    } // namespace
+
+    uint32_t Bzip2Crc(uint32_t crc, const void* data, size_t length) {
+        const auto& t = GetBzip2CrcTables().table;
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+
+        crc = ~crc;
+        while (length >= 8) {
+            uint32_t high = LoadBE32(p) ^ crc;
+            crc = t[7][high >> 24] ^ t[6][(high >> 16) & 0xff] ^ t[5][(high >> 8) & 0xff] ^ t[4][high & 0xff] ^
+                  t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+            p += 8;
+            length -= 8;
+        }
+        while (length-- > 0) {
+            crc = (crc << 8) ^ t[0][(crc >> 24) ^ *p++];
+        }
+        return ~crc;
+    }
+
+    uint64_t FindBzip2Magic(const uint8_t* data, size_t length, uint64_t bitOffset, uint64_t magic) {
+        // A magic starting at bit s of byte p fills byte p + 1 with its bits [8 - s, 16 - s).
+        // Each byte is screened against those eight patterns before all 48 bits are compared.
+        uint8_t shifts[256] = {};
+        for (unsigned s = 0; s < 8; ++s) {
+            shifts[(magic >> (32 + s)) & 0xff] |= static_cast<uint8_t>(1u << s);
+        }
+
+        uint64_t totalBits = uint64_t(length) * 8;
+        for (size_t p = static_cast<size_t>(bitOffset / 8); p + 1 < length; ++p) {
+            unsigned mask = shifts[data[p + 1]];
+            for (unsigned s = 0; mask != 0; ++s, mask >>= 1) {
+                uint64_t bit = uint64_t(p) * 8 + s;
+                if ((mask & 1) && bit >= bitOffset && bit + 48 <= totalBits &&
+                    ReadBits48(data, length, bit) == magic) {
+                    return bit;
+                }
+            }
+        }
+        return Bzip2NoPosition;
+    }
+
+    // Bzip2BitReader implementation
+    void Bzip2BitReader::SetInput(const uint8_t* data, size_t length, uint64_t bitOffset) {
+        size_t byte = static_cast<size_t>(std::min<uint64_t>(bitOffset / 8, length));
+        m_base = data;
+        m_in = data + byte;
+        m_inEnd = data + length;
+        m_buffer = 0;
+        m_count = 0;
+        m_padBytes = 0;
+        Refill();
+        if (bitOffset % 8 != 0) {
+            Drop(static_cast<unsigned>(bitOffset % 8));
+        }
+    }
+
+    // Canonical Huffman code of one coding group. Codes up to LookupBits long decode
+    // with a single table lookup; longer ones (rare) walk the per-length code ranges.
+    struct Bzip2BlockDecoder::HuffmanGroup {
+        static constexpr unsigned LookupBits = 10;
+
+        uint16_t lookup[1 << LookupBits];     // symbol << 5 | length, 0 if the code is longer
+        uint32_t firstCode[MaxCodeLength + 2];
+        uint32_t endCode[MaxCodeLength + 2];  // One past the last code of each length
+        uint16_t firstIndex[MaxCodeLength + 2];
+        uint16_t sorted[MaxAlphabetSize];     // Symbols ordered by code length
+        unsigned maxLength = 0;
+
+        bool Build(const uint8_t* lengths, unsigned alphabetSize) {
+            unsigned counts[MaxCodeLength + 2] = {};
+            for (unsigned i = 0; i < alphabetSize; ++i) {
+                ++counts[lengths[i]];
+            }
+
+            // Reject over-subscribed codes; incomplete ones fail when an unused code is read
+            uint32_t kraft = 0;
+            maxLength = 0;
+            for (unsigned length = 1; length <= MaxCodeLength; ++length) {
+                kraft += counts[length] << (MaxCodeLength - length);
+                if (counts[length] > 0) {
+                    maxLength = length;
+                }
+            }
+            if (kraft > (1u << MaxCodeLength)) {
+                return false;
+            }
+
+            uint32_t code = 0;
+            unsigned index = 0;
+            for (unsigned length = 1; length <= MaxCodeLength; ++length) {
+                firstCode[length] = code;
+                firstIndex[length] = static_cast<uint16_t>(index);
+                endCode[length] = code + counts[length];
+                code = (code + counts[length]) << 1;
+                index += counts[length];
+            }
+
+            uint16_t next[MaxCodeLength + 2];
+            std::copy(firstIndex, firstIndex + MaxCodeLength + 1, next);
+            for (unsigned symbol = 0; symbol < alphabetSize; ++symbol) {
+                sorted[next[lengths[symbol]]++] = static_cast<uint16_t>(symbol);
+            }
+
+            std::fill(lookup, lookup + (1 << LookupBits), uint16_t(0));
+            for (unsigned length = 1; length <= std::min(maxLength, LookupBits); ++length) {
+                for (unsigned i = 0; i < counts[length]; ++i) {
+                    uint16_t symbol = sorted[firstIndex[length] + i];
+                    unsigned fill = LookupBits - length;
+                    uint32_t start = (firstCode[length] + i) << fill;
+                    std::fill(lookup + start, lookup + start + (1u << fill),
+                              static_cast<uint16_t>((symbol << 5) | length));
+                }
+            }
+            return true;
+        }
+
+        // Needs a refilled reader
+        bool Decode(Bzip2BitReader& reader, unsigned& symbol) const {
+            uint16_t entry = lookup[reader.Peek(LookupBits)];
+            if (entry != 0) {
+                reader.Drop(entry & 31);
+                symbol = entry >> 5;
+                return true;
+            }
+            for (unsigned length = LookupBits + 1; length <= maxLength; ++length) {
+                uint32_t code = reader.Peek(length);
+                if (code < endCode[length]) {
+                    symbol = sorted[firstIndex[length] + code - firstCode[length]];
+                    reader.Drop(length);
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    // Bzip2BlockDecoder implementation
+    Bzip2BlockDecoder::Bzip2BlockDecoder()
+        : m_groups(new HuffmanGroup[MaxGroups]),
+          m_tt(new uint32_t[MaxBlockSize]),
+          m_bwtOutput(new uint8_t[MaxBlockSize]) {
+        m_selectors.reserve(MaxSelectors);
+    }
+
+    Bzip2BlockDecoder::~Bzip2BlockDecoder() = default;
+
+    bool Bzip2BlockDecoder::Decode(const uint8_t* data, size_t length, uint64_t bitOffset, Bzip2Block& block) {
+        Bzip2BitReader reader;
+        reader.SetInput(data, length, bitOffset);
+
+        uint64_t magic = uint64_t(reader.Read(24)) << 24;
+        magic |= reader.Read(24);
+        if (magic != Bzip2BlockMagic) {
+            return false;
+        }
+        block.startBit = bitOffset;
+        block.crc = reader.Read(32);
+
+        // Randomised blocks were last written by bzip2 0.9.0
+        if (reader.Read(1) != 0) {
+            return false;
+        }
+        uint32_t origin = reader.Read(24);
+
+        uint32_t symbolCount = 0;
+        if (!ReadTables(reader) || !DecodeSymbols(reader, symbolCount) || origin >= symbolCount) {
+            return false;
+        }
+        block.endBit = reader.Position();
+        block.symbolCount = symbolCount;
+
+        InverseBwt(symbolCount, origin);
+        block.data.clear();
+        UndoInitialRle(symbolCount, block.data);
+        return Bzip2Crc(0, block.data.data(), block.data.size()) == block.crc;
+    }
+
+    bool Bzip2BlockDecoder::ReadTables(Bzip2BitReader& reader) {
+        // Bytes used in the block: a 16-bit map of ranges, then a 16-bit map per used range
+        m_symbolsInUse = 0;
+        uint32_t ranges = reader.Read(16);
+        for (unsigned i = 0; i < 16; ++i) {
+            if (ranges & (0x8000u >> i)) {
+                uint32_t used = reader.Read(16);
+                for (unsigned j = 0; j < 16; ++j) {
+                    if (used & (0x8000u >> j)) {
+                        m_symbolToByte[m_symbolsInUse++] = static_cast<uint8_t>(i * 16 + j);
+                    }
+                }
+            }
+        }
+        if (m_symbolsInUse == 0) {
+            return false;
+        }
+        unsigned alphabetSize = m_symbolsInUse + 2;
+
+        m_groupCount = reader.Read(3);
+        unsigned selectorCount = reader.Read(15);
+        if (m_groupCount < 2 || m_groupCount > MaxGroups || selectorCount == 0) {
+            return false;
+        }
+
+        // Selectors are MTF-coded in unary; bzip2 1.0.8 ignores any past MaxSelectors
+        uint8_t order[MaxGroups];
+        for (unsigned i = 0; i < MaxGroups; ++i) {
+            order[i] = static_cast<uint8_t>(i);
+        }
+        m_selectors.clear();
+        for (unsigned i = 0; i < selectorCount; ++i) {
+            unsigned index = 0;
+            reader.Refill();
+            while (reader.Peek(1)) {
+                reader.Drop(1);
+                if (++index >= m_groupCount) {
+                    return false;
+                }
+            }
+            reader.Drop(1);
+            uint8_t group = order[index];
+            std::copy_backward(order, order + index, order + index + 1);
+            order[0] = group;
+            if (i < MaxSelectors) {
+                m_selectors.push_back(group);
+            }
+        }
+
+        // Code lengths: a 5-bit start, then per symbol a delta-coded walk
+        uint8_t lengths[MaxAlphabetSize];
+        for (unsigned g = 0; g < m_groupCount; ++g) {
+            int current = static_cast<int>(reader.Read(5));
+            for (unsigned symbol = 0; symbol < alphabetSize; ++symbol) {
+                for (;;) {
+                    if (current < 1 || current > static_cast<int>(MaxCodeLength) || reader.Overread()) {
+                        return false;
+                    }
+                    reader.Refill();
+                    if (!reader.Peek(1)) {
+                        reader.Drop(1);
+                        break;
+                    }
+                    current += reader.Peek(2) == 2 ? 1 : -1;
+                    reader.Drop(2);
+                }
+                lengths[symbol] = static_cast<uint8_t>(current);
+            }
+            if (!m_groups[g].Build(lengths, alphabetSize)) {
+                return false;
+            }
+        }
+        return !reader.Overread();
+    }
+
+    bool Bzip2BlockDecoder::DecodeSymbols(Bzip2BitReader& reader, uint32_t& symbolCount) {
+        uint32_t* tt = m_tt.get();
+        std::fill(m_byteCounts, m_byteCounts + 256, 0u);
+
+        // MTF list of the bytes in use, initially in byte order
+        uint8_t mtf[256];
+        std::copy(m_symbolToByte, m_symbolToByte + m_symbolsInUse, mtf);
+
+        const unsigned endOfBlock = m_symbolsInUse + 1;
+        size_t selector = 0;
+        unsigned groupLeft = 0;
+        const HuffmanGroup* group = nullptr;
+        uint32_t count = 0;
+        uint32_t run = 0;
+        uint32_t runWeight = 1;
+
+        for (;;) {
+            if (groupLeft == 0) {
+                if (selector >= m_selectors.size()) {
+                    return false;
+                }
+                group = &m_groups[m_selectors[selector++]];
+                groupLeft = GroupSize;
+            }
+            --groupLeft;
+
+            reader.Refill();
+            unsigned symbol;
+            if (!group->Decode(reader, symbol)) {
+                return false;
+            }
+
+            // RUNA/RUNB digits give a bijective base-2 repeat count of the front byte
+            if (symbol <= 1) {
+                if (runWeight > MaxBlockSize) {
+                    return false;
+                }
+                run += runWeight << symbol;
+                runWeight <<= 1;
+                continue;
+            }
+            if (run > 0) {
+                if (run > MaxBlockSize - count) {
+                    return false;
+                }
+                uint8_t byte = mtf[0];
+                m_byteCounts[byte] += run;
+                std::fill(tt + count, tt + count + run, uint32_t(byte));
+                count += run;
+                run = 0;
+                runWeight = 1;
+            }
+            if (symbol == endOfBlock) {
+                break;
+            }
+
+            if (count >= MaxBlockSize) {
+                return false;
+            }
+            unsigned index = symbol - 1;
+            uint8_t byte = mtf[index];
+            std::memmove(mtf + 1, mtf, index);
+            mtf[0] = byte;
+            ++m_byteCounts[byte];
+            tt[count++] = byte;
+        }
+
+        symbolCount = count;
+        return !reader.Overread();
+    }
+
+    void Bzip2BlockDecoder::InverseBwt(uint32_t symbolCount, uint32_t origin) {
+        uint32_t* tt = m_tt.get();
+
+        uint32_t next[256];
+        uint32_t sum = 0;
+        for (unsigned i = 0; i < 256; ++i) {
+            next[i] = sum;
+            sum += m_byteCounts[i];
+        }
+
+        // Link each row to its successor in the first column
+        for (uint32_t i = 0; i < symbolCount; ++i) {
+            tt[next[tt[i] & 0xff]++] |= i << 8;
+        }
+
+        uint8_t* out = m_bwtOutput.get();
+        uint32_t position = tt[origin] >> 8;
+        for (uint32_t i = 0; i < symbolCount; ++i) {
+            uint32_t entry = tt[position];
+            out[i] = static_cast<uint8_t>(entry);
+            position = entry >> 8;
+        }
+    }
+
+    void Bzip2BlockDecoder::UndoInitialRle(uint32_t symbolCount, std::vector<uint8_t>& output) const {
+        // Four equal bytes are followed by a count of further repeats (0-255)
+        const uint8_t* in = m_bwtOutput.get();
+        const uint8_t* end = in + symbolCount;
+        constexpr size_t MaxExpansion = 4 + 255;
+
+        output.resize(symbolCount + symbolCount / 4 + MaxExpansion);
+        uint8_t* out = output.data();
+        uint8_t* outEnd = out + output.size();
+
+        while (in < end) {
+            if (static_cast<size_t>(outEnd - out) < MaxExpansion) {
+                size_t used = static_cast<size_t>(out - output.data());
+                output.resize(output.size() * 2);
+                out = output.data() + used;
+                outEnd = output.data() + output.size();
+            }
+
+            uint8_t byte = *in++;
+            *out++ = byte;
+            if (in == end || *in != byte) {
+                continue;
+            }
+            *out++ = *in++;
+            if (in == end || *in != byte) {
+                continue;
+            }
+            *out++ = *in++;
+            if (in == end || *in != byte) {
+                continue;
+            }
+            *out++ = *in++;
+            if (in == end) {
+                break;
+            }
+            unsigned repeats = *in++;
+            std::memset(out, byte, repeats);
+            out += repeats;
+        }
+        output.resize(static_cast<size_t>(out - output.data()));
+    }
+
+} // namespace ArchiveEngine
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace ArchiveEngine {
+
+    // CRC-32 as used by bzip2 (polynomial 0x04c11db7, most significant bit first)
+    uint32_t Bzip2Crc(uint32_t crc, const void* data, size_t length);
+
+    // bzip2 block and end-of-stream magics; neither is byte-aligned in the stream
+    constexpr uint64_t Bzip2BlockMagic = 0x314159265359ull;
+    constexpr uint64_t Bzip2EndMagic = 0x177245385090ull;
+    constexpr uint64_t Bzip2NoPosition = ~uint64_t(0);
+
+    // Bit position of the first occurrence of a 48-bit magic at or after `bitOffset`,
+    // or Bzip2NoPosition
+    uint64_t FindBzip2Magic(const uint8_t* data, size_t length, uint64_t bitOffset, uint64_t magic);
+
+    // MSB-first bit reader over a memory range. Reads past the end return zero bits
+    // and are reported by Overread().
+    class Bzip2BitReader {
+    public:
+        void SetInput(const uint8_t* data, size_t length, uint64_t bitOffset = 0);
+
+        // Reads 1 to 32 bits
+        uint32_t Read(unsigned count) {
+            Refill();
+            uint32_t value = Peek(count);
+            Drop(count);
+            return value;
+        }
+
+        // At least 56 bits are available to Peek after a refill
+        void Refill() {
+            if (m_inEnd - m_in >= 8) {
+                uint64_t word;
+                std::memcpy(&word, m_in, sizeof(word));
+                m_buffer |= ByteSwap(word) >> m_count;
+                m_in += (63 - m_count) >> 3;
+                m_count |= 56;
+                return;
+            }
+            while (m_count <= 56) {
+                uint64_t byte = 0;
+                if (m_in < m_inEnd) {
+                    byte = *m_in++;
+                } else {
+                    ++m_padBytes;
+                }
+                m_buffer |= byte << (56 - m_count);
+                m_count += 8;
+            }
+        }
+
+        uint32_t Peek(unsigned count) const { return static_cast<uint32_t>(m_buffer >> (64 - count)); }
+        void Drop(unsigned count) { m_buffer <<= count; m_count -= count; }
+
+        uint64_t Position() const { return (m_in - m_base + m_padBytes) * uint64_t(8) - m_count; }
+        bool Overread() const { return m_padBytes * 8 > m_count; }
+
+    private:
+        // Big-endian loads on the little-endian hosts the engine targets
+        static uint64_t ByteSwap(uint64_t value) {
+#if defined(_MSC_VER)
+            return _byteswap_uint64(value);
+#else
+            return __builtin_bswap64(value);
+#endif
+        }
+
+        const uint8_t* m_base = nullptr;
+        const uint8_t* m_in = nullptr;
+        const uint8_t* m_inEnd = nullptr;
+        uint64_t m_buffer = 0;  // Valid bits are left-aligned
+        unsigned m_count = 0;
+        unsigned m_padBytes = 0;
+    };
+
+    // One decoded bzip2 block
+    struct Bzip2Block {
+        uint64_t startBit = 0;     // Position of the block magic
+        uint64_t endBit = 0;       // Position just past the end-of-block symbol
+        uint32_t crc = 0;          // Stored block CRC, already checked against the output
+        uint32_t symbolCount = 0;  // Bytes entering the BWT, bounded by the stream's block size
+        std::vector<uint8_t> data;
+    };
+
+    // Decodes single bzip2 blocks: Huffman/MTF/RLE2 decoding, inverse BWT and RLE1.
+    // Blocks are independent, so one decoder per thread can work anywhere in a file.
+    class Bzip2BlockDecoder {
+    public:
+        static constexpr uint32_t MaxBlockSize = 900000;
+
+        Bzip2BlockDecoder();
+        ~Bzip2BlockDecoder();
+
+        // Decodes the block whose magic starts `bitOffset` bits into `data` and checks
+        // its CRC. Returns false for corrupt or truncated blocks.
+        bool Decode(const uint8_t* data, size_t length, uint64_t bitOffset, Bzip2Block& block);
+
+    private:
+        struct HuffmanGroup;
+
+        bool ReadTables(Bzip2BitReader& reader);
+        bool DecodeSymbols(Bzip2BitReader& reader, uint32_t& symbolCount);
+        void InverseBwt(uint32_t symbolCount, uint32_t origin);
+        void UndoInitialRle(uint32_t symbolCount, std::vector<uint8_t>& output) const;
+
+        // Block state
+        uint8_t m_symbolToByte[256];
+        unsigned m_symbolsInUse = 0;
+        unsigned m_groupCount = 0;
+        std::vector<uint8_t> m_selectors;
+        std::unique_ptr<HuffmanGroup[]> m_groups;
+        uint32_t m_byteCounts[256];
+
+        // BWT vector: the last-column byte in the low 8 bits and, once linked, the index of
+        // the row holding the next output byte above them, so each step of the inverse
+        // transform touches a single cache line
+        std::unique_ptr<uint32_t[]> m_tt;
+        std::unique_ptr<uint8_t[]> m_bwtOutput;
+    };
+
+} // namespace ArchiveEngine
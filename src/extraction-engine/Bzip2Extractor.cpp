@@ -0,0 +1,282 @@
+#include "Bzip2Extractor.h"
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <cstring>
+
+namespace ArchiveEngine {
+
+    // Bzip2ArchiveSource implementation
+    Bzip2ArchiveSource::Bzip2ArchiveSource(unsigned threadCount)
+        : m_threadCount(threadCount > 0 ? threadCount : ThreadPool::DefaultThreadCount()) {}
+
+    Bzip2ArchiveSource::~Bzip2ArchiveSource() = default;
+
+    bool Bzip2ArchiveSource::Open(const std::wstring& filePath) {
+        if (!m_file.Open(filePath)) {
+            return false;
+        }
+        m_data = reinterpret_cast<const uint8_t*>(m_file.Data());
+        m_size = static_cast<size_t>(m_file.Size());
+        if (!ReadStreamHeader(0)) {
+            return false;
+        }
+
+        // A file holding a single block has nothing to decode in parallel
+        if (m_threadCount > 1 && m_size > Bzip2BlockDecoder::MaxBlockSize) {
+            m_pool = std::make_unique<ThreadPool>(m_threadCount);
+        }
+        return true;
+    }
+
+    bool Bzip2ArchiveSource::ReadStreamHeader(size_t offset) {
+        // "BZh" and the block size in units of 100 000 bytes
+        if (m_size < offset + 4 || std::memcmp(m_data + offset, "BZh", 3) != 0 ||
+            m_data[offset + 3] < '1' || m_data[offset + 3] > '9') {
+            return false;
+        }
+        m_blockSizeLimit = (m_data[offset + 3] - '0') * 100000u;
+        m_streamCrc = 0;
+        m_expectedBit = uint64_t(offset + 4) * 8;
+        return true;
+    }
+
+    bool Bzip2ArchiveSource::AtBlock() {
+        for (;;) {
+            Bzip2BitReader reader;
+            reader.SetInput(m_data, m_size, m_expectedBit);
+            uint64_t magic = uint64_t(reader.Read(24)) << 24;
+            magic |= reader.Read(24);
+            if (magic == Bzip2BlockMagic && !reader.Overread()) {
+                return true;
+            }
+
+            // End of stream: combined CRC of its blocks, then padding to a byte boundary
+            uint32_t crc = reader.Read(32);
+            if (magic != Bzip2EndMagic || reader.Overread() || crc != m_streamCrc) {
+                throw ExtractionException(L"corrupt or truncated bzip2 data");
+            }
+            size_t next = static_cast<size_t>((reader.Position() + 7) / 8);
+            m_inputPosition = next;
+
+            // Concatenated streams (as written by parallel compressors) follow directly;
+            // anything else is trailing garbage and ignored, as bzip2 does
+            if (next >= m_size || !ReadStreamHeader(next)) {
+                return false;
+            }
+        }
+    }
+
+    void Bzip2ArchiveSource::SubmitBlocks() {
+        size_t depth = 2 * size_t(m_pool->Size());
+        while (m_pending.size() < depth && !m_scanDone) {
+            uint64_t bit = FindBzip2Magic(m_data, m_size, std::max(m_scanBit, m_expectedBit), Bzip2BlockMagic);
+            if (bit == Bzip2NoPosition) {
+                m_scanDone = true;
+                break;
+            }
+            m_scanBit = bit + 48;
+
+            const uint8_t* data = m_data;
+            size_t size = m_size;
+            TraceRecorder* trace = m_trace;
+            const CancellationToken* cancellation = m_cancellation;
+            m_pending.push_back({ bit, m_pool->Submit([data, size, bit, trace, cancellation]() -> std::unique_ptr<Bzip2Block> {
+                if (cancellation && cancellation->IsCancelled()) {
+                    return nullptr;
+                }
+                // Work arrays are large; each pool thread keeps its own decoder
+                thread_local Bzip2BlockDecoder decoder;
+                TraceRecorder::Span span(trace, "decompress-block");
+                auto block = std::make_unique<Bzip2Block>();
+                if (!decoder.Decode(data, size, bit, *block)) {
+                    return nullptr;
+                }
+                span.AddBytes(block->data.size());
+                return block;
+            }) });
+        }
+    }
+
+    std::unique_ptr<Bzip2Block> Bzip2ArchiveSource::TakeBlock() {
+        if (m_pool) {
+            SubmitBlocks();
+            // Candidates before the expected position were magic-like data inside earlier blocks
+            while (!m_pending.empty() && m_pending.front().startBit < m_expectedBit) {
+                m_pending.pop_front();
+            }
+            if (!m_pending.empty() && m_pending.front().startBit == m_expectedBit) {
+                auto block = m_pending.front().block.get();
+                m_pending.pop_front();
+                SubmitBlocks();
+                return block;
+            }
+        }
+
+        TraceRecorder::Span span(m_trace, "decompress-block");
+        auto block = std::make_unique<Bzip2Block>();
+        if (!m_decoder.Decode(m_data, m_size, m_expectedBit, *block)) {
+            return nullptr;
+        }
+        span.AddBytes(block->data.size());
+        return block;
+    }
+
+    bool Bzip2ArchiveSource::NextBlock() {
+        if (m_finished) {
+            return false;
+        }
+        if (!AtBlock()) {
+            m_finished = true;
+            m_pending.clear();
+            return false;
+        }
+
+        // Blocks skipped after cancellation come back empty
+        auto block = Cancelled() ? nullptr : TakeBlock();
+        if (Cancelled()) {
+            m_finished = true;
+            m_pending.clear();
+            return false;
+        }
+        if (!block || block->symbolCount > m_blockSizeLimit) {
+            throw ExtractionException(L"corrupt or truncated bzip2 data");
+        }
+        m_streamCrc = ((m_streamCrc << 1) | (m_streamCrc >> 31)) ^ block->crc;
+        m_expectedBit = block->endBit;
+        m_inputPosition = block->endBit / 8;
+
+        m_current = std::move(block);
+        m_cursor = m_current->data.data();
+        m_cursorEnd = m_cursor + m_current->data.size();
+        return true;
+    }
+
+    bool Bzip2ArchiveSource::Advance() {
+        while (m_cursor == m_cursorEnd) {
+            if (!NextBlock()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const char* Bzip2ArchiveSource::ReadBlock(size_t length) {
+        if (!Advance()) {
+            return nullptr;
+        }
+        if (static_cast<size_t>(m_cursorEnd - m_cursor) >= length) {
+            const char* block = reinterpret_cast<const char*>(m_cursor);
+            m_cursor += length;
+            m_position += length;
+            return block;
+        }
+
+        // The block straddles two bzip2 blocks
+        m_stitch.resize(length);
+        size_t copied = 0;
+        while (copied < length) {
+            if (!Advance()) {
+                return nullptr;
+            }
+            size_t count = std::min(length - copied, static_cast<size_t>(m_cursorEnd - m_cursor));
+            std::memcpy(m_stitch.data() + copied, m_cursor, count);
+            m_cursor += count;
+            copied += count;
+        }
+        m_position += length;
+        return m_stitch.data();
+    }
+
+    size_t Bzip2ArchiveSource::Read(const char*& data, size_t maxLength) {
+        if (!Advance()) {
+            return 0;
+        }
+        size_t length = std::min(maxLength, static_cast<size_t>(m_cursorEnd - m_cursor));
+        data = reinterpret_cast<const char*>(m_cursor);
+        m_cursor += length;
+        m_position += length;
+        return length;
+    }
+
+    bool Bzip2ArchiveSource::Skip(uint64_t length) {
+        while (length > 0) {
+            if (!Advance()) {
+                return false;
+            }
+            size_t skipped = static_cast<size_t>(std::min<uint64_t>(length, m_cursorEnd - m_cursor));
+            m_cursor += skipped;
+            m_position += skipped;
+            length -= skipped;
+        }
+        return true;
+    }
+
+    std::unique_ptr<IArchiveSource> OpenBzip2Source(const std::wstring& filePath, unsigned threadCount) {
+        auto source = std::make_unique<Bzip2ArchiveSource>(threadCount);
+        if (!source->Open(filePath)) {
+            return nullptr;
+        }
+        return source;
+    }
+
+    // Bzip2Extractor implementation
+    bool Bzip2Extractor::GetArchiveInfo(const std::wstring& filePath, std::vector<ArchiveEntry>& entries) const {
+        entries.clear();
+
+        MappedFile file;
+        if (!file.Open(filePath) || file.Size() < 4 || std::memcmp(file.Data(), "BZh", 3) != 0) {
+            return false;
+        }
+
+        // bzip2 records neither the uncompressed size nor a timestamp
+        ArchiveEntry entry;
+        entry.name = GetOutputName(filePath);
+        entry.size = 0;
+        entry.compressedSize = file.Size();
+        entry.isDirectory = false;
+        entry.lastModified = 0;
+        entry.permissions = 0644;
+        entries.push_back(entry);
+        return true;
+    }
+
+    std::wstring Bzip2Extractor::GetExtractorName() const {
+        return L"BZIP2 Extractor";
+    }
+
+    std::unique_ptr<IArchiveSource> Bzip2Extractor::OpenSource(const std::wstring& filePath,
+                                                               const ExtractionOptions& options) const {
+        return OpenBzip2Source(filePath, options.decompressionThreads);
+    }
+
+    // TarBzip2Extractor implementation
+    bool TarBzip2Extractor::CanExtract(const std::wstring& filePath) const {
+        std::wstring extension = Utils::ToLowerCase(Utils::GetFileExtension(filePath));
+        return extension == L".tar.bz2" || extension == L".tbz2";
+    }
+
+    ExtractionResult TarBzip2Extractor::Extract(
+        const std::wstring& archivePath,
+        const std::wstring& destinationPath,
+        const ExtractionOptions& options,
+        ProgressCallback callback) const {
+        // A size pre-scan would decode the whole archive twice
+        ExtractionOptions singlePassOptions = options;
+        singlePassOptions.singlePass = true;
+        return TarExtractor::Extract(archivePath, destinationPath, singlePassOptions, callback);
+    }
+
+    std::vector<std::wstring> TarBzip2Extractor::GetSupportedExtensions() const {
+        return { L".tar.bz2", L".tbz2" };
+    }
+
+    std::wstring TarBzip2Extractor::GetExtractorName() const {
+        return L"TAR.BZ2 Extractor";
+    }
+
+    std::unique_ptr<IArchiveSource> TarBzip2Extractor::OpenSource(const std::wstring& filePath,
+                                                                  const ExtractionOptions& options) const {
+        return OpenBzip2Source(filePath, options.decompressionThreads);
+    }
+
+} // namespace ArchiveEngine
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "ArchiveExtractor.h"
+#include "ArchiveSource.h"
+#include "Bzip2.h"
+#include "SingleFileExtractor.h"
+#include "TarExtractor.h"
+#include "ThreadPool.h"
+#include <deque>
+#include <future>
+
+namespace ArchiveEngine {
+
+    // Archive source that decodes a memory-mapped bzip2 file block by block.
+    //
+    // Stream headers and trailers are walked in order on the reading thread. With more
+    // than one thread, block magics are located ahead of the reader and those blocks
+    // are decoded on a pool. A block is only used if it starts exactly where the previous
+    // one ended, so magic-like bit patterns inside compressed data never reach the output.
+    class Bzip2ArchiveSource : public IArchiveSource {
+    public:
+        explicit Bzip2ArchiveSource(unsigned threadCount = 1);
+        ~Bzip2ArchiveSource() override;
+
+        bool Open(const std::wstring& filePath);
+
+        const char* ReadBlock(size_t length) override;
+        size_t Read(const char*& data, size_t maxLength) override;
+        bool Skip(uint64_t length) override;
+        uint64_t Position() const override { return m_position; }
+        uint64_t InputPosition() const override { return m_inputPosition; }
+
+    private:
+        struct PendingBlock {
+            uint64_t startBit;
+            std::future<std::unique_ptr<Bzip2Block>> block;
+        };
+
+        bool Advance();
+        bool NextBlock();
+        bool AtBlock();
+        std::unique_ptr<Bzip2Block> TakeBlock();
+        void SubmitBlocks();
+        bool ReadStreamHeader(size_t offset);
+
+        MappedFile m_file;
+        const uint8_t* m_data = nullptr;
+        size_t m_size = 0;
+        unsigned m_threadCount;
+
+        // Verified stream state: where the next block or stream trailer starts
+        uint64_t m_expectedBit = 0;
+        uint32_t m_blockSizeLimit = 0;
+        uint32_t m_streamCrc = 0;
+        bool m_finished = false;
+        Bzip2BlockDecoder m_decoder;
+
+        // Blocks decoding on the pool, in file order
+        std::deque<PendingBlock> m_pending;
+        uint64_t m_scanBit = 0;
+        bool m_scanDone = false;
+
+        // Output of the current block
+        std::unique_ptr<Bzip2Block> m_current;
+        const uint8_t* m_cursor = nullptr;
+        const uint8_t* m_cursorEnd = nullptr;
+        std::vector<char> m_stitch;
+        uint64_t m_position = 0;
+        uint64_t m_inputPosition = 0;
+
+        // Declared last: workers are joined before the mapping goes away
+        std::unique_ptr<ThreadPool> m_pool;
+    };
+
+    // Opens a decoding source for a bzip2 file; 0 threads uses every hardware thread.
+    // The file is always mapped, as ExtractionOptions::readAheadWindow explains.
+    std::unique_ptr<IArchiveSource> OpenBzip2Source(const std::wstring& filePath, unsigned threadCount);
+
+    // Single-file bzip2 extractor (.bz2)
+    class Bzip2Extractor : public SingleFileExtractor {
+    public:
+        Bzip2Extractor() : SingleFileExtractor(L".bz2") {}
+        virtual ~Bzip2Extractor() = default;
+
+        using SingleFileExtractor::GetArchiveInfo;
+
+        // IArchiveExtractor implementation
+        bool GetArchiveInfo(const std::wstring& filePath, std::vector<ArchiveEntry>& entries) const override;
+        std::wstring GetExtractorName() const override;
+
+    protected:
+        std::unique_ptr<IArchiveSource> OpenSource(const std::wstring& filePath,
+                                                   const ExtractionOptions& options) const override;
+    };
+
+    // TAR extractor for bzip2-compressed archives (.tar.bz2, .tbz2)
+    class TarBzip2Extractor : public TarExtractor {
+    public:
+        using TarExtractor::Extract;
+
+        bool CanExtract(const std::wstring& filePath) const override;
+        ExtractionResult Extract(
+            const std::wstring& archivePath,
+            const std::wstring& destinationPath,
+            const ExtractionOptions& options,
+            ProgressCallback callback = nullptr) const override;
+        std::vector<std::wstring> GetSupportedExtensions() const override;
+        std::wstring GetExtractorName() const override;
+
+    protected:
+        std::unique_ptr<IArchiveSource> OpenSource(const std::wstring& filePath,
+                                                   const ExtractionOptions& options) const override;
+    };
+
+} // namespace ArchiveEngine
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <atomic>
+
+namespace ArchiveEngine {
+
+    // Flag that asks an extraction to stop, settable from any thread. The engine polls
+    // it between chunks of file data, decoded blocks and files, on every thread taking
+    // part, so work stops within a few milliseconds of Cancel().
+    class CancellationToken {
+    public:
+        void Cancel() { m_cancelled.store(true, std::memory_order_release); }
+        bool IsCancelled() const { return m_cancelled.load(std::memory_order_acquire); }
+
+        // Allows the token to be used for another extraction
+        void Reset() { m_cancelled.store(false, std::memory_order_release); }
+
+    private:
+        std::atomic<bool> m_cancelled{ false };
+    };
+
+} // namespace ArchiveEngine
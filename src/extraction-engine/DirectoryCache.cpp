@@ -0,0 +1,60 @@
+#include "DirectoryCache.h"
+#include <filesystem>
+
+namespace ArchiveEngine {
+
+    namespace {
+
+        // Lexically normal form without a trailing separator, so "a/b/", "a/./b" and
+        // "a/c/../b" share one key
+        std::wstring NormalizeDirectory(const std::filesystem::path& path) {
+            std::filesystem::path normal = path.lexically_normal();
+            if (!normal.has_filename() && normal.has_relative_path()) {
+                normal = normal.parent_path();
+            }
+            return normal.wstring();
+        }
+
+    } // namespace
+
+    DirectoryCache::DirectoryCache(const std::wstring& root) {
+        m_known.insert(NormalizeDirectory(root));
+    }
+
+    bool DirectoryCache::Create(const std::wstring& path) {
+        std::wstring normal = NormalizeDirectory(path);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return CreateNormalized(normal);
+    }
+
+    bool DirectoryCache::CreateParent(const std::wstring& filePath) {
+        std::filesystem::path parent = std::filesystem::path(filePath).lexically_normal().parent_path();
+        if (parent.empty()) {
+            return true;
+        }
+        return Create(parent.wstring());
+    }
+
+    bool DirectoryCache::CreateNormalized(const std::wstring& path) {
+        // Called with the lock held, so each directory is created by one thread only
+        if (m_known.count(path) != 0) {
+            return true;
+        }
+
+        std::filesystem::path directory(path);
+        std::filesystem::path parent = directory.parent_path();
+        if (!parent.empty() && parent != directory && !CreateNormalized(parent.wstring())) {
+            return false;
+        }
+
+        // One mkdir; an existing directory is fine, an existing file is not
+        std::error_code ec;
+        std::filesystem::create_directory(directory, ec);
+        if (ec) {
+            return false;
+        }
+        m_known.insert(path);
+        return true;
+    }
+
+} // namespace ArchiveEngine
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+namespace ArchiveEngine {
+
+    // Directories known to exist below an extraction root.
+    //
+    // Each directory is created (or found to exist already) with a single call the first
+    // time it is needed; after that it is answered from the cache without touching the
+    // file system. Missing ancestors are created one level at a time, stopping at the
+    // first one already known. Paths are keyed in lexically normalized form. Safe to use
+    // from several threads; one cache serves one extraction.
+    class DirectoryCache {
+    public:
+        // `root` must exist already; it and its ancestors are never created
+        explicit DirectoryCache(const std::wstring& root);
+
+        DirectoryCache(const DirectoryCache&) = delete;
+        DirectoryCache& operator=(const DirectoryCache&) = delete;
+
+        // Ensures the directory `path` exists; false if it cannot be created
+        bool Create(const std::wstring& path);
+
+        // Ensures the directory holding the file `filePath` exists
+        bool CreateParent(const std::wstring& filePath);
+
+    private:
+        bool CreateNormalized(const std::wstring& path);
+
+        std::mutex m_mutex;
+        std::unordered_set<std::wstring> m_known;
+    };
+
+} // namespace ArchiveEngine
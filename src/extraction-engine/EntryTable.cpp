@@ -0,0 +1,113 @@
+#include "EntryTable.h"
+#include <algorithm>
+
+namespace ArchiveEngine {
+
+    bool EntryTable::Read(const IArchiveExtractor& extractor, const std::wstring& filePath,
+                          const ExtractionOptions& options) {
+        Clear();
+        return extractor.VisitEntries(filePath, options, [this](const ArchiveEntryView& entry) {
+            Add(entry);
+            return true;
+        });
+    }
+
+    void EntryTable::Clear() {
+        m_arena.clear();
+        m_nameOffsets.clear();
+        m_nameLengths.clear();
+        m_linkLengths.clear();
+        m_sizes.clear();
+        m_compressedSizes.clear();
+        m_mtimes.clear();
+        m_permissions.clear();
+        m_flags.clear();
+        m_nameOrder.clear();
+    }
+
+    void EntryTable::Reserve(size_t entryCount, size_t nameBytes) {
+        m_arena.reserve(nameBytes);
+        m_nameOffsets.reserve(entryCount);
+        m_nameLengths.reserve(entryCount);
+        m_linkLengths.reserve(entryCount);
+        m_sizes.reserve(entryCount);
+        m_compressedSizes.reserve(entryCount);
+        m_mtimes.reserve(entryCount);
+        m_permissions.reserve(entryCount);
+        m_flags.reserve(entryCount);
+    }
+
+    void EntryTable::Add(const ArchiveEntryView& entry) {
+        m_nameOffsets.push_back(m_arena.size());
+        m_nameLengths.push_back(static_cast<uint32_t>(entry.name.size()));
+        m_linkLengths.push_back(static_cast<uint32_t>(entry.linkTarget.size()));
+        m_arena.append(entry.name);
+        m_arena.append(entry.linkTarget);
+        m_sizes.push_back(entry.size);
+        m_compressedSizes.push_back(entry.compressedSize);
+        m_mtimes.push_back(entry.lastModified);
+        m_permissions.push_back(entry.permissions);
+        m_flags.push_back(entry.isDirectory ? DirectoryFlag : 0);
+        m_nameOrder.clear();
+    }
+
+    std::string_view EntryTable::Name(size_t index) const {
+        return std::string_view(m_arena.data() + m_nameOffsets[index], m_nameLengths[index]);
+    }
+
+    std::string_view EntryTable::LinkTarget(size_t index) const {
+        return std::string_view(m_arena.data() + m_nameOffsets[index] + m_nameLengths[index], m_linkLengths[index]);
+    }
+
+    ArchiveEntryView EntryTable::View(size_t index) const {
+        ArchiveEntryView entry;
+        entry.name = Name(index);
+        entry.linkTarget = LinkTarget(index);
+        entry.size = m_sizes[index];
+        entry.compressedSize = m_compressedSizes[index];
+        entry.isDirectory = IsDirectory(index);
+        entry.lastModified = m_mtimes[index];
+        entry.permissions = m_permissions[index];
+        return entry;
+    }
+
+    size_t EntryTable::Find(std::string_view path) const {
+        BuildNameOrder();
+        auto it = std::upper_bound(m_nameOrder.begin(), m_nameOrder.end(), path,
+                                   [this](std::string_view value, uint32_t index) { return value < Name(index); });
+        if (it == m_nameOrder.begin() || Name(*(it - 1)) != path) {
+            return NotFound;
+        }
+        return *(it - 1);
+    }
+
+    std::pair<size_t, size_t> EntryTable::PrefixRange(std::string_view prefix) const {
+        BuildNameOrder();
+        auto first = std::lower_bound(m_nameOrder.begin(), m_nameOrder.end(), prefix,
+                                      [this](uint32_t index, std::string_view value) { return Name(index) < value; });
+        // Names starting with the prefix are contiguous from there on
+        auto last = std::upper_bound(first, m_nameOrder.end(), prefix,
+                                     [this](std::string_view value, uint32_t index) {
+                                         return value < Name(index).substr(0, value.size());
+                                     });
+        return { static_cast<size_t>(first - m_nameOrder.begin()), static_cast<size_t>(last - m_nameOrder.begin()) };
+    }
+
+    size_t EntryTable::SortedEntry(size_t position) const {
+        BuildNameOrder();
+        return m_nameOrder[position];
+    }
+
+    void EntryTable::BuildNameOrder() const {
+        if (m_nameOrder.size() == Count()) {
+            return;
+        }
+        m_nameOrder.resize(Count());
+        for (size_t i = 0; i < m_nameOrder.size(); ++i) {
+            m_nameOrder[i] = static_cast<uint32_t>(i);
+        }
+        std::stable_sort(m_nameOrder.begin(), m_nameOrder.end(),
+                         [this](uint32_t a, uint32_t b) { return Name(a) < Name(b); });
+    }
+
+} // namespace ArchiveEngine
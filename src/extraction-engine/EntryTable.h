@@ -0,0 +1,73 @@
+#pragma once
+
+#include "ArchiveExtractor.h"
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ArchiveEngine {
+
+    // Compact in-memory listing of an archive.
+    //
+    // Entries are stored column by column: all names and link targets share one arena
+    // and each attribute has its own array, so a listing costs a few dozen bytes per
+    // entry plus its name, and scans over one attribute touch only that column.
+    // Entry numbers are archive order. Lookups by name use a sorted permutation built by
+    // the first lookup after entries were added; share a table between threads only
+    // after that.
+    class EntryTable {
+    public:
+        static constexpr size_t NotFound = static_cast<size_t>(-1);
+
+        // Replaces the contents with the listing of `filePath`
+        bool Read(const IArchiveExtractor& extractor, const std::wstring& filePath,
+                  const ExtractionOptions& options = ExtractionOptions());
+
+        void Clear();
+        void Reserve(size_t entryCount, size_t nameBytes);
+        void Add(const ArchiveEntryView& entry);
+
+        size_t Count() const { return m_sizes.size(); }
+        std::string_view Name(size_t index) const;
+        std::string_view LinkTarget(size_t index) const;
+        uint64_t FileSize(size_t index) const { return m_sizes[index]; }
+        uint64_t CompressedSize(size_t index) const { return m_compressedSizes[index]; }
+        uint64_t LastModified(size_t index) const { return m_mtimes[index]; }
+        uint32_t Permissions(size_t index) const { return m_permissions[index]; }
+        bool IsDirectory(size_t index) const { return (m_flags[index] & DirectoryFlag) != 0; }
+        ArchiveEntryView View(size_t index) const;
+
+        // Whole columns, indexed by entry number
+        const std::vector<uint64_t>& FileSizes() const { return m_sizes; }
+        const std::vector<uint64_t>& LastModifiedTimes() const { return m_mtimes; }
+        const std::vector<uint32_t>& PermissionBits() const { return m_permissions; }
+
+        // Entry with exactly this name, or NotFound. When a name occurs more than once the
+        // last entry (the one extraction keeps) wins.
+        size_t Find(std::string_view path) const;
+
+        // Positions [first, last) in name order of the entries whose name starts with
+        // `prefix`; SortedEntry maps a position to its entry number
+        std::pair<size_t, size_t> PrefixRange(std::string_view prefix) const;
+        size_t SortedEntry(size_t position) const;
+
+    private:
+        static constexpr uint8_t DirectoryFlag = 1;
+
+        void BuildNameOrder() const;
+
+        std::string m_arena;                   // Each name followed by its link target
+        std::vector<uint64_t> m_nameOffsets;
+        std::vector<uint32_t> m_nameLengths;
+        std::vector<uint32_t> m_linkLengths;
+        std::vector<uint64_t> m_sizes;
+        std::vector<uint64_t> m_compressedSizes;
+        std::vector<uint64_t> m_mtimes;
+        std::vector<uint32_t> m_permissions;
+        std::vector<uint8_t> m_flags;
+
+        mutable std::vector<uint32_t> m_nameOrder;  // Entry numbers sorted by name, stable
+    };
+
+} // namespace ArchiveEngine
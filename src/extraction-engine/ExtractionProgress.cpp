@@ -0,0 +1,66 @@
+#include "ExtractionProgress.h"
+
+namespace ArchiveEngine {
+
+    // ExtractionProgress implementation
+    ProgressSnapshot ExtractionProgress::Snapshot() const {
+        ProgressSnapshot snapshot;
+        snapshot.current = m_current.load(std::memory_order_relaxed);
+        snapshot.total = m_total.load(std::memory_order_relaxed);
+        snapshot.entries = m_entries.load(std::memory_order_relaxed);
+        snapshot.phase = static_cast<ProgressPhase>(m_phase.load(std::memory_order_relaxed));
+        return snapshot;
+    }
+
+    void ExtractionProgress::Reset() {
+        m_current.store(0, std::memory_order_relaxed);
+        m_total.store(0, std::memory_order_relaxed);
+        m_entries.store(0, std::memory_order_relaxed);
+        SetPhase(ProgressPhase::Preparing);
+        m_nextPublish.store(0, std::memory_order_relaxed);
+    }
+
+    void ExtractionProgress::Subscribe(Listener listener, std::chrono::milliseconds interval) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_listener = std::move(listener);
+        m_interval = interval;
+        m_nextPublish.store(0, std::memory_order_relaxed);
+        m_subscribed.store(static_cast<bool>(m_listener), std::memory_order_release);
+    }
+
+    void ExtractionProgress::Unsubscribe() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_subscribed.store(false, std::memory_order_release);
+        m_listener = nullptr;
+    }
+
+    void ExtractionProgress::Publish() {
+        if (!m_subscribed.load(std::memory_order_acquire)) {
+            return;
+        }
+        Clock::rep now = Clock::now().time_since_epoch().count();
+        if (now < m_nextPublish.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        // Threads arriving together deliver one snapshot between them
+        std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
+        if (!lock.owns_lock() || !m_listener || now < m_nextPublish.load(std::memory_order_relaxed)) {
+            return;
+        }
+        m_nextPublish.store(now + m_interval.count(), std::memory_order_relaxed);
+        m_listener(Snapshot());
+    }
+
+    void ExtractionProgress::Finish() {
+        SetPhase(ProgressPhase::Done);
+        if (!m_subscribed.load(std::memory_order_acquire)) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_listener) {
+            m_listener(Snapshot());
+        }
+    }
+
+} // namespace ArchiveEngine
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+namespace ArchiveEngine {
+
+    // Stage an extraction is in
+    enum class ProgressPhase : uint8_t {
+        Preparing,      // Opening the archive and the destination
+        Scanning,       // Reading the archive once for its uncompressed total
+        Extracting,
+        Finishing,      // Waiting for files still being written in the background
+        Done            // Extract has returned or is about to; its result tells how it ended
+    };
+
+    struct ProgressSnapshot {
+        uint64_t current = 0;   // Progress so far, in the unit of `total` (as ProgressCallback)
+        uint64_t total = 0;
+        uint64_t entries = 0;   // Entries extracted so far
+        ProgressPhase phase = ProgressPhase::Preparing;
+    };
+
+    // Progress of one extraction, kept in atomic counters the engine updates without
+    // locking from whichever thread does the work. Other threads can poll Snapshot() at
+    // any time, or subscribe to have snapshots delivered at a bounded rate.
+    class ExtractionProgress {
+    public:
+        using Clock = std::chrono::steady_clock;
+        using Listener = std::function<void(const ProgressSnapshot&)>;
+
+        ExtractionProgress() = default;
+
+        ExtractionProgress(const ExtractionProgress&) = delete;
+        ExtractionProgress& operator=(const ExtractionProgress&) = delete;
+
+        ProgressSnapshot Snapshot() const;
+
+        // Calls `listener` with a snapshot at most once per `interval`, and once more when
+        // the phase becomes Done. It runs on a thread doing the extraction, which waits
+        // for it, and must neither throw nor subscribe. Replaces any earlier listener.
+        void Subscribe(Listener listener, std::chrono::milliseconds interval);
+        void Unsubscribe();
+
+        // Engine side. Reset() starts over for a new extraction.
+        void Reset();
+        void SetPhase(ProgressPhase phase) { m_phase.store(static_cast<uint8_t>(phase), std::memory_order_relaxed); }
+        void SetTotal(uint64_t total) { m_total.store(total, std::memory_order_relaxed); }
+        void SetCurrent(uint64_t current) { m_current.store(current, std::memory_order_relaxed); }
+        void AddEntry() { m_entries.fetch_add(1, std::memory_order_relaxed); }
+
+        // Hands the listener a snapshot if one is due; one relaxed load without a listener
+        void Publish();
+
+        // Sets the phase to Done and hands the listener its last snapshot
+        void Finish();
+
+    private:
+        std::atomic<uint64_t> m_current{ 0 };
+        std::atomic<uint64_t> m_total{ 0 };
+        std::atomic<uint64_t> m_entries{ 0 };
+        std::atomic<uint8_t> m_phase{ static_cast<uint8_t>(ProgressPhase::Preparing) };
+
+        std::atomic<bool> m_subscribed{ false };
+        std::atomic<Clock::rep> m_nextPublish{ 0 };  // Clock ticks; earlier calls to Publish do nothing
+        std::mutex m_mutex;  // Guards the listener and its interval
+        Listener m_listener;
+        Clock::duration m_interval{};
+    };
+
+    // Finishes a progress however the scope holding it is left
+    class ProgressFinisher {
+    public:
+        explicit ProgressFinisher(ExtractionProgress& progress) : m_progress(progress) {}
+        ~ProgressFinisher() { m_progress.Finish(); }
+
+        ProgressFinisher(const ProgressFinisher&) = delete;
+        ProgressFinisher& operator=(const ProgressFinisher&) = delete;
+
+    private:
+        ExtractionProgress& m_progress;
+    };
+
+    // Rate limit for progress reports from a single thread: Due() is true on its first
+    // call and then at most once per interval. A zero interval is always due and never
+    // reads the clock.
+    class ProgressThrottle {
+    public:
+        explicit ProgressThrottle(std::chrono::milliseconds interval) : m_interval(interval) {}
+
+        bool Due() {
+            if (m_interval.count() == 0) {
+                return true;
+            }
+            ExtractionProgress::Clock::time_point now = ExtractionProgress::Clock::now();
+            if (now < m_next) {
+                return false;
+            }
+            m_next = now + m_interval;
+            return true;
+        }
+
+    private:
+        ExtractionProgress::Clock::duration m_interval;
+        ExtractionProgress::Clock::time_point m_next{};
+    };
+
+} // namespace ArchiveEngine
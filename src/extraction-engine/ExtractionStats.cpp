@@ -0,0 +1,135 @@
+#include "ExtractionStats.h"
+#include <algorithm>
+
+namespace ArchiveEngine {
+
+    namespace {
+
+        thread_local uint64_t t_systemCalls = 0;
+
+        const char* const PhaseNames[] = {
+            "read-header", "validate-path", "create-directory", "open-file", "queue-data", "write-data", "close-file"
+        };
+        static_assert(sizeof(PhaseNames) / sizeof(PhaseNames[0]) == static_cast<size_t>(ExtractionPhase::Count),
+                      "every phase needs a name");
+
+    } // namespace
+
+    uint64_t ThreadSystemCalls() {
+        return t_systemCalls;
+    }
+
+    void CountSystemCalls(uint64_t count) {
+        t_systemCalls += count;
+    }
+
+    const char* ExtractionStats::PhaseName(ExtractionPhase phase) {
+        return phase < ExtractionPhase::Count ? PhaseNames[static_cast<size_t>(phase)] : "";
+    }
+
+    // ExtractionStatsRecorder implementation
+    ExtractionStatsRecorder::ExtractionStatsRecorder() {
+        for (auto& bucket : m_latency) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void ExtractionStatsRecorder::Add(ExtractionPhase phase, uint64_t nanoseconds, uint64_t bytes, uint64_t systemCalls) {
+        PhaseCounters& counters = m_phases[static_cast<size_t>(phase)];
+        counters.nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+        counters.count.fetch_add(1, std::memory_order_relaxed);
+        counters.bytes.fetch_add(bytes, std::memory_order_relaxed);
+        counters.systemCalls.fetch_add(systemCalls, std::memory_order_relaxed);
+    }
+
+    void ExtractionStatsRecorder::AddFileLatency(uint64_t nanoseconds) {
+        m_latency[BucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t current = m_minLatency.load(std::memory_order_relaxed);
+        while (nanoseconds < current && !m_minLatency.compare_exchange_weak(current, nanoseconds, std::memory_order_relaxed)) {
+        }
+        current = m_maxLatency.load(std::memory_order_relaxed);
+        while (nanoseconds > current && !m_maxLatency.compare_exchange_weak(current, nanoseconds, std::memory_order_relaxed)) {
+        }
+    }
+
+    unsigned ExtractionStatsRecorder::BucketOf(uint64_t nanoseconds) {
+        // Values below SubBuckets get a bucket each; above, the three bits after the
+        // leading one pick the sub-bucket within its power of two
+        if (nanoseconds < SubBuckets) {
+            return static_cast<unsigned>(nanoseconds);
+        }
+        unsigned exponent = 63;
+        while (!(nanoseconds >> exponent)) {
+            --exponent;
+        }
+        unsigned sub = static_cast<unsigned>((nanoseconds >> (exponent - 3)) & (SubBuckets - 1));
+        return std::min(BucketCount - 1, (exponent - 2) * SubBuckets + sub);
+    }
+
+    uint64_t ExtractionStatsRecorder::BucketLimit(unsigned bucket) {
+        // Largest value that falls into `bucket`
+        if (bucket < SubBuckets) {
+            return bucket;
+        }
+        unsigned exponent = bucket / SubBuckets + 2;
+        uint64_t sub = bucket % SubBuckets;
+        return ((SubBuckets + sub + 1) << (exponent - 3)) - 1;
+    }
+
+    void ExtractionStatsRecorder::Fill(ExtractionStats& stats) const {
+        for (size_t i = 0; i < static_cast<size_t>(ExtractionPhase::Count); ++i) {
+            stats.phases[i].nanoseconds = m_phases[i].nanoseconds.load(std::memory_order_relaxed);
+            stats.phases[i].count = m_phases[i].count.load(std::memory_order_relaxed);
+            stats.phases[i].bytes = m_phases[i].bytes.load(std::memory_order_relaxed);
+            stats.phases[i].systemCalls = m_phases[i].systemCalls.load(std::memory_order_relaxed);
+        }
+
+        FileLatencyStats& latency = stats.fileLatency;
+        latency = FileLatencyStats();
+        uint64_t counts[BucketCount];
+        for (unsigned i = 0; i < BucketCount; ++i) {
+            counts[i] = m_latency[i].load(std::memory_order_relaxed);
+            latency.files += counts[i];
+        }
+        if (latency.files == 0) {
+            return;
+        }
+        latency.minNanoseconds = m_minLatency.load(std::memory_order_relaxed);
+        latency.maxNanoseconds = m_maxLatency.load(std::memory_order_relaxed);
+
+        // Each percentile is the upper end of the bucket holding it, within the observed range
+        auto percentile = [&](uint64_t permille) {
+            uint64_t rank = (latency.files * permille + 999) / 1000;
+            uint64_t seen = 0;
+            for (unsigned i = 0; i < BucketCount; ++i) {
+                seen += counts[i];
+                if (seen >= rank) {
+                    return std::clamp(BucketLimit(i), latency.minNanoseconds, latency.maxNanoseconds);
+                }
+            }
+            return latency.maxNanoseconds;
+        };
+        latency.p50Nanoseconds = percentile(500);
+        latency.p90Nanoseconds = percentile(900);
+        latency.p99Nanoseconds = percentile(990);
+    }
+
+    // Scope implementation
+    ExtractionStatsRecorder::Scope::Scope(ExtractionStatsRecorder* recorder, ExtractionPhase phase, uint64_t bytes)
+        : m_recorder(recorder), m_phase(phase), m_bytes(bytes) {
+        if (m_recorder) {
+            m_systemCalls = t_systemCalls;
+            m_start = Clock::now();
+        }
+    }
+
+    ExtractionStatsRecorder::Scope::~Scope() {
+        if (m_recorder) {
+            uint64_t nanoseconds = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start).count());
+            m_recorder->Add(m_phase, nanoseconds, m_bytes, t_systemCalls - m_systemCalls);
+        }
+    }
+
+} // namespace ArchiveEngine
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+namespace ArchiveEngine {
+
+    // Stages of extracting an entry, timed separately
+    enum class ExtractionPhase {
+        ReadHeader,       // Decoding headers, including long name and PAX records
+        ValidatePath,     // Checking and sanitizing the entry path
+        MakeDirectory,    // Directory entries; parents of files count toward OpenFile. Named
+                          // "create-directory"; CreateDirectory is a macro in <windows.h>
+        OpenFile,         // Creating output files
+        QueueData,        // Handing payloads to writer threads or io_uring batches, including waits and
+                          // batch flushes made inline
+        WriteData,        // Writing payloads out, including io_uring batches
+        CloseFile,        // Final size, permissions, timestamps and close
+        Count
+    };
+
+    // Cumulative cost of one phase across all threads
+    struct PhaseStats {
+        uint64_t nanoseconds = 0;
+        uint64_t count = 0;        // Times the phase ran
+        uint64_t bytes = 0;        // Archive bytes decoded or file bytes written
+        uint64_t systemCalls = 0;  // Made by the engine's own file code; POSIX only
+    };
+
+    // Time from opening an output file to closing it, per file. Percentiles come from a
+    // logarithmic histogram and are accurate to within 1/8 of the value.
+    struct FileLatencyStats {
+        uint64_t files = 0;
+        uint64_t minNanoseconds = 0;
+        uint64_t maxNanoseconds = 0;
+        uint64_t p50Nanoseconds = 0;
+        uint64_t p90Nanoseconds = 0;
+        uint64_t p99Nanoseconds = 0;
+    };
+
+    struct ExtractionStats {
+        PhaseStats phases[static_cast<size_t>(ExtractionPhase::Count)];
+        FileLatencyStats fileLatency;  // Files written one at a time; io_uring batches are not included
+
+        const PhaseStats& Phase(ExtractionPhase phase) const { return phases[static_cast<size_t>(phase)]; }
+        static const char* PhaseName(ExtractionPhase phase);
+    };
+
+    // Collects ExtractionStats from any number of threads with relaxed atomic counters;
+    // nothing is locked and nothing allocated while extracting
+    class ExtractionStatsRecorder {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        ExtractionStatsRecorder();
+
+        ExtractionStatsRecorder(const ExtractionStatsRecorder&) = delete;
+        ExtractionStatsRecorder& operator=(const ExtractionStatsRecorder&) = delete;
+
+        void Add(ExtractionPhase phase, uint64_t nanoseconds, uint64_t bytes, uint64_t systemCalls);
+        void AddFileLatency(uint64_t nanoseconds);
+
+        // Snapshot of everything recorded so far
+        void Fill(ExtractionStats& stats) const;
+
+        // Times one run of a phase on the calling thread, counting the system calls it
+        // makes. Does nothing without a recorder.
+        class Scope {
+        public:
+            Scope(ExtractionStatsRecorder* recorder, ExtractionPhase phase, uint64_t bytes = 0);
+            ~Scope();
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+            void AddBytes(uint64_t bytes) { m_bytes += bytes; }
+
+        private:
+            ExtractionStatsRecorder* m_recorder;
+            ExtractionPhase m_phase;
+            uint64_t m_bytes;
+            uint64_t m_systemCalls = 0;
+            Clock::time_point m_start;
+        };
+
+    private:
+        struct PhaseCounters {
+            std::atomic<uint64_t> nanoseconds{ 0 };
+            std::atomic<uint64_t> count{ 0 };
+            std::atomic<uint64_t> bytes{ 0 };
+            std::atomic<uint64_t> systemCalls{ 0 };
+        };
+
+        // Eight buckets per power of two, up to 2^50 ns (about thirteen days)
+        static constexpr unsigned SubBuckets = 8;
+        static constexpr unsigned BucketCount = 48 * SubBuckets;
+
+        static unsigned BucketOf(uint64_t nanoseconds);
+        static uint64_t BucketLimit(unsigned bucket);
+
+        PhaseCounters m_phases[static_cast<size_t>(ExtractionPhase::Count)];
+        std::atomic<uint64_t> m_latency[BucketCount];
+        std::atomic<uint64_t> m_minLatency{ UINT64_MAX };
+        std::atomic<uint64_t> m_maxLatency{ 0 };
+    };
+
+    // System calls made so far by the calling thread, as counted at the call sites
+    uint64_t ThreadSystemCalls();
+    void CountSystemCalls(uint64_t count = 1);
+
+} // namespace ArchiveEngine
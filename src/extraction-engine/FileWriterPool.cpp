@@ -0,0 +1,200 @@
+#include "FileWriterPool.h"
+
+namespace ArchiveEngine {
+
+    FileWriterPool::FileWriterPool(unsigned threadCount, size_t memoryBudget, OutputTree& output)
+        : m_output(output), m_memoryBudget(memoryBudget) {
+        if (threadCount == 0) {
+            threadCount = 1;
+        }
+        m_threads.reserve(threadCount);
+        for (unsigned i = 0; i < threadCount; ++i) {
+            m_threads.emplace_back(&FileWriterPool::WorkerLoop, this);
+        }
+    }
+
+    FileWriterPool::~FileWriterPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_work.notify_all();
+        m_data.notify_all();
+        m_closed.notify_all();
+        for (auto& thread : m_threads) {
+            thread.join();
+        }
+
+        // Files never claimed by a writer were not opened
+        for (const auto& job : m_jobs) {
+            m_output.NoteFile(job->name, FileOutcome::Dropped);
+        }
+    }
+
+    void FileWriterPool::BeginFile(const std::wstring& path, const std::wstring& name,
+                                   const OutputFileAttributes& attributes) {
+        auto job = std::make_shared<FileJob>();
+        job->path = path;
+        job->name = name;
+        job->attributes = attributes;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::shared_ptr<FileJob>& last = m_lastJobs[path];
+            job->previous = std::move(last);
+            last = job;
+            m_current = job;
+            m_jobs.push_back(std::move(job));
+            ++m_openJobs;
+        }
+        m_work.notify_one();
+    }
+
+    void FileWriterPool::Write(uint64_t offset, const char* data, size_t length) {
+        Chunk chunk = { offset, std::vector<char>(data, data + length) };
+        {
+            // A chunk larger than the whole budget still goes through once the queue is empty
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_space.wait(lock, [&] {
+                return m_queuedBytes == 0 || m_queuedBytes + length <= m_memoryBudget || m_failed;
+            });
+            m_queuedBytes += length;
+            m_current->chunks.push_back(std::move(chunk));
+        }
+        m_data.notify_all();
+    }
+
+    void FileWriterPool::Copy(int descriptor, uint64_t sourceOffset, uint64_t offset, uint64_t length) {
+        Chunk chunk;
+        chunk.offset = offset;
+        chunk.descriptor = descriptor;
+        chunk.sourceOffset = sourceOffset;
+        chunk.copyLength = length;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_current->chunks.push_back(std::move(chunk));
+        }
+        m_data.notify_all();
+    }
+
+    void FileWriterPool::EndFile(uint64_t fileSize) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_current->fileSize = fileSize;
+            m_current->complete = true;
+            m_current.reset();
+        }
+        m_data.notify_all();
+    }
+
+    void FileWriterPool::WaitFor(const std::wstring& path) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_closed.wait(lock, [&] { return m_stopping || m_lastJobs.count(path) == 0; });
+    }
+
+    bool FileWriterPool::Failed() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_failed;
+    }
+
+    bool FileWriterPool::Finish(std::wstring& failedName) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_space.wait(lock, [&] { return m_openJobs == 0; });
+        failedName = m_failedName;
+        return !m_failed;
+    }
+
+    void FileWriterPool::WorkerLoop() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_work.wait(lock, [&] { return m_stopping || !m_jobs.empty(); });
+            if (m_stopping) {
+                return;
+            }
+            std::shared_ptr<FileJob> job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+
+            // An earlier file at the same path was claimed first and has all its data
+            // queued, so waiting for it never holds up the reader
+            if (job->previous) {
+                m_closed.wait(lock, [&] { return m_stopping || job->previous->closed; });
+                job->previous.reset();
+            }
+            if (m_stopping) {
+                m_output.NoteFile(job->name, FileOutcome::Dropped);
+                return;
+            }
+
+            bool written = WriteFile(*job, lock);
+            if (m_stopping) {
+                return;
+            }
+            if (!written && !m_failed) {
+                m_failed = true;
+                m_failedName = job->name;
+            }
+            job->closed = true;
+            auto last = m_lastJobs.find(job->path);
+            if (last != m_lastJobs.end() && last->second == job) {
+                m_lastJobs.erase(last);
+            }
+            --m_openJobs;
+            m_closed.notify_all();
+            m_space.notify_one();
+        }
+    }
+
+    bool FileWriterPool::WriteFile(FileJob& job, std::unique_lock<std::mutex>& lock) {
+        // Called and returns with the lock held; file system calls run without it
+        lock.unlock();
+        OutputFile outputFile;
+        bool attempted = !m_output.Cancelled();
+        bool ok = attempted && m_output.OpenFile(job.path, job.attributes, outputFile);
+        lock.lock();
+
+        for (;;) {
+            m_data.wait(lock, [&] { return m_stopping || !job.chunks.empty() || job.complete; });
+            if (m_stopping || job.chunks.empty()) {
+                break;
+            }
+            Chunk chunk = std::move(job.chunks.front());
+            job.chunks.pop_front();
+
+            // Data of a file that failed to open is still drained so the reader can go on
+            lock.unlock();
+            size_t length = chunk.data.size();
+            if (ok && m_output.Cancelled()) {
+                ok = false;
+            }
+            if (ok) {
+                ok = chunk.descriptor >= 0
+                    ? outputFile.CopyFrom(chunk.descriptor, chunk.sourceOffset, chunk.offset, chunk.copyLength)
+                    : outputFile.Write(chunk.offset, chunk.data.data(), length);
+            }
+            chunk.data = std::vector<char>();
+            lock.lock();
+
+            m_queuedBytes -= length;
+            m_space.notify_one();
+        }
+
+        // Every chunk has been written unless the pool is stopping; a file that failed to
+        // write is closed as it is, a complete one gets its size and metadata
+        bool complete = !m_stopping;
+        lock.unlock();
+        if (!complete || m_output.Cancelled()) {
+            // A file not closed by the time the extraction stops or is cancelled is not
+            // left cut short, nor extended to its size with zeros
+            if (outputFile.IsOpen()) {
+                m_output.RemoveFile(job.path, outputFile);
+            }
+            ok = false;
+        } else if (ok) {
+            ok = outputFile.Close(job.fileSize);
+        }
+        // Noted before the file counts as closed, so later copies of its name are noted after it
+        m_output.NoteFile(job.name, ok ? FileOutcome::Written : attempted ? FileOutcome::Lost : FileOutcome::Dropped);
+        lock.lock();
+        return ok;
+    }
+
+} // namespace ArchiveEngine
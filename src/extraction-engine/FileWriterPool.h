@@ -0,0 +1,105 @@
+#pragma once
+
+#include "OutputTree.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ArchiveEngine {
+
+    // Writes extracted files on background threads so that creating, writing and
+    // closing outputs overlaps with reading the archive.
+    //
+    // The reading thread hands over one file at a time as a sequence of owned buffers,
+    // each placed at an offset in the file; gaps between them are left as holes.
+    // Each file is opened, written in order and closed by a single writer; files are
+    // claimed in the order they were begun. A file whose path is still being written by
+    // another writer waits for that file to close, so the last copy of a path wins.
+    // Queued data is capped by a memory budget: Write blocks until the writers have
+    // drained enough of it. Once the output tree's extraction is cancelled, writers drop
+    // their data and remove files not yet closed.
+    class FileWriterPool {
+    public:
+        // Files are created through `output`, which must outlive the pool
+        FileWriterPool(unsigned threadCount, size_t memoryBudget, OutputTree& output);
+        ~FileWriterPool();  // Drops files not yet written, removes those cut short and joins the writers
+
+        FileWriterPool(const FileWriterPool&) = delete;
+        FileWriterPool& operator=(const FileWriterPool&) = delete;
+
+        // Starts the next output file; `name` identifies it in error reports. The writer
+        // creates the parent directory and opens the file with `attributes`.
+        void BeginFile(const std::wstring& path, const std::wstring& name, const OutputFileAttributes& attributes);
+
+        // Queues a copy of `length` bytes to be written at `offset` in the current file.
+        // Offsets increase from one call to the next.
+        void Write(uint64_t offset, const char* data, size_t length);
+
+        // Queues `length` bytes to be copied from the open file `descriptor` at
+        // `sourceOffset` to `offset` in the current file (see OutputFile::CopyFrom).
+        // Nothing is buffered; the descriptor must stay open until Finish.
+        void Copy(int descriptor, uint64_t sourceOffset, uint64_t offset, uint64_t length);
+
+        // Marks the current file complete; it is extended to `fileSize` if shorter
+        void EndFile(uint64_t fileSize);
+
+        // Waits until every begun file at `path` is closed, so that the path can be
+        // written by other means after them
+        void WaitFor(const std::wstring& path);
+
+        // True once any file has failed to be written
+        bool Failed() const;
+
+        // Waits until every begun file is closed. Returns false and the name of the
+        // first file that could not be written if any failed.
+        bool Finish(std::wstring& failedName);
+
+    private:
+        struct Chunk {
+            uint64_t offset;
+            std::vector<char> data;
+            int descriptor = -1;        // Copied from this file instead when set
+            uint64_t sourceOffset = 0;
+            uint64_t copyLength = 0;
+        };
+
+        struct FileJob {
+            std::wstring path;
+            std::wstring name;
+            std::deque<Chunk> chunks;
+            OutputFileAttributes attributes;
+            uint64_t fileSize = 0;
+            bool complete = false;
+            bool closed = false;
+            std::shared_ptr<FileJob> previous;  // Earlier file at the same path, if still open
+        };
+
+        void WorkerLoop();
+        bool WriteFile(FileJob& job, std::unique_lock<std::mutex>& lock);
+
+        OutputTree& m_output;
+        std::vector<std::thread> m_threads;
+        std::deque<std::shared_ptr<FileJob>> m_jobs;  // Begun, not yet claimed by a writer
+        std::shared_ptr<FileJob> m_current;           // Still receiving data
+        std::unordered_map<std::wstring, std::shared_ptr<FileJob>> m_lastJobs;  // Latest open file per path
+        size_t m_openJobs = 0;                        // Begun and not yet closed
+
+        size_t m_memoryBudget;
+        size_t m_queuedBytes = 0;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_work;   // Idle writers: a file was begun
+        std::condition_variable m_data;   // Writer of the current file: data or its end arrived
+        std::condition_variable m_space;  // Reader: data drained or a file closed
+        std::condition_variable m_closed; // Writers or the reader waiting on a file at their path
+        bool m_stopping = false;
+        bool m_failed = false;
+        std::wstring m_failedName;
+    };
+
+} // namespace ArchiveEngine
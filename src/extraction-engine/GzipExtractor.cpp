@@ -0,0 +1,186 @@
+#include "GzipExtractor.h"
+#include "ParallelGzip.h"
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <cstring>
+
+namespace ArchiveEngine {
+
+    // GzipArchiveSource implementation
+    GzipArchiveSource::GzipArchiveSource(size_t bufferSize)
+        : m_decoder(std::make_unique<GzipDecoder>()),
+          m_buffer(InflateDecoder::WindowSize + std::max(bufferSize, InflateDecoder::MinOutputSpace * 4)) {}
+
+    bool GzipArchiveSource::Open(const std::wstring& filePath, size_t readAheadWindow) {
+        m_input = OpenArchiveSource(filePath, readAheadWindow);
+        if (!m_input) {
+            return false;
+        }
+        m_decoder->Reset(m_input.get());
+        m_begin = m_end = 0;
+        m_position = 0;
+        m_finished = false;
+        return true;
+    }
+
+    bool GzipArchiveSource::Fill(size_t minimum) {
+        while (m_end - m_begin < minimum && !m_finished) {
+            if (Cancelled()) {
+                return false;
+            }
+            if (m_buffer.size() - m_end < InflateDecoder::MinOutputSpace + minimum) {
+                // Recycle the buffer, keeping unread bytes and the DEFLATE window
+                size_t keepFrom = std::min(m_begin, m_end > InflateDecoder::WindowSize ? m_end - InflateDecoder::WindowSize : 0);
+                std::memmove(m_buffer.data(), m_buffer.data() + keepFrom, m_end - keepFrom);
+                m_begin -= keepFrom;
+                m_end -= keepFrom;
+                if (m_buffer.size() - m_end < InflateDecoder::MinOutputSpace + minimum) {
+                    m_buffer.resize(m_end + InflateDecoder::MinOutputSpace + minimum);
+                }
+            }
+
+            uint8_t* out = m_buffer.data() + m_end;
+            InflateDecoder::Status status;
+            {
+                TraceRecorder::Span span(m_trace, "decompress-block");
+                status = m_decoder->Decode(m_buffer.data(), out, m_buffer.data() + m_buffer.size());
+                span.AddBytes(static_cast<uint64_t>(out - (m_buffer.data() + m_end)));
+            }
+            m_end = static_cast<size_t>(out - m_buffer.data());
+
+            if (status == InflateDecoder::Status::Error) {
+                throw ExtractionException(L"corrupt or truncated gzip data");
+            }
+            if (status == InflateDecoder::Status::StreamEnd) {
+                m_finished = true;
+            }
+        }
+        return m_end - m_begin >= minimum;
+    }
+
+    const char* GzipArchiveSource::ReadBlock(size_t length) {
+        if (!Fill(length)) {
+            return nullptr;
+        }
+        const char* block = reinterpret_cast<const char*>(m_buffer.data() + m_begin);
+        m_begin += length;
+        m_position += length;
+        return block;
+    }
+
+    size_t GzipArchiveSource::Read(const char*& data, size_t maxLength) {
+        if (m_begin == m_end && !Fill(1)) {
+            return 0;
+        }
+        size_t length = std::min(maxLength, m_end - m_begin);
+        data = reinterpret_cast<const char*>(m_buffer.data() + m_begin);
+        m_begin += length;
+        m_position += length;
+        return length;
+    }
+
+    bool GzipArchiveSource::Skip(uint64_t length) {
+        // Compressed data cannot be seeked; decode and drop
+        while (length > 0) {
+            if (m_begin == m_end && !Fill(1)) {
+                return false;
+            }
+            size_t skipped = static_cast<size_t>(std::min<uint64_t>(length, m_end - m_begin));
+            m_begin += skipped;
+            m_position += skipped;
+            length -= skipped;
+        }
+        return true;
+    }
+
+    std::unique_ptr<IArchiveSource> OpenGzipSource(const std::wstring& filePath, unsigned threadCount,
+                                                   size_t readAheadWindow) {
+        if (threadCount == 0) {
+            threadCount = ThreadPool::DefaultThreadCount();
+        }
+        // A file of one chunk has nothing to split. The cutoff has not been measured on a
+        // host with more than one core (see bench/gzip-scaling.cpp).
+        if (threadCount > 1 && Utils::GetFileSize(filePath) >= 2 * ParallelGzipArchiveSource::DefaultChunkSize) {
+            auto parallel = std::make_unique<ParallelGzipArchiveSource>(threadCount);
+            if (parallel->Open(filePath)) {
+                return parallel;
+            }
+        }
+        auto source = std::make_unique<GzipArchiveSource>();
+        if (!source->Open(filePath, readAheadWindow)) {
+            return nullptr;
+        }
+        return source;
+    }
+
+    // GzipExtractor implementation
+    bool GzipExtractor::GetArchiveInfo(const std::wstring& filePath, std::vector<ArchiveEntry>& entries) const {
+        entries.clear();
+
+        MappedFile file;
+        if (!file.Open(filePath) || file.Size() < 18) {
+            return false;
+        }
+
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(file.Data());
+        size_t headerSize = 0;
+        uint32_t mtime = 0;
+        if (!GzipDecoder::ParseHeader(data, static_cast<size_t>(file.Size()), headerSize, mtime)) {
+            return false;
+        }
+
+        // ISIZE of the last member: the uncompressed size modulo 2^32, as reported by gzip -l
+        const uint8_t* trailer = data + file.Size() - 4;
+        uint32_t size = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | (uint32_t(trailer[3]) << 24);
+
+        ArchiveEntry entry;
+        entry.name = GetOutputName(filePath);
+        entry.size = size;
+        entry.compressedSize = file.Size();
+        entry.isDirectory = false;
+        entry.lastModified = mtime;
+        entry.permissions = 0644;
+        entries.push_back(entry);
+        return true;
+    }
+
+    std::wstring GzipExtractor::GetExtractorName() const {
+        return L"GZIP Extractor";
+    }
+
+    std::unique_ptr<IArchiveSource> GzipExtractor::OpenSource(const std::wstring& filePath,
+                                                              const ExtractionOptions& options) const {
+        return OpenGzipSource(filePath, options.decompressionThreads, options.readAheadWindow);
+    }
+
+    // TarGzipExtractor implementation
+    bool TarGzipExtractor::CanExtract(const std::wstring& filePath) const {
+        std::wstring extension = Utils::ToLowerCase(Utils::GetFileExtension(filePath));
+        return extension == L".tar.gz" || extension == L".tgz";
+    }
+
+    ExtractionResult TarGzipExtractor::Extract(
+        const std::wstring& archivePath,
+        const std::wstring& destinationPath,
+        const ExtractionOptions& options,
+        ProgressCallback callback) const {
+        // A size pre-scan would inflate the whole archive twice
+        ExtractionOptions singlePassOptions = options;
+        singlePassOptions.singlePass = true;
+        return TarExtractor::Extract(archivePath, destinationPath, singlePassOptions, callback);
+    }
+
+    std::vector<std::wstring> TarGzipExtractor::GetSupportedExtensions() const {
+        return { L".tar.gz", L".tgz" };
+    }
+
+    std::wstring TarGzipExtractor::GetExtractorName() const {
+        return L"TAR.GZ Extractor";
+    }
+
+    std::unique_ptr<IArchiveSource> TarGzipExtractor::OpenSource(const std::wstring& filePath,
+                                                                 const ExtractionOptions& options) const {
+        return OpenGzipSource(filePath, options.decompressionThreads, options.readAheadWindow);
+    }
+
+} // namespace ArchiveEngine
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "ArchiveExtractor.h"
+#include "ArchiveSource.h"
+#include "Inflate.h"
+#include "SingleFileExtractor.h"
+#include "TarExtractor.h"
+
+namespace ArchiveEngine {
+
+    // Archive source that inflates a gzip file on the fly. Decoded bytes are handed
+    // out in place from a recycled buffer that keeps the DEFLATE window in front of
+    // the write position, so the TAR parser reads straight from decoder output.
+    class GzipArchiveSource : public IArchiveSource {
+    public:
+        explicit GzipArchiveSource(size_t bufferSize = 4 * 1024 * 1024);
+
+        // Compressed input comes from OpenArchiveSource with `readAheadWindow`
+        bool Open(const std::wstring& filePath, size_t readAheadWindow = 0);
+
+        const char* ReadBlock(size_t length) override;
+        size_t Read(const char*& data, size_t maxLength) override;
+        bool Skip(uint64_t length) override;
+        uint64_t Position() const override { return m_position; }
+        uint64_t InputPosition() const override { return m_decoder->InputPosition(); }
+
+    private:
+        bool Fill(size_t minimum);
+
+        std::unique_ptr<IArchiveSource> m_input;
+        std::unique_ptr<GzipDecoder> m_decoder;
+        std::vector<uint8_t> m_buffer;
+        size_t m_begin = 0;
+        size_t m_end = 0;
+        uint64_t m_position = 0;
+        bool m_finished = false;
+    };
+
+    // Opens a decoding source for a gzip file: the parallel decoder when more than one
+    // thread is requested and the file spans several chunks, GzipArchiveSource otherwise.
+    // The parallel decoder maps the file; `readAheadWindow` applies to the sequential one.
+    std::unique_ptr<IArchiveSource> OpenGzipSource(const std::wstring& filePath, unsigned threadCount,
+                                                   size_t readAheadWindow = 0);
+
+    // Single-file gzip extractor (.gz)
+    class GzipExtractor : public SingleFileExtractor {
+    public:
+        GzipExtractor() : SingleFileExtractor(L".gz") {}
+        virtual ~GzipExtractor() = default;
+
+        using SingleFileExtractor::GetArchiveInfo;
+
+        // IArchiveExtractor implementation
+        bool GetArchiveInfo(const std::wstring& filePath, std::vector<ArchiveEntry>& entries) const override;
+        std::wstring GetExtractorName() const override;
+
+    protected:
+        std::unique_ptr<IArchiveSource> OpenSource(const std::wstring& filePath,
+                                                   const ExtractionOptions& options) const override;
+    };
+
+    // TAR extractor for gzip-compressed archives (.tar.gz, .tgz)
+    class TarGzipExtractor : public TarExtractor {
+    public:
+        using TarExtractor::Extract;
+
+        bool CanExtract(const std::wstring& filePath) const override;
+        ExtractionResult Extract(
+            const std::wstring& archivePath,
+            const std::wstring& destinationPath,
+            const ExtractionOptions& options,
+            ProgressCallback callback = nullptr) const override;
+        std::vector<std::wstring> GetSupportedExtensions() const override;
+        std::wstring GetExtractorName() const override;
+
+    protected:
+        std::unique_ptr<IArchiveSource> OpenSource(const std::wstring& filePath,
+                                                   const ExtractionOptions& options) const override;
+    };
+
+} // namespace ArchiveEngine
@@ -0,0 +1,975 @@
+#include "Inflate.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+
+namespace ArchiveEngine {
+
+    namespace {
+
+        // Decode table entry layout:
+        //   bits  0-7   codeword bits to consume (both codewords for a double literal)
+        //   bits  8-11  extra bits (lengths/distances) or subtable index bits
+        //   bits 12-15  flags
+        //   bits 16-31  literal byte(s), length/distance base, precode symbol or subtable start
+        constexpr uint32_t EntryDouble = 1u << 12;
+        constexpr uint32_t EntryLiteral = 1u << 13;
+        constexpr uint32_t EntrySubtable = 1u << 14;
+        constexpr uint32_t EntryEndOfBlock = 1u << 15;
+        constexpr uint32_t EntryExceptional = EntrySubtable | EntryEndOfBlock;
+        constexpr uint32_t EntryInvalid = EntrySubtable | EntryEndOfBlock;
+
+        constexpr uint16_t LengthBase[29] = {
+            3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+            35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+        };
+        constexpr uint8_t LengthExtra[29] = {
+            0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+            3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+        };
+        constexpr uint16_t DistBase[30] = {
+            1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+            257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+        };
+        constexpr uint8_t DistExtra[30] = {
+            0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+            7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+        };
+        constexpr uint8_t PrecodeOrder[19] = {
+            16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+        };
+
+        // Per-symbol entry templates; the table builder adds the codeword length
+        struct SymbolEntries {
+            uint32_t litlen[288];
+            uint32_t dist[32];
+            uint32_t precode[19];
+
+            SymbolEntries() {
+                for (uint32_t i = 0; i < 256; ++i) {
+                    litlen[i] = EntryLiteral | (i << 16);
+                }
+                litlen[256] = EntryEndOfBlock;
+                for (uint32_t i = 0; i < 29; ++i) {
+                    litlen[257 + i] = (uint32_t(LengthBase[i]) << 16) | (uint32_t(LengthExtra[i]) << 8);
+                }
+                litlen[286] = litlen[287] = EntryInvalid;
+
+                for (uint32_t i = 0; i < 30; ++i) {
+                    dist[i] = (uint32_t(DistBase[i]) << 16) | (uint32_t(DistExtra[i]) << 8);
+                }
+                dist[30] = dist[31] = EntryInvalid;
+
+                for (uint32_t i = 0; i < 19; ++i) {
+                    precode[i] = i << 16;
+                }
+            }
+        };
+
+        const SymbolEntries& GetSymbolEntries() {
+            static const SymbolEntries entries;
+            return entries;
+        }
+
+        // Builds a canonical Huffman decode table with a `tableBits` primary lookup.
+        // Codes longer than that go to subtables appended after the primary part.
+        // Incomplete codes are only accepted when they consist of at most one
+        // one-bit codeword, matching zlib; unused slots decode as invalid.
+        bool BuildDecodeTable(uint32_t* table, unsigned tableBits, const uint8_t* lengths,
+                              unsigned count, const uint32_t* symbols, bool allowIncomplete) {
+            unsigned lengthCount[16] = {};
+            for (unsigned i = 0; i < count; ++i) {
+                lengthCount[lengths[i]]++;
+            }
+            lengthCount[0] = 0;
+
+            int left = 1;
+            unsigned maxLength = 0;
+            for (unsigned len = 1; len <= 15; ++len) {
+                left <<= 1;
+                left -= static_cast<int>(lengthCount[len]);
+                if (left < 0) {
+                    return false; // Over-subscribed
+                }
+                if (lengthCount[len] != 0) {
+                    maxLength = len;
+                }
+            }
+            if (left > 0 && !(allowIncomplete && maxLength <= 1)) {
+                return false;
+            }
+
+            // Sort symbols by (length, symbol) and assign canonical codewords
+            unsigned offsets[16];
+            offsets[1] = 0;
+            for (unsigned len = 1; len < 15; ++len) {
+                offsets[len + 1] = offsets[len] + lengthCount[len];
+            }
+            uint16_t sorted[288];
+            unsigned used = 0;
+            for (unsigned sym = 0; sym < count; ++sym) {
+                if (lengths[sym] != 0) {
+                    sorted[offsets[lengths[sym]]++] = static_cast<uint16_t>(sym);
+                    ++used;
+                }
+            }
+
+            uint16_t reversed[288];
+            uint32_t code = 0;
+            unsigned previousLength = 0;
+            for (unsigned i = 0; i < used; ++i) {
+                unsigned len = lengths[sorted[i]];
+                code <<= (len - previousLength);
+                previousLength = len;
+                // DEFLATE sends codewords MSB first; the bit reader consumes LSB first
+                uint32_t r = 0;
+                for (unsigned b = 0; b < len; ++b) {
+                    r |= ((code >> b) & 1) << (len - 1 - b);
+                }
+                reversed[i] = static_cast<uint16_t>(r);
+                ++code;
+            }
+
+            const unsigned primarySize = 1u << tableBits;
+            std::fill(table, table + primarySize, EntryInvalid);
+
+            unsigned nextSubtable = primarySize;
+            unsigned currentPrefix = primarySize; // Never a valid prefix
+            unsigned subtableStart = 0;
+            unsigned subtableBits = 0;
+
+            for (unsigned i = 0; i < used; ++i) {
+                unsigned len = lengths[sorted[i]];
+                uint32_t r = reversed[i];
+
+                if (len <= tableBits) {
+                    uint32_t entry = symbols[sorted[i]] | len;
+                    for (uint32_t slot = r; slot < primarySize; slot += 1u << len) {
+                        table[slot] = entry;
+                    }
+                    continue;
+                }
+
+                unsigned prefix = r & (primarySize - 1);
+                if (prefix != currentPrefix) {
+                    // Codes sharing a prefix are contiguous in canonical order and the
+                    // last of them is the longest, which sizes the subtable
+                    unsigned last = i;
+                    while (last + 1 < used && (reversed[last + 1] & (primarySize - 1)) == prefix) {
+                        ++last;
+                    }
+                    subtableBits = lengths[sorted[last]] - tableBits;
+                    subtableStart = nextSubtable;
+                    nextSubtable += 1u << subtableBits;
+                    std::fill(table + subtableStart, table + nextSubtable, EntryInvalid);
+                    table[prefix] = EntrySubtable | (subtableStart << 16) | (subtableBits << 8);
+                    currentPrefix = prefix;
+                }
+
+                unsigned subLength = len - tableBits;
+                uint32_t entry = symbols[sorted[i]] | subLength;
+                for (uint32_t slot = r >> tableBits; slot < (1u << subtableBits); slot += 1u << subLength) {
+                    table[subtableStart + slot] = entry;
+                }
+            }
+            return true;
+        }
+
+        // Folds pairs of short literal codewords into single primary entries so the
+        // hot loop emits two literals per lookup
+        void AddDoubleLiterals(uint32_t* table) {
+            const unsigned tableBits = InflateDecoder::LitlenTableBits;
+            // Walk downwards so table[i >> l1] (always <= i) still holds a single-symbol entry
+            for (unsigned i = 1u << tableBits; i-- > 0;) {
+                uint32_t first = table[i];
+                if (!(first & EntryLiteral)) {
+                    continue;
+                }
+                unsigned firstLength = first & 0xff;
+                if (firstLength >= tableBits) {
+                    continue;
+                }
+                uint32_t second = table[i >> firstLength];
+                if (!(second & EntryLiteral) || (second & EntryDouble)) {
+                    continue;
+                }
+                unsigned secondLength = second & 0xff;
+                if (firstLength + secondLength > tableBits) {
+                    continue;
+                }
+                table[i] = EntryLiteral | EntryDouble | (first & 0x00ff0000) |
+                           ((second & 0x00ff0000) << 8) | (firstLength + secondLength);
+            }
+        }
+
+        struct FixedTables {
+            uint32_t litlen[InflateDecoder::LitlenTableSize];
+            uint32_t dist[InflateDecoder::DistTableSize];
+
+            FixedTables() {
+                uint8_t lengths[288 + 32];
+                std::fill(lengths, lengths + 144, uint8_t(8));
+                std::fill(lengths + 144, lengths + 256, uint8_t(9));
+                std::fill(lengths + 256, lengths + 280, uint8_t(7));
+                std::fill(lengths + 280, lengths + 288, uint8_t(8));
+                std::fill(lengths + 288, lengths + 320, uint8_t(5));
+
+                const SymbolEntries& symbols = GetSymbolEntries();
+                BuildDecodeTable(litlen, InflateDecoder::LitlenTableBits, lengths, 288, symbols.litlen, false);
+                AddDoubleLiterals(litlen);
+                BuildDecodeTable(dist, InflateDecoder::DistTableBits, lengths + 288, 32, symbols.dist, false);
+            }
+        };
+
+        const FixedTables& GetFixedTables() {
+            static const FixedTables tables;
+            return tables;
+        }
+
+        struct Crc32Tables {
+            uint32_t table[8][256];
+
+            Crc32Tables() {
+                for (uint32_t i = 0; i < 256; ++i) {
+                    uint32_t c = i;
+                    for (int k = 0; k < 8; ++k) {
+                        c = (c & 1) ? (c >> 1) ^ 0xEDB88320u : c >> 1;
+                    }
+                    table[0][i] = c;
+                }
+                for (uint32_t i = 0; i < 256; ++i) {
+                    for (int t = 1; t < 8; ++t) {
+                        table[t][i] = (table[t - 1][i] >> 8) ^ table[0][table[t - 1][i] & 0xff];
+                    }
+                }
+            }
+        };
+
+        const Crc32Tables& GetCrc32Tables() {
+            static const Crc32Tables tables;
+            return tables;
+        }
+
+        // Unaligned little-endian loads (the engine targets little-endian hosts)
+        inline uint64_t LoadLE64(const uint8_t* p) {
+            uint64_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        inline uint32_t LoadLE32(const uint8_t* p) {
+            uint32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+    } // namespace
+
+    uint32_t Crc32(uint32_t crc, const void* data, size_t length) {
+        const auto& t = GetCrc32Tables().table;
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+
+        crc = ~crc;
+        while (length >= 8) {
+            uint32_t low = LoadLE32(p) ^ crc;
+            uint32_t high = LoadLE32(p + 4);
+            crc = t[7][low & 0xff] ^ t[6][(low >> 8) & 0xff] ^ t[5][(low >> 16) & 0xff] ^ t[4][low >> 24] ^
+                  t[3][high & 0xff] ^ t[2][(high >> 8) & 0xff] ^ t[1][(high >> 16) & 0xff] ^ t[0][high >> 24];
+            p += 8;
+            length -= 8;
+        }
+        while (length-- > 0) {
+            crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xff];
+        }
+        return ~crc;
+    }
+
+    namespace {
+        // Product of two polynomials modulo the CRC-32 polynomial (reflected bit order)
+        uint32_t MultiplyModP(uint32_t a, uint32_t b) {
+            uint32_t m = 1u << 31;
+            uint32_t product = 0;
+            for (;;) {
+                if (a & m) {
+                    product ^= b;
+                    if ((a & (m - 1)) == 0) {
+                        break;
+                    }
+                }
+                m >>= 1;
+                b = (b & 1) ? (b >> 1) ^ 0xEDB88320u : b >> 1;
+            }
+            return product;
+        }
+    }
+
+    uint32_t Crc32Combine(uint32_t crcA, uint32_t crcB, uint64_t lengthB) {
+        // crc(A + B) = crc(A) * x^(8 * |B|) + crc(B) mod P; x^(2^k) mod P by repeated squaring
+        static const auto powers = [] {
+            std::array<uint32_t, 64> table{};
+            uint32_t p = 1u << 30; // x^1
+            for (auto& entry : table) {
+                entry = p;
+                p = MultiplyModP(p, p);
+            }
+            return table;
+        }();
+
+        uint32_t factor = 1u << 31; // x^0
+        uint64_t bits = lengthB * 8;
+        for (unsigned k = 0; bits != 0; ++k, bits >>= 1) {
+            if (bits & 1) {
+                factor = MultiplyModP(powers[k], factor);
+            }
+        }
+        return MultiplyModP(factor, crcA) ^ crcB;
+    }
+
+    // InflateDecoder implementation
+    InflateDecoder::InflateDecoder() {
+        // Build the shared tables up front rather than on the first block
+        GetSymbolEntries();
+        GetFixedTables();
+    }
+
+    void InflateDecoder::Reset(IArchiveSource* input) {
+        m_input = input;
+        m_inBase = m_in = m_inEnd = nullptr;
+        m_bitBuffer = 0;
+        m_bitCount = 0;
+        m_padBytes = 0;
+        ResetStream();
+    }
+
+    void InflateDecoder::ResetStream() {
+        m_state = State::BlockHeader;
+        m_finalBlock = false;
+        m_storedRemaining = 0;
+        m_litlen = m_dist = nullptr;
+    }
+
+    void InflateDecoder::SetInput(const uint8_t* data, size_t length, uint64_t bitOffset) {
+        Reset(nullptr);
+        m_inBase = data;
+        m_in = data + std::min<uint64_t>(bitOffset / 8, length);
+        m_inEnd = data + length;
+        if (bitOffset % 8 != 0 && EnsureBits(8)) {
+            DropBits(static_cast<unsigned>(bitOffset % 8));
+        }
+    }
+
+    uint64_t InflateDecoder::BitPosition() const {
+        return static_cast<uint64_t>(m_in - m_inBase) * 8 + m_padBytes * 8 - m_bitCount;
+    }
+
+    int InflateDecoder::PeekBlockHeader() {
+        if (!EnsureBits(3) || m_padBytes * 8 + 3 > m_bitCount) {
+            return -1;
+        }
+        return static_cast<int>(PeekBits(3));
+    }
+
+    bool InflateDecoder::EnterStoredBlock() {
+        m_finalBlock = false;
+        return ReadStoredLength();
+    }
+
+    bool InflateDecoder::NextInput() {
+        if (m_input == nullptr) {
+            return false;
+        }
+        const char* data = nullptr;
+        size_t length = m_input->Read(data, std::numeric_limits<size_t>::max());
+        if (length == 0) {
+            return false;
+        }
+        m_in = reinterpret_cast<const uint8_t*>(data);
+        m_inEnd = m_in + length;
+        return true;
+    }
+
+    bool InflateDecoder::RefillSlow() {
+        // Drop look-ahead bits left by the word-wise refill; they are re-read below
+        m_bitBuffer &= (uint64_t(1) << m_bitCount) - 1;
+
+        while (m_bitCount < 56) {
+            if (m_in == m_inEnd && !NextInput()) {
+                // Past the end of the input, feed zero bytes so lookups can still peek
+                // ahead; actually consuming them is detected as truncation
+                if (++m_padBytes > sizeof(m_bitBuffer)) {
+                    return false;
+                }
+                m_bitCount += 8;
+                continue;
+            }
+            m_bitBuffer |= uint64_t(*m_in++) << m_bitCount;
+            m_bitCount += 8;
+        }
+        return true;
+    }
+
+    bool InflateDecoder::EnsureBits(unsigned count) {
+        return m_bitCount >= count || RefillSlow();
+    }
+
+    bool InflateDecoder::ReadBytes(uint8_t* data, size_t length) {
+        AlignToByte();
+        for (size_t i = 0; i < length; ++i) {
+            if (!EnsureBits(8)) {
+                return false;
+            }
+            data[i] = static_cast<uint8_t>(PeekBits(8));
+            DropBits(8);
+        }
+        return !OverreadInput();
+    }
+
+    bool InflateDecoder::SkipBytes(uint64_t length) {
+        uint8_t byte;
+        for (uint64_t i = 0; i < length; ++i) {
+            if (!ReadBytes(&byte, 1)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool InflateDecoder::AtEndOfInput() {
+        AlignToByte();
+        if (m_bitCount > m_padBytes * 8 || m_in != m_inEnd) {
+            return false;
+        }
+        return m_padBytes > 0 || !NextInput();
+    }
+
+    uint64_t InflateDecoder::InputPosition() const {
+        if (m_input == nullptr) {
+            return 0;
+        }
+        uint64_t buffered = static_cast<uint64_t>(m_inEnd - m_in) + m_bitCount / 8;
+        buffered -= std::min<uint64_t>(buffered, m_padBytes);
+        return m_input->Position() - std::min(buffered, m_input->Position());
+    }
+
+    InflateDecoder::Status InflateDecoder::Decode(const uint8_t* windowStart, uint8_t*& out, uint8_t* outEnd) {
+        return DecodeBlocks(windowStart, out, outEnd);
+    }
+
+    InflateDecoder::Status InflateDecoder::DecodeWithMarkers(const uint16_t* outputStart, uint16_t*& out, uint16_t* outEnd) {
+        return DecodeBlocks(outputStart, out, outEnd);
+    }
+
+    template <typename Symbol>
+    InflateDecoder::Status InflateDecoder::DecodeBlocks(const Symbol* windowStart, Symbol*& out, Symbol* outEnd) {
+        for (;;) {
+            switch (m_state) {
+            case State::BlockHeader:
+                if (!ReadBlockHeader()) {
+                    return Status::Error;
+                }
+                break;
+
+            case State::StoredBlock: {
+                Status status = DecodeStored(out, outEnd);
+                if (status != Status::Ok) {
+                    return status;
+                }
+                if (m_storedRemaining > 0) {
+                    return Status::Ok; // Output full
+                }
+                m_state = m_finalBlock ? State::Done : State::BlockHeader;
+                if (m_state == State::BlockHeader && m_stopAtBlockEnd) {
+                    return Status::BlockEnd;
+                }
+                break;
+            }
+
+            case State::HuffmanBlock: {
+                Status status = DecodeHuffman(windowStart, out, outEnd);
+                if (status != Status::Ok) {
+                    return status;
+                }
+                if (m_state == State::HuffmanBlock) {
+                    return Status::Ok; // Output full
+                }
+                if (m_state == State::BlockHeader && m_stopAtBlockEnd) {
+                    return Status::BlockEnd;
+                }
+                break;
+            }
+
+            case State::Done:
+                return OverreadInput() ? Status::Error : Status::StreamEnd;
+            }
+        }
+    }
+
+    bool InflateDecoder::ReadBlockHeader() {
+        if (!EnsureBits(3)) {
+            return false;
+        }
+        m_finalBlock = PeekBits(1) != 0;
+        unsigned type = PeekBits(3) >> 1;
+        DropBits(3);
+
+        switch (type) {
+        case 0:
+            return ReadStoredLength();
+        case 1: {
+            const FixedTables& fixed = GetFixedTables();
+            m_litlen = fixed.litlen;
+            m_dist = fixed.dist;
+            m_state = State::HuffmanBlock;
+            return true;
+        }
+        case 2:
+            if (!ReadDynamicTables()) {
+                return false;
+            }
+            m_state = State::HuffmanBlock;
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool InflateDecoder::ReadStoredLength() {
+        AlignToByte();
+        if (!EnsureBits(32)) {
+            return false;
+        }
+        uint32_t length = PeekBits(16);
+        uint32_t inverted = static_cast<uint32_t>(m_bitBuffer >> 16) & 0xffff;
+        DropBits(32);
+        if (length != (~inverted & 0xffff)) {
+            return false;
+        }
+        m_storedRemaining = length;
+        m_state = State::StoredBlock;
+        return true;
+    }
+
+    bool InflateDecoder::ReadDynamicTables() {
+        if (!EnsureBits(14)) {
+            return false;
+        }
+        unsigned litlenCount = PeekBits(5) + 257;
+        DropBits(5);
+        unsigned distCount = PeekBits(5) + 1;
+        DropBits(5);
+        unsigned precodeCount = PeekBits(4) + 4;
+        DropBits(4);
+        if (litlenCount > 286 || distCount > 30) {
+            return false;
+        }
+
+        uint8_t precodeLengths[19] = {};
+        for (unsigned i = 0; i < precodeCount; ++i) {
+            if (!EnsureBits(3)) {
+                return false;
+            }
+            precodeLengths[PrecodeOrder[i]] = static_cast<uint8_t>(PeekBits(3));
+            DropBits(3);
+        }
+
+        const SymbolEntries& symbols = GetSymbolEntries();
+        if (!BuildDecodeTable(m_precodeTable, PrecodeTableBits, precodeLengths, 19, symbols.precode, false)) {
+            return false;
+        }
+
+        const unsigned total = litlenCount + distCount;
+        unsigned i = 0;
+        while (i < total) {
+            if (!EnsureBits(PrecodeTableBits + 7)) {
+                return false;
+            }
+            uint32_t entry = m_precodeTable[PeekBits(PrecodeTableBits)];
+            if ((entry & EntryExceptional) == EntryInvalid) {
+                return false;
+            }
+            DropBits(entry & 0xff);
+
+            unsigned symbol = entry >> 16;
+            if (symbol < 16) {
+                m_lengths[i++] = static_cast<uint8_t>(symbol);
+                continue;
+            }
+
+            uint8_t value = 0;
+            unsigned repeat;
+            if (symbol == 16) {
+                if (i == 0) {
+                    return false;
+                }
+                value = m_lengths[i - 1];
+                repeat = 3 + PeekBits(2);
+                DropBits(2);
+            } else if (symbol == 17) {
+                repeat = 3 + PeekBits(3);
+                DropBits(3);
+            } else {
+                repeat = 11 + PeekBits(7);
+                DropBits(7);
+            }
+            if (i + repeat > total) {
+                return false;
+            }
+            std::memset(m_lengths + i, value, repeat);
+            i += repeat;
+        }
+
+        // The block must be able to end
+        if (m_lengths[256] == 0) {
+            return false;
+        }
+
+        if (!BuildDecodeTable(m_litlenTable, LitlenTableBits, m_lengths, litlenCount, symbols.litlen, true) ||
+            !BuildDecodeTable(m_distTable, DistTableBits, m_lengths + litlenCount, distCount, symbols.dist, true)) {
+            return false;
+        }
+        AddDoubleLiterals(m_litlenTable);
+
+        m_litlen = m_litlenTable;
+        m_dist = m_distTable;
+        return true;
+    }
+
+    template <typename Symbol>
+    InflateDecoder::Status InflateDecoder::DecodeStored(Symbol*& out, Symbol* outEnd) {
+        while (m_storedRemaining > 0 && out < outEnd) {
+            // Whole bytes still sitting in the bit buffer come first
+            if (m_bitCount >= 8) {
+                if (m_bitCount <= m_padBytes * 8) {
+                    return Status::Error; // Truncated
+                }
+                *out++ = static_cast<uint8_t>(m_bitBuffer);
+                DropBits(8);
+                --m_storedRemaining;
+                continue;
+            }
+
+            // Then copy straight from the input
+            m_bitBuffer = 0;
+            if (m_in == m_inEnd && !NextInput()) {
+                return Status::Error;
+            }
+            size_t length = std::min<size_t>({ m_storedRemaining,
+                                               static_cast<size_t>(m_inEnd - m_in),
+                                               static_cast<size_t>(outEnd - out) });
+            if constexpr (sizeof(Symbol) == 1) {
+                std::memcpy(out, m_in, length);
+            } else {
+                std::copy(m_in, m_in + length, out);
+            }
+            out += length;
+            m_in += length;
+            m_storedRemaining -= static_cast<uint32_t>(length);
+        }
+        return Status::Ok;
+    }
+
+    template <typename Symbol>
+    InflateDecoder::Status InflateDecoder::DecodeHuffman(const Symbol* windowStart, Symbol*& outRef, Symbol* outEnd) {
+        // Work on locals so the compiler can keep the bit reader in registers
+        Symbol* out = outRef;
+        uint64_t bitBuffer = m_bitBuffer;
+        unsigned bitCount = m_bitCount;
+        const uint8_t* in = m_in;
+        const uint8_t* inEnd = m_inEnd;
+        const uint32_t* litlen = m_litlen;
+        const uint32_t* dist = m_dist;
+        Status status = Status::Ok;
+
+        const uint32_t litlenMask = (1u << LitlenTableBits) - 1;
+        const uint32_t distMask = (1u << DistTableBits) - 1;
+
+        while (static_cast<size_t>(outEnd - out) >= MinOutputSpace) {
+            // Refill to at least 56 bits, enough for a complete length/distance pair
+            // (15 + 5 + 15 + 13 bits) without further checks
+            if (inEnd - in >= 8) {
+                bitBuffer |= LoadLE64(in) << bitCount;
+                in += (63 - bitCount) >> 3;
+                bitCount |= 56;
+            } else {
+                m_bitBuffer = bitBuffer;
+                m_bitCount = bitCount;
+                m_in = in;
+                bool refilled = RefillSlow();
+                bitBuffer = m_bitBuffer;
+                bitCount = m_bitCount;
+                in = m_in;
+                inEnd = m_inEnd;
+                if (!refilled) {
+                    status = Status::Error;
+                    break;
+                }
+            }
+
+            uint32_t entry = litlen[bitBuffer & litlenMask];
+            if ((entry & EntryExceptional) == EntrySubtable) {
+                bitBuffer >>= LitlenTableBits;
+                bitCount -= LitlenTableBits;
+                entry = litlen[(entry >> 16) + (bitBuffer & ((1u << ((entry >> 8) & 15)) - 1))];
+            }
+            bitBuffer >>= entry & 0xff;
+            bitCount -= entry & 0xff;
+
+            if (entry & EntryLiteral) {
+                // One or two literals; the second store is harmless slack when single
+                out[0] = static_cast<Symbol>((entry >> 16) & 0xff);
+                out[1] = static_cast<Symbol>(entry >> 24);
+                out += 1 + ((entry >> 12) & 1);
+                continue;
+            }
+
+            if (entry & EntryExceptional) {
+                if ((entry & EntryExceptional) == EntryEndOfBlock) {
+                    m_state = m_finalBlock ? State::Done : State::BlockHeader;
+                } else {
+                    status = Status::Error;
+                }
+                break;
+            }
+
+            // Length/distance pair
+            unsigned extra = (entry >> 8) & 15;
+            size_t length = (entry >> 16) + static_cast<size_t>(bitBuffer & ((1u << extra) - 1));
+            bitBuffer >>= extra;
+            bitCount -= extra;
+
+            entry = dist[bitBuffer & distMask];
+            if ((entry & EntryExceptional) == EntrySubtable) {
+                bitBuffer >>= DistTableBits;
+                bitCount -= DistTableBits;
+                entry = dist[(entry >> 16) + (bitBuffer & ((1u << ((entry >> 8) & 15)) - 1))];
+            }
+            if (entry & EntryExceptional) {
+                status = Status::Error;
+                break;
+            }
+            bitBuffer >>= entry & 0xff;
+            bitCount -= entry & 0xff;
+
+            extra = (entry >> 8) & 15;
+            size_t distance = (entry >> 16) + static_cast<size_t>(bitBuffer & ((1u << extra) - 1));
+            bitBuffer >>= extra;
+            bitCount -= extra;
+
+            if constexpr (sizeof(Symbol) != 1) {
+                // Marker output: bytes before the output start are named by their window index
+                ptrdiff_t from = (out - windowStart) - static_cast<ptrdiff_t>(distance);
+                size_t k = 0;
+                for (; from < 0 && k < length; ++k, ++from) {
+                    out[k] = static_cast<Symbol>(MarkerFlag | (WindowSize + from));
+                }
+                Symbol* dst = out + k;
+                out += length;
+                if (dst < out) {
+                    const Symbol* src = dst - distance;
+                    if (distance >= 8) {
+                        do {
+                            std::memcpy(dst, src, 8 * sizeof(Symbol));
+                            dst += 8;
+                            src += 8;
+                        } while (dst < out);
+                    } else {
+                        do {
+                            *dst++ = *src++;
+                        } while (dst < out);
+                    }
+                }
+                continue;
+            }
+
+            if (distance > static_cast<size_t>(out - windowStart)) {
+                status = Status::Error;
+                break;
+            }
+
+            // Wide copies: whole 16- or 8-byte words whenever the source cannot
+            // overlap the current word, overrunning the match end by < CopyOverrun bytes
+            const Symbol* src = out - distance;
+            Symbol* dst = out;
+            out += length;
+            if (distance >= 16) {
+                do {
+                    std::memcpy(dst, src, 16);
+                    dst += 16;
+                    src += 16;
+                } while (dst < out);
+            } else if (distance >= 8) {
+                do {
+                    std::memcpy(dst, src, 8);
+                    dst += 8;
+                    src += 8;
+                } while (dst < out);
+            } else if (distance == 1) {
+                std::memset(dst, *src, length);
+            } else {
+                do {
+                    *dst++ = *src++;
+                } while (dst < out);
+            }
+        }
+
+        m_bitBuffer = bitBuffer;
+        m_bitCount = bitCount;
+        m_in = in;
+        m_inEnd = inEnd;
+        outRef = out;
+        return status;
+    }
+
+    // GzipDecoder implementation
+    namespace {
+        constexpr uint8_t GzipFlagHeaderCrc = 0x02;
+        constexpr uint8_t GzipFlagExtra = 0x04;
+        constexpr uint8_t GzipFlagName = 0x08;
+        constexpr uint8_t GzipFlagComment = 0x10;
+        constexpr uint8_t GzipFlagReserved = 0xE0;
+    }
+
+    void GzipDecoder::Reset(IArchiveSource* input) {
+        m_inflate.Reset(input);
+        m_state = State::MemberHeader;
+        m_members = 0;
+        m_crc = 0;
+        m_memberSize = 0;
+    }
+
+    GzipDecoder::Status GzipDecoder::Decode(const uint8_t* bufferStart, uint8_t*& out, uint8_t* outEnd) {
+        for (;;) {
+            switch (m_state) {
+            case State::MemberHeader: {
+                if (m_members > 0 && m_inflate.AtEndOfInput()) {
+                    m_state = State::Done;
+                    break;
+                }
+                uint8_t magic[2];
+                if (!m_inflate.ReadBytes(magic, 2) || magic[0] != 0x1f || magic[1] != 0x8b) {
+                    if (m_members == 0) {
+                        return Status::Error;
+                    }
+                    // Trailing garbage after the last member is ignored, as gzip does
+                    m_state = State::Done;
+                    break;
+                }
+                if (!ReadMemberHeader(m_inflate)) {
+                    return Status::Error;
+                }
+                m_inflate.ResetStream();
+                m_crc = 0;
+                m_memberSize = 0;
+                m_state = State::Body;
+                break;
+            }
+
+            case State::Body: {
+                // Back-references never reach into the previous member
+                const uint8_t* windowStart = bufferStart;
+                if (static_cast<uint64_t>(out - bufferStart) > m_memberSize) {
+                    windowStart = out - m_memberSize;
+                }
+
+                uint8_t* begin = out;
+                Status status = m_inflate.Decode(windowStart, out, outEnd);
+                m_crc = Crc32(m_crc, begin, static_cast<size_t>(out - begin));
+                m_memberSize += static_cast<uint64_t>(out - begin);
+                if (status != Status::StreamEnd) {
+                    return status;
+                }
+                uint32_t crc = 0;
+                uint32_t size = 0;
+                if (!ReadMemberTrailer(m_inflate, crc, size) ||
+                    crc != m_crc || size != static_cast<uint32_t>(m_memberSize)) {
+                    return Status::Error;
+                }
+                ++m_members;
+                m_state = State::MemberHeader;
+                break;
+            }
+
+            case State::Done:
+                return Status::StreamEnd;
+            }
+        }
+    }
+
+    bool GzipDecoder::ReadMemberHeader(InflateDecoder& inflate) {
+        // Magic already consumed: CM, FLG, MTIME[4], XFL, OS
+        uint8_t header[8];
+        if (!inflate.ReadBytes(header, sizeof(header))) {
+            return false;
+        }
+        uint8_t flags = header[1];
+        if (header[0] != 8 || (flags & GzipFlagReserved)) {
+            return false;
+        }
+
+        if (flags & GzipFlagExtra) {
+            uint8_t extraLength[2];
+            if (!inflate.ReadBytes(extraLength, 2) ||
+                !inflate.SkipBytes(extraLength[0] | (extraLength[1] << 8))) {
+                return false;
+            }
+        }
+        for (uint8_t field : { GzipFlagName, GzipFlagComment }) {
+            if (flags & field) {
+                uint8_t c;
+                do {
+                    if (!inflate.ReadBytes(&c, 1)) {
+                        return false;
+                    }
+                } while (c != 0);
+            }
+        }
+        if (flags & GzipFlagHeaderCrc) {
+            return inflate.SkipBytes(2);
+        }
+        return true;
+    }
+
+    bool GzipDecoder::ReadMemberTrailer(InflateDecoder& inflate, uint32_t& crc, uint32_t& size) {
+        uint8_t trailer[8];
+        if (!inflate.ReadBytes(trailer, sizeof(trailer))) {
+            return false;
+        }
+        crc = LoadLE32(trailer);
+        size = LoadLE32(trailer + 4);
+        return true;
+    }
+
+    bool GzipDecoder::ParseHeader(const uint8_t* data, size_t length, size_t& headerSize, uint32_t& mtime) {
+        if (length < 10 || data[0] != 0x1f || data[1] != 0x8b || data[2] != 8 || (data[3] & GzipFlagReserved)) {
+            return false;
+        }
+        uint8_t flags = data[3];
+        mtime = LoadLE32(data + 4);
+
+        size_t pos = 10;
+        if (flags & GzipFlagExtra) {
+            if (length - pos < 2) {
+                return false;
+            }
+            pos += 2 + (data[pos] | (data[pos + 1] << 8));
+        }
+        for (uint8_t field : { GzipFlagName, GzipFlagComment }) {
+            if (flags & field) {
+                while (pos < length && data[pos] != 0) {
+                    ++pos;
+                }
+                ++pos;
+            }
+        }
+        if (flags & GzipFlagHeaderCrc) {
+            pos += 2;
+        }
+        if (pos > length) {
+            return false;
+        }
+        headerSize = pos;
+        return true;
+    }
+
+} // namespace ArchiveEngine
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "ArchiveSource.h"
+#include <cstdint>
+#include <cstddef>
+
+namespace ArchiveEngine {
+
+    // CRC-32 (IEEE 802.3 polynomial, as used by gzip), slice-by-8
+    uint32_t Crc32(uint32_t crc, const void* data, size_t length);
+
+    // CRC-32 of the concatenation A + B from crc(A), crc(B) and the length of B
+    uint32_t Crc32Combine(uint32_t crcA, uint32_t crcB, uint64_t lengthB);
+
+    // Table-driven DEFLATE (RFC 1951) decoder.
+    //
+    // Input is pulled from an IArchiveSource on demand. Output goes into a caller-owned
+    // buffer; back-references may reach up to WindowSize bytes behind the write position,
+    // so the caller must keep that much history in front of it when it recycles the buffer.
+    // Decoding pauses whenever less than MinOutputSpace bytes of room are left.
+    //
+    // Input may instead be a memory range entered at an arbitrary bit offset, which
+    // together with block-boundary stops and marker output lets the parallel gzip
+    // decoder start in the middle of a stream.
+    class InflateDecoder {
+    public:
+        enum class Status {
+            Ok,         // Output space exhausted; call again with more room
+            BlockEnd,   // A non-final block ended (only with SetStopAtBlockEnd)
+            StreamEnd,  // Final block decoded
+            Error       // Corrupt or truncated stream
+        };
+
+        static constexpr size_t WindowSize = 32 * 1024;
+        static constexpr size_t MaxMatchLength = 258;
+        static constexpr size_t CopyOverrun = 16;  // Wide copies may write this far past a match
+        static constexpr size_t MinOutputSpace = MaxMatchLength + CopyOverrun;
+
+        // Primary lookup widths of the decode tables; longer codes use second-level subtables
+        static constexpr unsigned LitlenTableBits = 11;
+        static constexpr unsigned DistTableBits = 8;
+        static constexpr unsigned PrecodeTableBits = 7;
+        static constexpr size_t LitlenTableSize = (1 << LitlenTableBits) + 288 * 16;
+        static constexpr size_t DistTableSize = (1 << DistTableBits) + 32 * 128;
+
+        // Marker output: references into the unknown window before the output start
+        // decode to MarkerFlag | (index into that 32 KB window)
+        static constexpr uint16_t MarkerFlag = 0x8000;
+
+        InflateDecoder();
+
+        // Starts decoding a new stream read from `input`
+        void Reset(IArchiveSource* input);
+
+        // Prepares for the next raw DEFLATE stream (e.g. the next gzip member),
+        // keeping the buffered input
+        void ResetStream();
+
+        // Reads from memory instead of a source, starting `bitOffset` bits into `data`.
+        // Starts a new stream.
+        void SetInput(const uint8_t* data, size_t length, uint64_t bitOffset = 0);
+
+        // Bits consumed from the start of the memory input
+        uint64_t BitPosition() const;
+
+        // When set, Decode also returns BlockEnd after every non-final block
+        void SetStopAtBlockEnd(bool stop) { m_stopAtBlockEnd = stop; }
+
+        // Header bits (BFINAL | BTYPE << 1) of the block starting at the current
+        // position, or -1 at end of input
+        int PeekBlockHeader();
+
+        // Reads the header (and code tables) of the block at the current position
+        bool ReadBlockHeader();
+
+        // Enters a non-final stored block whose LEN field starts at the current byte
+        bool EnterStoredBlock();
+
+        // Decodes into [out, outEnd). Back-references may reach down to `windowStart`.
+        Status Decode(const uint8_t* windowStart, uint8_t*& out, uint8_t* outEnd);
+
+        // Decodes 16-bit symbols into [out, outEnd) for a stream entered mid-way with an
+        // unknown window: bytes before `outputStart` come out as markers (see MarkerFlag)
+        Status DecodeWithMarkers(const uint16_t* outputStart, uint16_t*& out, uint16_t* outEnd);
+
+        // Byte-level access to the input between DEFLATE streams (container headers/trailers).
+        // These discard any bits left in the current byte first.
+        bool ReadBytes(uint8_t* data, size_t length);
+        bool SkipBytes(uint64_t length);
+        bool AtEndOfInput();
+
+        // Number of compressed bytes consumed from the input source
+        uint64_t InputPosition() const;
+
+    private:
+        enum class State { BlockHeader, StoredBlock, HuffmanBlock, Done };
+
+        bool NextInput();
+        bool RefillSlow();
+        bool EnsureBits(unsigned count);
+        uint32_t PeekBits(unsigned count) const { return static_cast<uint32_t>(m_bitBuffer & ((uint64_t(1) << count) - 1)); }
+        void DropBits(unsigned count) { m_bitBuffer >>= count; m_bitCount -= count; }
+        void AlignToByte() { DropBits(m_bitCount & 7); }
+        bool OverreadInput() const { return m_padBytes * 8 > m_bitCount; }
+
+        bool ReadStoredLength();
+        bool ReadDynamicTables();
+
+        template <typename Symbol>
+        Status DecodeBlocks(const Symbol* windowStart, Symbol*& out, Symbol* outEnd);
+        template <typename Symbol>
+        Status DecodeStored(Symbol*& out, Symbol* outEnd);
+        template <typename Symbol>
+        Status DecodeHuffman(const Symbol* windowStart, Symbol*& out, Symbol* outEnd);
+
+        // Bit reader
+        IArchiveSource* m_input = nullptr;
+        const uint8_t* m_inBase = nullptr;
+        const uint8_t* m_in = nullptr;
+        const uint8_t* m_inEnd = nullptr;
+        uint64_t m_bitBuffer = 0;
+        unsigned m_bitCount = 0;
+        unsigned m_padBytes = 0;  // Zero bytes appended past the end of the input
+
+        // Block state
+        State m_state = State::BlockHeader;
+        bool m_finalBlock = false;
+        bool m_stopAtBlockEnd = false;
+        uint32_t m_storedRemaining = 0;
+
+        // Decode tables of the current block: either the shared fixed-code tables or the
+        // dynamic ones below. Primary literal/length entries may carry two literals at once.
+        const uint32_t* m_litlen = nullptr;
+        const uint32_t* m_dist = nullptr;
+        uint32_t m_litlenTable[LitlenTableSize];
+        uint32_t m_distTable[DistTableSize];
+        uint32_t m_precodeTable[1 << PrecodeTableBits];
+        uint8_t m_lengths[288 + 32];
+    };
+
+    // gzip (RFC 1952) container decoder on top of InflateDecoder: parses member
+    // headers, verifies CRC-32 and ISIZE trailers and continues across
+    // concatenated members.
+    class GzipDecoder {
+    public:
+        using Status = InflateDecoder::Status;
+
+        void Reset(IArchiveSource* input);
+
+        // Decodes into [out, outEnd) with the same buffer contract as InflateDecoder::Decode
+        Status Decode(const uint8_t* bufferStart, uint8_t*& out, uint8_t* outEnd);
+
+        uint64_t InputPosition() const { return m_inflate.InputPosition(); }
+
+        // Reads the header fields of the member at the start of a mapped gzip file
+        static bool ParseHeader(const uint8_t* data, size_t length, size_t& headerSize, uint32_t& mtime);
+
+        // Reads the member header fields that follow the 1f 8b magic through `inflate`
+        static bool ReadMemberHeader(InflateDecoder& inflate);
+
+        // Reads a member trailer through `inflate`
+        static bool ReadMemberTrailer(InflateDecoder& inflate, uint32_t& crc, uint32_t& size);
+
+    private:
+        enum class State { MemberHeader, Body, Done };
+
+        InflateDecoder m_inflate;
+        State m_state = State::MemberHeader;
+        uint64_t m_members = 0;
+        uint32_t m_crc = 0;
+        uint64_t m_memberSize = 0;
+    };
+
+} // namespace ArchiveEngine
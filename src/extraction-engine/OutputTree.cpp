@@ -0,0 +1,638 @@
+#include "OutputTree.h"
+#include "ArchiveExtractor.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
+#ifndef O_DIRECT
+#define O_DIRECT 0  // Direct I/O hints are ignored where the flag does not exist
+#endif
+#endif
+
+namespace ArchiveEngine {
+
+    // ExtractedFileLog implementation
+    void ExtractedFileLog::Note(const std::wstring& name, FileOutcome outcome) {
+        // Until a file goes missing, a written one changes nothing and costs no lock
+        if (outcome == FileOutcome::Written && !m_pruning.load(std::memory_order_acquire)) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (outcome == FileOutcome::Written) {
+            auto file = m_files.find(name);
+            if (file != m_files.end()) {
+                file->second.lost = false;
+            }
+            return;
+        }
+        State& state = m_files[name];
+        if (outcome == FileOutcome::Lost) {
+            state.lost = true;
+        } else {
+            ++state.dropped;
+        }
+        m_pruning.store(true, std::memory_order_release);
+    }
+
+    void ExtractedFileLog::Prune(std::vector<std::wstring>& names) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_files.empty()) {
+            return;
+        }
+        std::unordered_map<std::wstring, size_t> dropped;
+        for (const auto& file : m_files) {
+            if (!file.second.lost && file.second.dropped > 0) {
+                dropped.emplace(file.first, file.second.dropped);
+            }
+        }
+
+        // Walks from the end so the latest listings of a dropped name go first
+        std::vector<bool> keep(names.size(), true);
+        for (size_t i = names.size(); i-- > 0;) {
+            auto file = m_files.find(names[i]);
+            if (file == m_files.end()) {
+                continue;
+            }
+            if (file->second.lost) {
+                keep[i] = false;
+            } else {
+                auto count = dropped.find(names[i]);
+                if (count != dropped.end() && count->second > 0) {
+                    --count->second;
+                    keep[i] = false;
+                }
+            }
+        }
+        size_t kept = 0;
+        for (size_t i = 0; i < names.size(); ++i) {
+            if (keep[i]) {
+                if (kept != i) {
+                    names[kept] = std::move(names[i]);
+                }
+                ++kept;
+            }
+        }
+        names.resize(kept);
+    }
+
+#ifdef _WIN32
+    // OutputFile implementation
+    OutputFile::~OutputFile() {
+    }
+
+    bool OutputFile::IsOpen() const {
+        return m_stream.is_open();
+    }
+
+    bool OutputFile::Write(uint64_t offset, const char* data, size_t length) {
+        ExtractionStatsRecorder::Scope scope(m_stats, ExtractionPhase::WriteData, length);
+        TraceRecorder::Span span(m_trace, "write-file", length);
+        if (m_failed) {
+            return false;
+        }
+        if (offset != m_end) {
+            m_stream.seekp(static_cast<std::streamoff>(offset));
+        }
+        m_stream.write(data, static_cast<std::streamsize>(length));
+        m_end = offset + length;
+        m_failed = !m_stream;
+        return !m_failed;
+    }
+
+    bool OutputFile::CopyFrom(int descriptor, uint64_t sourceOffset, uint64_t offset, uint64_t length) {
+        // Sources never hand out descriptors on Windows
+        m_failed = true;
+        return false;
+    }
+
+    bool OutputFile::Close(uint64_t fileSize) {
+        {
+            // Unix permission bits and timestamps are not carried over to Windows files
+            ExtractionStatsRecorder::Scope scope(m_stats, ExtractionPhase::CloseFile);
+            TraceRecorder::Span span(m_trace, "close-file");
+            m_stream.close();
+            if (!m_failed && !m_stream.fail() && m_end < fileSize) {
+                std::error_code ec;
+                std::filesystem::resize_file(m_path, fileSize, ec);
+                m_failed = static_cast<bool>(ec);
+            }
+        }
+        bool ok = !m_failed && !m_stream.fail();
+        if (m_stats) {
+            m_stats->AddFileLatency(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                ExtractionStatsRecorder::Clock::now() - m_openTime).count()));
+        }
+        return ok;
+    }
+
+    // OutputTree implementation
+    OutputTree::OutputTree(const std::wstring& root, ExtractionStatsRecorder* stats, TraceRecorder* trace,
+                           const CancellationToken* cancellation, ExtractedFileLog* files)
+        : m_root(root), m_stats(stats), m_trace(trace), m_cancellation(cancellation), m_files(files),
+          m_directories(root) {
+    }
+
+    OutputTree::~OutputTree() {
+    }
+
+    bool OutputTree::MakeDirectory(const std::wstring& path) {
+        ExtractionStatsRecorder::Scope scope(m_stats, ExtractionPhase::MakeDirectory);
+        TraceRecorder::Span span(m_trace, "create-directory");
+        return m_directories.Create(path);
+    }
+
+    bool OutputTree::OpenFile(const std::wstring& path, const OutputFileAttributes& attributes, OutputFile& file) {
+        file.m_stats = m_stats;
+        file.m_trace = m_trace;
+        file.m_cancellation = m_cancellation;
+        if (m_stats) {
+            file.m_openTime = ExtractionStatsRecorder::Clock::now();
+        }
+        ExtractionStatsRecorder::Scope scope(m_stats, ExtractionPhase::OpenFile);
+        TraceRecorder::Span span(m_trace, "open-file");
+        if (!m_directories.CreateParent(path)) {
+            return false;
+        }
+        file.m_attributes = attributes;
+        file.m_path = std::filesystem::path(path);
+        file.m_stream.open(file.m_path, std::ios::binary);
+        return file.m_stream.is_open();
+    }
+
+    void OutputTree::RemoveFile(const std::wstring& path, OutputFile& file) {
+        file.m_stream.close();
+        std::error_code ec;
+        std::filesystem::remove(file.m_path, ec);
+    }
+#else
+    namespace {
+
+        // Bytes moved per copy call, bounding the time spent in any one of them
+        constexpr uint64_t KernelCopyChunk = 64 * 1024 * 1024;
+        constexpr size_t PipeSize = 1024 * 1024;
+        constexpr size_t BounceBufferSize = 1024 * 1024;
+
+        // umask() cannot query the mask without changing it for every thread of the host
+        // process, so it is read from /proc instead. Where that is not possible, the
+        // common default of 022 is assumed.
+        uint32_t ProcessUmask() {
+            uint32_t mask = 022;
+#ifdef __linux__
+            std::ifstream status("/proc/self/status");
+            std::string line;
+            while (std::getline(status, line)) {
+                if (line.compare(0, 6, "Umask:") == 0) {
+                    mask = static_cast<uint32_t>(std::strtoul(line.c_str() + 6, nullptr, 8)) & 0777;
+                    break;
+                }
+            }
+#endif
+            return mask;
+        }
+
+    } // namespace
+
+    // OutputFile implementation
+    void OutputFile::AlignedFree::operator()(char* buffer) const {
+        std::free(buffer);
+    }
+
+    OutputFile::~OutputFile() {
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+    }
+
+    bool OutputFile::IsOpen() const {
+        return m_fd >= 0;
+    }
+
+    bool OutputFile::WriteAt(uint64_t offset, const char* data, size_t length) {
+        while (length > 0 && !m_failed) {
+            ssize_t written = ::pwrite(m_fd, data, length, static_cast<off_t>(offset));
+            CountSystemCalls();
+            if (written < 0) {
+                m_failed = errno != EINTR;
+                continue;
+            }
+            data += written;
+            offset += static_cast<uint64_t>(written);
+            length -= static_cast<size_t>(written);
+        }
+        return !m_failed;
+    }
+
+    bool OutputFile::Write(uint64_t offset, const char* data, size_t length) {
+        ExtractionStatsRecorder::Scope scope(m_stats, ExtractionPhase::WriteData, length);
+        TraceRecorder::Span span(m_trace, "write-file", length);
+        if (m_directBuffer) {
+            // Anything but the next bytes in order ends direct writing
+            if (offset != m_end + m_directLength) {
+                if (!EndDirect()) {
+                    return false;
+                }
+            } else {
+                while (length > 0) {
+                    size_t part = std::min(length, DirectChunkSize - m_directLength);
+                    std::memcpy(m_directBuffer.get() + m_directLength, data, part);
+                    m_directLength += part;
+                    data += part;
+                    length -= part;
+                    if (m_directLength == DirectChunkSize) {
+                        if (!WriteAt(m_end, m_directBuffer.get(), DirectChunkSize)) {
+                            return false;
+                        }
+                        m_end += DirectChunkSize;
+                        m_directLength = 0;
+                    }
+                }
+                return true;
+            }
+        }
+
+        if (!WriteAt(offset, data, length)) {
+            return false;
+        }
+        if (offset + length > m_end) {
+            m_end = offset + length;
+        }
+        return true;
+    }
+
+    bool OutputFile::EndDirect() {
+        // The buffered tail need not be a whole number of blocks, so it goes out
+        // through the page cache
+        int flags = ::fcntl(m_fd, F_GETFL);
+        if (flags < 0 || ::fcntl(m_fd, F_SETFL, flags & ~O_DIRECT) != 0) {
+            m_failed = true;
+        }
+        CountSystemCalls(2);
+        bool ok = m_directLength == 0 || WriteAt(m_end, m_directBuffer.get(), m_directLength);
+        m_end += m_directLength;
+        m_directLength = 0;
+        m_directBuffer.reset();
+        return ok && !m_failed;
+    }
+
+    bool OutputFile::CopyFrom(int descriptor, uint64_t sourceOffset, uint64_t offset, uint64_t length) {
+        ExtractionStatsRecorder::Scope scope(m_stats, ExtractionPhase::WriteData, length);
+        TraceRecorder::Span span(m_trace, "write-file", length);
+        if (m_failed || (m_directBuffer && !EndDirect())) {
+            return false;
+        }
+        uint64_t end = offset + length;
+
+        // Each method leaves what it could not copy to the next; errors surface in the last.
+        // All of them stop between chunks once the extraction is cancelled.
+        CloneRange(descriptor, sourceOffset, offset, length);
+        CopyRange(descriptor, sourceOffset, offset, length);
+        SpliceRange(descriptor, sourceOffset, offset, length);
+        if (length > 0) {
+            std::vector<char> buffer(static_cast<size_t>(std::min<uint64_t>(length, BounceBufferSize)));
+            while (length > 0 && !m_failed) {
+                if (Cancelled()) {
+                    m_failed = true;
+                    break;
+                }
+                ssize_t bytesRead = ::pread(descriptor, buffer.data(),
+                                            static_cast<size_t>(std::min<uint64_t>(length, buffer.size())),
+                                            static_cast<off_t>(sourceOffset));
+                CountSystemCalls();
+                if (bytesRead <= 0) {
+                    m_failed = bytesRead == 0 || errno != EINTR;
+                    continue;
+                }
+                WriteAt(offset, buffer.data(), static_cast<size_t>(bytesRead));
+                sourceOffset += static_cast<uint64_t>(bytesRead);
+                offset += static_cast<uint64_t>(bytesRead);
+                length -= static_cast<uint64_t>(bytesRead);
+            }
+        }
+
+        if (!m_failed && end > m_end) {
+            m_end = end;
+        }
+        return !m_failed;
+    }
+
+#ifdef __linux__
+    void OutputFile::CloneRange(int descriptor, uint64_t& sourceOffset, uint64_t& offset, uint64_t& length) {
+        // Only whole blocks can be shared, and only at the same position within a block in
+        // both files; TAR payloads start on 512-byte boundaries, so this holds for some only
+        struct stat st;
+        CountSystemCalls();
+        if (::fstat(m_fd, &st) != 0 || st.st_blksize <= 0) {
+            return;
+        }
+        uint64_t blockSize = static_cast<uint64_t>(st.st_blksize);
+        uint64_t blocks = length - length % blockSize;
+        if (blocks == 0 || sourceOffset % blockSize != 0 || offset % blockSize != 0) {
+            return;
+        }
+
+        struct file_clone_range range;
+        range.src_fd = descriptor;
+        range.src_offset = sourceOffset;
+        range.src_length = blocks;
+        range.dest_offset = offset;
+        CountSystemCalls();
+        if (::ioctl(m_fd, FICLONERANGE, &range) == 0) {
+            sourceOffset += blocks;
+            offset += blocks;
+            length -= blocks;
+        }
+    }
+
+    void OutputFile::CopyRange(int descriptor, uint64_t& sourceOffset, uint64_t& offset, uint64_t& length) {
+        // Fails across file systems, and on older kernels across file system types
+        while (length > 0 && !Cancelled()) {
+            loff_t in = static_cast<loff_t>(sourceOffset);
+            loff_t out = static_cast<loff_t>(offset);
+            ssize_t copied = ::copy_file_range(descriptor, &in, m_fd, &out,
+                                               static_cast<size_t>(std::min(length, KernelCopyChunk)), 0);
+            CountSystemCalls();
+            if (copied <= 0) {
+                if (copied < 0 && errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            sourceOffset += static_cast<uint64_t>(copied);
+            offset += static_cast<uint64_t>(copied);
+            length -= static_cast<uint64_t>(copied);
+        }
+    }
+
+    void OutputFile::SpliceRange(int descriptor, uint64_t& sourceOffset, uint64_t& offset, uint64_t& length) {
+        if (length == 0) {
+            return;
+        }
+        int pipes[2];
+        CountSystemCalls();
+        if (::pipe2(pipes, O_CLOEXEC) != 0) {
+            return;
+        }
+        // A larger pipe moves more per call; the default size still works
+        ::fcntl(pipes[1], F_SETPIPE_SZ, static_cast<int>(PipeSize));
+        CountSystemCalls();
+
+        while (length > 0 && !Cancelled()) {
+            loff_t in = static_cast<loff_t>(sourceOffset);
+            ssize_t filled = ::splice(descriptor, &in, pipes[1], nullptr,
+                                      static_cast<size_t>(std::min<uint64_t>(length, PipeSize)), SPLICE_F_MOVE);
+            CountSystemCalls();
+            if (filled <= 0) {
+                if (filled < 0 && errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+
+            // Only bytes that reached the file count; the pipe is dropped with the rest
+            size_t pending = static_cast<size_t>(filled);
+            while (pending > 0) {
+                loff_t out = static_cast<loff_t>(offset);
+                ssize_t drained = ::splice(pipes[0], nullptr, m_fd, &out, pending, SPLICE_F_MOVE);
+                CountSystemCalls();
+                if (drained <= 0) {
+                    if (drained < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    break;
+                }
+                pending -= static_cast<size_t>(drained);
+                sourceOffset += static_cast<uint64_t>(drained);
+                offset += static_cast<uint64_t>(drained);
+                length -= static_cast<uint64_t>(drained);
+            }
+            if (pending > 0) {
+                break;
+            }
+        }
+        ::close(pipes[0]);
+        ::close(pipes[1]);
+        CountSystemCalls(2);
+    }
+#else
+    void OutputFile::CloneRange(int descriptor, uint64_t& sourceOffset, uint64_t& offset, uint64_t& length) {
+    }
+
+    void OutputFile::CopyRange(int descriptor, uint64_t& sourceOffset, uint64_t& offset, uint64_t& length) {
+    }
+
+    void OutputFile::SpliceRange(int descriptor, uint64_t& sourceOffset, uint64_t& offset, uint64_t& length) {
+    }
+#endif
+
+    bool OutputFile::Close(uint64_t fileSize) {
+        bool ok;
+        {
+            ExtractionStatsRecorder::Scope scope(m_stats, ExtractionPhase::CloseFile);
+            TraceRecorder::Span span(m_trace, "close-file");
+            ok = !m_failed && (!m_directBuffer || EndDirect());
+            if (ok && m_end < fileSize) {
+                ok = ::ftruncate(m_fd, static_cast<off_t>(fileSize)) == 0;
+                CountSystemCalls();
+            }
+
+            // Permission bits are masked by the umask as for any new file; set-id and sticky
+            // bits are not restored
+            if (ok) {
+                ok = ::fchmod(m_fd, static_cast<mode_t>(m_mode)) == 0;
+                CountSystemCalls();
+            }
+            if (ok) {
+                struct timespec times[2];
+                times[0].tv_sec = 0;
+                times[0].tv_nsec = UTIME_NOW;
+                times[1].tv_sec = static_cast<time_t>(m_attributes.mtime);
+                times[1].tv_nsec = 0;
+                ok = ::futimens(m_fd, times) == 0;
+                CountSystemCalls();
+            }
+
+            int fd = m_fd;
+            m_fd = -1;
+            ok = ::close(fd) == 0 && ok;
+            CountSystemCalls();
+        }
+        if (m_stats) {
+            m_stats->AddFileLatency(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                ExtractionStatsRecorder::Clock::now() - m_openTime).count()));
+        }
+        return ok;
+    }
+
+    // OutputTree implementation
+    OutputTree::DirectoryHandle::~DirectoryHandle() {
+        ::close(fd);
+    }
+
+    OutputTree::OutputTree(const std::wstring& root, ExtractionStatsRecorder* stats, TraceRecorder* trace,
+                           const CancellationToken* cancellation, ExtractedFileLog* files)
+        : m_root(root), m_stats(stats), m_trace(trace), m_cancellation(cancellation), m_files(files),
+          m_umask(ProcessUmask()) {
+        int fd = ::open(std::filesystem::path(root).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd >= 0) {
+            m_rootHandle = std::make_shared<DirectoryHandle>(fd);
+        }
+    }
+
+    OutputTree::~OutputTree() {
+    }
+
+    std::string OutputTree::RelativePath(const std::wstring& path) const {
+        if (path.size() <= m_root.size() + 1) {
+            return std::string();
+        }
+        // Names below the root hold one byte per character; the file system gets those bytes
+        return Utils::NarrowBytes(std::wstring_view(path).substr(m_root.size() + 1));
+    }
+
+    OutputTree::DirectoryPtr OutputTree::OpenDirectory(const std::string& relative) {
+        if (relative.empty()) {
+            return m_rootHandle;
+        }
+        auto it = m_handles.find(relative);
+        if (it != m_handles.end()) {
+            m_recent.splice(m_recent.begin(), m_recent, it->second);
+            return it->second->second;
+        }
+
+        size_t slash = relative.rfind('/');
+        DirectoryPtr parent = OpenDirectory(slash == std::string::npos ? std::string() : relative.substr(0, slash));
+        if (!parent) {
+            return nullptr;
+        }
+
+        // Made at most once per extraction: a directory dropped from the cache is known to
+        // exist and is only reopened. Existing directories are never entered through a
+        // symbolic link.
+        const char* name = relative.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+        if (m_made.count(relative) == 0) {
+            CountSystemCalls();
+            if (::mkdirat(parent->fd, name, 0777) != 0 && errno != EEXIST) {
+                return nullptr;
+            }
+            m_made.insert(relative);
+        }
+        CountSystemCalls();
+        int fd = ::openat(parent->fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (fd < 0) {
+            return nullptr;
+        }
+
+        if (m_recent.size() >= MaxOpenDirectories) {
+            m_handles.erase(m_recent.back().first);
+            m_recent.pop_back();
+        }
+        DirectoryPtr handle = std::make_shared<DirectoryHandle>(fd);
+        m_recent.emplace_front(relative, handle);
+        m_handles.emplace(relative, m_recent.begin());
+        return handle;
+    }
+
+    bool OutputTree::MakeDirectory(const std::wstring& path) {
+        ExtractionStatsRecorder::Scope scope(m_stats, ExtractionPhase::MakeDirectory);
+        TraceRecorder::Span span(m_trace, "create-directory");
+        std::string relative = RelativePath(path);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return OpenDirectory(relative) != nullptr;
+    }
+
+    OutputTree::DirectoryPtr OutputTree::OpenParent(const std::wstring& path, std::string& name) {
+        std::string relative = RelativePath(path);
+        if (relative.empty()) {
+            return nullptr;
+        }
+        size_t slash = relative.rfind('/');
+        name.assign(relative, slash == std::string::npos ? 0 : slash + 1, std::string::npos);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return OpenDirectory(slash == std::string::npos ? std::string() : relative.substr(0, slash));
+    }
+
+    bool OutputTree::OpenFile(const std::wstring& path, const OutputFileAttributes& attributes, OutputFile& file) {
+        file.m_stats = m_stats;
+        file.m_trace = m_trace;
+        file.m_cancellation = m_cancellation;
+        if (m_stats) {
+            file.m_openTime = ExtractionStatsRecorder::Clock::now();
+        }
+        ExtractionStatsRecorder::Scope scope(m_stats, ExtractionPhase::OpenFile);
+        TraceRecorder::Span span(m_trace, "open-file");
+        std::string fileName;
+        DirectoryPtr directory = OpenParent(path, fileName);
+        if (!directory) {
+            return false;
+        }
+
+        // The file is opened outside the lock; the handle keeps the directory open
+        const char* name = fileName.c_str();
+        const int flags = O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC;
+        file.m_attributes = attributes;
+        file.m_mode = FileMode(attributes.permissions);
+        file.m_fd = -1;
+        if (attributes.direct) {
+            // File systems without direct I/O reject the flag; those files are written normally
+            file.m_fd = ::openat(directory->fd, name, flags | O_DIRECT, 0666);
+            CountSystemCalls();
+            if (file.m_fd >= 0) {
+                // Without an aligned buffer the file is reopened for normal writes below
+                void* buffer = nullptr;
+                if (posix_memalign(&buffer, OutputFile::DirectAlignment, OutputFile::DirectChunkSize) == 0) {
+                    file.m_directBuffer.reset(static_cast<char*>(buffer));
+                } else {
+                    ::close(file.m_fd);
+                    file.m_fd = -1;
+                    CountSystemCalls();
+                }
+            }
+        }
+        if (file.m_fd < 0) {
+            file.m_fd = ::openat(directory->fd, name, flags, 0666);
+            CountSystemCalls();
+            if (file.m_fd < 0) {
+                return false;
+            }
+        }
+
+#ifdef __linux__
+        // Reserving the whole size lets the file system lay the file out in one piece.
+        // The size itself only grows as data is written; failure just leaves it unreserved.
+        if (attributes.preallocate > 0) {
+            ::fallocate(file.m_fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(attributes.preallocate));
+            CountSystemCalls();
+        }
+#endif
+        return true;
+    }
+
+    void OutputTree::RemoveFile(const std::wstring& path, OutputFile& file) {
+        if (file.m_fd >= 0) {
+            ::close(file.m_fd);
+            file.m_fd = -1;
+            CountSystemCalls();
+        }
+        std::string name;
+        DirectoryPtr directory = OpenParent(path, name);
+        if (directory) {
+            ::unlinkat(directory->fd, name.c_str(), 0);
+            CountSystemCalls();
+        }
+    }
+#endif
+
+} // namespace ArchiveEngine
@@ -0,0 +1,218 @@
+#pragma once
+
+#include "CancellationToken.h"
+#include "DirectoryCache.h"
+#include "ExtractionStats.h"
+#include "TraceRecorder.h"
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace ArchiveEngine {
+
+    // How an output file is laid out and finished
+    struct OutputFileAttributes {
+        uint32_t permissions = 0644;
+        uint64_t mtime = 0;          // Unix timestamp
+        uint64_t preallocate = 0;    // Bytes to reserve up front (fallocate); 0 reserves nothing
+        bool direct = false;         // Bypass the page cache (O_DIRECT); data must be written in order
+    };
+
+    // Extracted file being written. Data goes in at increasing offsets; gaps between
+    // writes and up to the final size read back as zeros.
+    class OutputFile {
+    public:
+        OutputFile() = default;
+        ~OutputFile();  // Closes the file without applying metadata
+
+        OutputFile(const OutputFile&) = delete;
+        OutputFile& operator=(const OutputFile&) = delete;
+
+        bool IsOpen() const;
+
+        bool Write(uint64_t offset, const char* data, size_t length);
+
+        // Writes `length` bytes read from the open file `descriptor` at `sourceOffset` to
+        // `offset`. On Linux the bytes stay in the kernel: blocks are shared with a reflink
+        // where the file system supports it and both offsets fall on block boundaries,
+        // otherwise copied with copy_file_range or spliced through a pipe. Elsewhere, or
+        // when none of these works, they are read into a buffer and written.
+        bool CopyFrom(int descriptor, uint64_t sourceOffset, uint64_t offset, uint64_t length);
+
+        // Extends the file to `fileSize` if shorter, applies the permission bits and
+        // modification time where supported, and closes it
+        bool Close(uint64_t fileSize);
+
+    private:
+        friend class OutputTree;
+
+        OutputFileAttributes m_attributes;
+        ExtractionStatsRecorder* m_stats = nullptr;
+        TraceRecorder* m_trace = nullptr;
+        const CancellationToken* m_cancellation = nullptr;  // Ends copies early once cancelled
+        ExtractionStatsRecorder::Clock::time_point m_openTime;  // Start of OpenFile, for the file's latency
+#ifdef _WIN32
+        std::ofstream m_stream;
+        std::filesystem::path m_path;
+#else
+        struct AlignedFree {
+            void operator()(char* buffer) const;
+        };
+
+        // Direct writes go through an aligned buffer and out in whole chunks; the
+        // unaligned tail is written after O_DIRECT is turned off again
+        static constexpr size_t DirectAlignment = 4096;
+        static constexpr size_t DirectChunkSize = 4 * 1024 * 1024;
+
+        bool WriteAt(uint64_t offset, const char* data, size_t length);
+        bool EndDirect();
+        bool Cancelled() const { return m_cancellation && m_cancellation->IsCancelled(); }
+
+        // Each copies what it can of the range and advances the arguments past it
+        void CloneRange(int descriptor, uint64_t& sourceOffset, uint64_t& offset, uint64_t& length);
+        void CopyRange(int descriptor, uint64_t& sourceOffset, uint64_t& offset, uint64_t& length);
+        void SpliceRange(int descriptor, uint64_t& sourceOffset, uint64_t& offset, uint64_t& length);
+
+        int m_fd = -1;
+        uint32_t m_mode = 0;  // Permission bits applied on close, already masked by the umask
+        std::unique_ptr<char[], AlignedFree> m_directBuffer;
+        size_t m_directLength = 0;  // Bytes buffered at m_end
+#endif
+        uint64_t m_end = 0;  // End of the data written so far
+        bool m_failed = false;
+    };
+
+    // What became of an output file an extraction set out to write
+    enum class FileOutcome : uint8_t {
+        Written,  // Closed with all its data
+        Lost,     // Opened, then removed, cut short or failed; its path holds no whole copy
+        Dropped   // Never opened; whatever an earlier copy left at its path stays
+    };
+
+    // Outcomes of an extraction's files by name, used to leave files not on disk whole
+    // out of the list of extracted files. Outcomes may be noted from any thread, but
+    // those of copies of one name must be noted in the order the copies were written.
+    class ExtractedFileLog {
+    public:
+        void Note(const std::wstring& name, FileOutcome outcome);
+
+        // Removes every listing of a name whose last written copy was lost, and one
+        // listing, latest first, for each copy of a name that was dropped
+        void Prune(std::vector<std::wstring>& names) const;
+
+    private:
+        struct State {
+            bool lost = false;
+            size_t dropped = 0;
+        };
+
+        std::atomic<bool> m_pruning{ false };  // Any file lost or dropped; written files are only noted after one
+        mutable std::mutex m_mutex;
+        std::unordered_map<std::wstring, State> m_files;
+    };
+
+    // Creates the directories and files of one extraction below its destination.
+    //
+    // On POSIX systems every operation is relative to an open descriptor of the parent
+    // directory (mkdirat, openat), so the kernel does not walk the full path for each
+    // file. Directories are opened with O_NOFOLLOW one level at a time from the
+    // destination down, and files with O_NOFOLLOW as well, so a symbolic link placed in
+    // the tree after the paths were validated cannot redirect output. Descriptors of
+    // recently used directories stay open. Large files can have their space reserved up
+    // front and be written with O_DIRECT on Linux. Elsewhere paths are resolved in full,
+    // with directories created once through a DirectoryCache, and the layout hints are
+    // ignored.
+    //
+    // Paths passed in are full paths below the root, as built by PathValidator. Safe to
+    // use from several threads.
+    class OutputTree {
+    public:
+        // `root` must exist already and be in canonical form. With `stats`, directory
+        // creation and each file's open, writes and close are timed into it; with
+        // `trace`, they are recorded as spans. Once `cancellation` is cancelled, copies
+        // into files stop and fail. With `files`, the writers note what became of each file.
+        explicit OutputTree(const std::wstring& root, ExtractionStatsRecorder* stats = nullptr,
+                            TraceRecorder* trace = nullptr, const CancellationToken* cancellation = nullptr,
+                            ExtractedFileLog* files = nullptr);
+        ~OutputTree();
+
+        OutputTree(const OutputTree&) = delete;
+        OutputTree& operator=(const OutputTree&) = delete;
+
+        // Ensures the directory `path` and any missing parents exist
+        bool MakeDirectory(const std::wstring& path);
+
+        // Creates or truncates the file `path` for writing, creating missing parents
+        bool OpenFile(const std::wstring& path, const OutputFileAttributes& attributes, OutputFile& file);
+
+        // Closes `file`, opened at `path`, without finishing it and removes it
+        void RemoveFile(const std::wstring& path, OutputFile& file);
+
+        ExtractionStatsRecorder* Stats() const { return m_stats; }
+        TraceRecorder* Trace() const { return m_trace; }
+        bool Cancelled() const { return m_cancellation && m_cancellation->IsCancelled(); }
+
+        // Notes the outcome of the file `name` in the tree's log, if it keeps one
+        void NoteFile(const std::wstring& name, FileOutcome outcome) const {
+            if (m_files) {
+                m_files->Note(name, outcome);
+            }
+        }
+
+#ifndef _WIN32
+        // Open directory descriptor, closed once no one refers to it
+        struct DirectoryHandle {
+            explicit DirectoryHandle(int descriptor) : fd(descriptor) {}
+            ~DirectoryHandle();
+            int fd;
+        };
+        using DirectoryPtr = std::shared_ptr<DirectoryHandle>;
+
+        // Opens the directory that will hold the file `path`, creating it if needed, for
+        // use with *at calls; `name` receives the file's name within it
+        DirectoryPtr OpenParent(const std::wstring& path, std::string& name);
+
+        // Mode a file with `permissions` gets, as masked by the process umask
+        uint32_t FileMode(uint32_t permissions) const { return permissions & 0777 & ~m_umask; }
+#endif
+
+    private:
+        std::wstring m_root;
+        ExtractionStatsRecorder* m_stats;
+        TraceRecorder* m_trace;
+        const CancellationToken* m_cancellation;
+        ExtractedFileLog* m_files;
+
+#ifdef _WIN32
+        DirectoryCache m_directories;
+#else
+        // Bytes of `path` below the root, without a leading separator
+        std::string RelativePath(const std::wstring& path) const;
+
+        // Opens (creating it if needed) the directory at `relative`; called with the lock held
+        DirectoryPtr OpenDirectory(const std::string& relative);
+
+        // Descriptors held open at once; beyond this the least recently used is closed.
+        // Archives are mostly grouped by directory, so the working set is small.
+        static constexpr size_t MaxOpenDirectories = 256;
+
+        uint32_t m_umask;  // Read when the tree is created; the engine never sets it
+        std::mutex m_mutex;
+        DirectoryPtr m_rootHandle;
+        // Most recently used first; handles in use stay valid when dropped
+        std::list<std::pair<std::string, DirectoryPtr>> m_recent;
+        std::unordered_map<std::string, std::list<std::pair<std::string, DirectoryPtr>>::iterator> m_handles;
+        // Directories made or found during this extraction, open or not
+        std::unordered_set<std::string> m_made;
+#endif
+    };
+
+} // namespace ArchiveEngine
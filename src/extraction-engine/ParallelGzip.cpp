@@ -0,0 +1,629 @@
+#include "ParallelGzip.h"
+#include "ArchiveExtractor.h"
+#include "Inflate.h"
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
+
+namespace ArchiveEngine {
+
+    // Places where decoding can start without any earlier state except the window
+    enum class GzipEntryKind : uint8_t {
+        Member,        // gzip member header; bit position of its first byte
+        DynamicBlock,  // dynamic-Huffman block; bit position of its header
+        StoredBlock    // non-final stored block; bit position of its LEN field
+    };
+
+    // Output of one chunk of the compressed file
+    struct GzipChunk {
+        // Output run inside a single member; a piece ending a member carries its trailer
+        struct Piece {
+            uint64_t length = 0;
+            uint32_t crc = 0;  // For marker pieces, computed after resolution
+            bool markers = false;
+            bool endsMember = false;
+            uint32_t trailerCrc = 0;
+            uint32_t trailerSize = 0;
+        };
+
+        uint64_t startBit = 0;
+        GzipEntryKind startKind = GzipEntryKind::Member;
+        uint64_t stopBit = 0;    // Decoding ends at the first entry point at or after this
+        bool ok = false;
+        unsigned blocks = 0;     // Blocks completed
+        uint64_t endBit = 0;
+        GzipEntryKind endKind = GzipEntryKind::Member;
+        bool streamEnd = false;  // No gzip data follows endBit
+
+        std::vector<uint16_t> markers;  // Output decoded before the window was known
+        size_t markerCount = 0;
+        std::vector<uint8_t> bytes;     // Output decoded after that, behind historySize bytes of window
+        size_t historySize = 0;
+        size_t byteCount = 0;
+        std::vector<Piece> pieces;
+        std::vector<uint8_t> resolved;  // Markers resolved against the preceding output
+    };
+
+    namespace {
+        using Status = InflateDecoder::Status;
+        constexpr size_t WindowSize = InflateDecoder::WindowSize;
+        constexpr uint64_t NoEntry = std::numeric_limits<uint64_t>::max();
+        constexpr size_t MarkerStep = 64 * 1024;
+
+        uint64_t LoadLE64(const uint8_t* p) {
+            uint64_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        // Entry point at the block boundary `inflate` is positioned on, if any
+        bool EntryAtBoundary(InflateDecoder& inflate, uint64_t& position, GzipEntryKind& kind) {
+            int header = inflate.PeekBlockHeader();
+            if (header < 0) {
+                return false;
+            }
+            if ((header >> 1) == 2) {
+                position = inflate.BitPosition();
+                kind = GzipEntryKind::DynamicBlock;
+                return true;
+            }
+            if (header == 0) {
+                // LEN follows the 3 header bits, byte-aligned
+                position = (inflate.BitPosition() + 3 + 7) & ~uint64_t(7);
+                kind = GzipEntryKind::StoredBlock;
+                return true;
+            }
+            return false;
+        }
+
+        // Lookup tables for the dynamic block screen
+        struct BlockScreenTables {
+            uint8_t header[1 << 13];     // BFINAL, BTYPE, HLIT, HDIST: BTYPE 10 and counts in range
+            uint16_t kraft[1 << 6];      // Two 3-bit precode lengths: their share of 2^7
+
+            BlockScreenTables() {
+                for (unsigned bits = 0; bits < (1u << 13); ++bits) {
+                    header[bits] = ((bits >> 1) & 3) == 2 && ((bits >> 3) & 31) <= 29 && ((bits >> 8) & 31) <= 29;
+                }
+                for (unsigned pair = 0; pair < (1u << 6); ++pair) {
+                    unsigned first = pair & 7;
+                    unsigned second = pair >> 3;
+                    kraft[pair] = static_cast<uint16_t>((first ? 128u >> first : 0) + (second ? 128u >> second : 0));
+                }
+            }
+        };
+
+        const BlockScreenTables& GetBlockScreenTables() {
+            static const BlockScreenTables tables;
+            return tables;
+        }
+
+        // Cheap screen for a dynamic block header at `bit`: BTYPE 10, in-range HLIT and
+        // HDIST and a complete precode (Kraft sum exactly 1). Branch-free past the first test.
+        bool LooksLikeDynamicBlock(const BlockScreenTables& tables, const uint8_t* data, size_t size, uint64_t bit) {
+            size_t byte = static_cast<size_t>(bit / 8);
+            if (size - byte < 16) {
+                return true; // Left to the full check
+            }
+            uint64_t header = LoadLE64(data + byte) >> (bit & 7);
+            if (!tables.header[header & 0x1fff]) {
+                return false;
+            }
+            unsigned precodeCount = static_cast<unsigned>((header >> 13) & 15) + 4;
+            uint64_t lengths = LoadLE64(data + (bit + 17) / 8) >> ((bit + 17) & 7);
+            lengths &= (uint64_t(1) << (3 * precodeCount)) - 1;
+            unsigned kraft = 0;
+            for (unsigned i = 0; i < 10; ++i, lengths >>= 6) {
+                kraft += tables.kraft[lengths & 63];
+            }
+            return kraft == 128;
+        }
+
+        // Finds the first entry point in [from, limit) whose header decodes cleanly
+        uint64_t FindEntry(const uint8_t* data, size_t size, uint64_t from, uint64_t limit,
+                           InflateDecoder& probe, GzipEntryKind& kind) {
+            const BlockScreenTables& tables = GetBlockScreenTables();
+            limit = std::min<uint64_t>(limit, uint64_t(size) * 8);
+            for (uint64_t bit = from; bit < limit; ++bit) {
+                if ((bit & 7) == 0) {
+                    size_t byte = static_cast<size_t>(bit / 8);
+
+                    size_t headerSize = 0;
+                    uint32_t mtime = 0;
+                    if (data[byte] == 0x1f && size - byte >= 18 && data[byte + 1] == 0x8b &&
+                        GzipDecoder::ParseHeader(data + byte, size - byte, headerSize, mtime)) {
+                        probe.SetInput(data, size, uint64_t(byte + headerSize) * 8);
+                        if (probe.ReadBlockHeader()) {
+                            kind = GzipEntryKind::Member;
+                            return bit;
+                        }
+                    }
+
+                    // LEN/NLEN behind three zero bits (BFINAL 0, BTYPE 00, zero padding),
+                    // followed by a block header that decodes
+                    if (byte > 0 && size - byte >= 4 && (data[byte - 1] & 0xE0) == 0) {
+                        uint32_t length = data[byte] | (data[byte + 1] << 8);
+                        uint32_t inverted = data[byte + 2] | (data[byte + 3] << 8);
+                        size_t next = byte + 4 + length;
+                        if (length == (~inverted & 0xffff) && next < size) {
+                            probe.SetInput(data, size, uint64_t(next) * 8);
+                            if (probe.ReadBlockHeader()) {
+                                kind = GzipEntryKind::StoredBlock;
+                                return bit;
+                            }
+                        }
+                    }
+                }
+
+                if (LooksLikeDynamicBlock(tables, data, size, bit)) {
+                    probe.SetInput(data, size, bit);
+                    if ((probe.PeekBlockHeader() >> 1) == 2 && probe.ReadBlockHeader()) {
+                        kind = GzipEntryKind::DynamicBlock;
+                        return bit;
+                    }
+                }
+            }
+            return NoEntry;
+        }
+
+        // Decodes from chunk.startBit up to the first entry point at or after chunk.stopBit.
+        // `window` is the output preceding a block entry when it is already known;
+        // otherwise the chunk starts out decoding markers.
+        bool DecodeChunk(const uint8_t* data, size_t size, GzipChunk& chunk, const uint8_t* window) {
+            auto inflate = std::make_unique<InflateDecoder>();
+            inflate->SetInput(data, size, chunk.startBit);
+            inflate->SetStopAtBlockEnd(true);
+
+            bool markerMode = false;
+            size_t memberStart = 0; // Where the current member's output begins in `bytes`
+            if (chunk.startKind == GzipEntryKind::Member) {
+                uint8_t magic[2];
+                if (!inflate->ReadBytes(magic, 2) || magic[0] != 0x1f || magic[1] != 0x8b) {
+                    if (chunk.startBit == 0) {
+                        return false;
+                    }
+                    // The previous chunk stopped after the last member; anything left is trailing garbage
+                    chunk.streamEnd = true;
+                    chunk.endBit = chunk.startBit;
+                    chunk.endKind = GzipEntryKind::Member;
+                    return true;
+                }
+                if (!GzipDecoder::ReadMemberHeader(*inflate)) {
+                    return false;
+                }
+            } else {
+                if (chunk.startKind == GzipEntryKind::StoredBlock && !inflate->EnterStoredBlock()) {
+                    return false;
+                }
+                if (window) {
+                    chunk.bytes.assign(window, window + WindowSize);
+                    chunk.historySize = chunk.byteCount = WindowSize;
+                } else {
+                    markerMode = true;
+                }
+            }
+
+            GzipChunk::Piece piece;
+            size_t lastMarkerEnd = 0;
+            auto finish = [&](uint64_t position, GzipEntryKind kind) {
+                if (piece.length > 0) {
+                    chunk.pieces.push_back(piece);
+                }
+                chunk.endBit = position;
+                chunk.endKind = kind;
+                return true;
+            };
+
+            for (;;) {
+                Status status;
+                if (markerMode) {
+                    size_t needed = chunk.markerCount + MarkerStep + InflateDecoder::MinOutputSpace;
+                    if (chunk.markers.size() < needed) {
+                        chunk.markers.resize(std::max(needed, chunk.markers.size() * 2));
+                    }
+                    uint16_t* begin = chunk.markers.data() + chunk.markerCount;
+                    uint16_t* out = begin;
+                    status = inflate->DecodeWithMarkers(chunk.markers.data(), out, begin + MarkerStep + InflateDecoder::MinOutputSpace);
+                    size_t produced = static_cast<size_t>(out - begin);
+                    chunk.markerCount += produced;
+                    // Scan back for the last marker; dense marker output stops at once
+                    size_t scanEnd = std::max(lastMarkerEnd, chunk.markerCount - std::min(chunk.markerCount, WindowSize));
+                    for (size_t i = chunk.markerCount; i > scanEnd; --i) {
+                        if (chunk.markers[i - 1] & InflateDecoder::MarkerFlag) {
+                            lastMarkerEnd = i;
+                            break;
+                        }
+                    }
+                    piece.length += produced;
+                    piece.markers = true;
+
+                    if (chunk.markerCount - lastMarkerEnd >= WindowSize) {
+                        // The last window holds no markers: continue with the byte decoder
+                        chunk.pieces.push_back(piece);
+                        piece = GzipChunk::Piece();
+                        chunk.bytes.resize(WindowSize + 4 * MarkerStep);
+                        const uint16_t* tail = chunk.markers.data() + chunk.markerCount - WindowSize;
+                        std::transform(tail, tail + WindowSize, chunk.bytes.begin(),
+                                       [](uint16_t symbol) { return static_cast<uint8_t>(symbol); });
+                        chunk.historySize = chunk.byteCount = WindowSize;
+                        memberStart = 0;
+                        markerMode = false;
+                    }
+                } else {
+                    if (chunk.bytes.size() - chunk.byteCount < 2 * InflateDecoder::MinOutputSpace) {
+                        chunk.bytes.resize(std::max(chunk.bytes.size() * 2, chunk.byteCount + 1024 * 1024));
+                    }
+                    uint8_t* begin = chunk.bytes.data() + chunk.byteCount;
+                    uint8_t* out = begin;
+                    status = inflate->Decode(chunk.bytes.data() + memberStart, out, chunk.bytes.data() + chunk.bytes.size());
+                    size_t produced = static_cast<size_t>(out - begin);
+                    piece.crc = Crc32(piece.crc, begin, produced);
+                    piece.length += produced;
+                    chunk.byteCount += produced;
+                }
+
+                if (status == Status::Error) {
+                    return false;
+                }
+                if (status == Status::Ok) {
+                    continue;
+                }
+                ++chunk.blocks;
+
+                uint64_t position = 0;
+                GzipEntryKind kind = GzipEntryKind::Member;
+                if (status == Status::BlockEnd) {
+                    if (EntryAtBoundary(*inflate, position, kind) && position >= chunk.stopBit) {
+                        return finish(position, kind);
+                    }
+                    continue;
+                }
+
+                // End of a member: trailer, then the next member or the end of the gzip data
+                if (!GzipDecoder::ReadMemberTrailer(*inflate, piece.trailerCrc, piece.trailerSize)) {
+                    return false;
+                }
+                piece.endsMember = true;
+                chunk.pieces.push_back(piece);
+                piece = GzipChunk::Piece();
+                if (markerMode) {
+                    markerMode = false;
+                    chunk.historySize = chunk.byteCount = 0;
+                }
+                memberStart = chunk.byteCount;
+
+                position = inflate->BitPosition();
+                if (inflate->AtEndOfInput()) {
+                    chunk.streamEnd = true;
+                    return finish(position, GzipEntryKind::Member);
+                }
+                if (position >= chunk.stopBit) {
+                    return finish(position, GzipEntryKind::Member);
+                }
+                uint8_t magic[2];
+                if (!inflate->ReadBytes(magic, 2) || magic[0] != 0x1f || magic[1] != 0x8b) {
+                    // Trailing garbage after the last member is ignored, as gzip does
+                    chunk.streamEnd = true;
+                    return finish(position, GzipEntryKind::Member);
+                }
+                if (!GzipDecoder::ReadMemberHeader(*inflate)) {
+                    return false;
+                }
+                inflate->ResetStream();
+                if (EntryAtBoundary(*inflate, position, kind) && position >= chunk.stopBit) {
+                    return finish(position, kind);
+                }
+            }
+        }
+
+        void AppendToWindow(std::vector<uint8_t>& window, const uint8_t* data, size_t length) {
+            if (length >= WindowSize) {
+                std::memcpy(window.data(), data + length - WindowSize, WindowSize);
+                return;
+            }
+            if (length == 0) {
+                return;
+            }
+            std::memmove(window.data(), window.data() + length, WindowSize - length);
+            std::memcpy(window.data() + WindowSize - length, data, length);
+        }
+
+        // Bytes of stream output a chunk decoded, markers included
+        uint64_t ChunkOutputSize(const GzipChunk& chunk) {
+            return chunk.markerCount + (chunk.byteCount - chunk.historySize);
+        }
+
+        void ResolveMarkers(const uint16_t* markers, size_t count, const uint8_t* window, uint8_t* out) {
+            // One table for both symbol kinds keeps the loop branch-free: bytes map to
+            // themselves, marker i to window[i]
+            std::vector<uint8_t> table(256 + WindowSize);
+            for (unsigned i = 0; i < 256; ++i) {
+                table[i] = static_cast<uint8_t>(i);
+            }
+            std::memcpy(table.data() + 256, window, WindowSize);
+            for (size_t i = 0; i < count; ++i) {
+                uint16_t symbol = markers[i];
+                out[i] = table[(symbol & ~InflateDecoder::MarkerFlag) + ((symbol >> 15) << 8)];
+            }
+        }
+
+        // Resolves a chunk's markers against the window preceding it and computes
+        // the CRCs of its marker pieces
+        void ResolveChunk(GzipChunk& chunk, const uint8_t* window) {
+            chunk.resolved.resize(chunk.markerCount);
+            ResolveMarkers(chunk.markers.data(), chunk.markerCount, window, chunk.resolved.data());
+            std::vector<uint16_t>().swap(chunk.markers);
+
+            // Marker pieces come first and cover the resolved output
+            size_t offset = 0;
+            for (auto& piece : chunk.pieces) {
+                if (piece.markers) {
+                    piece.crc = Crc32(0, chunk.resolved.data() + offset, static_cast<size_t>(piece.length));
+                    piece.markers = false;
+                    offset += static_cast<size_t>(piece.length);
+                }
+            }
+        }
+
+        // The 32 KB of output following `chunk`, given the 32 KB preceding it
+        std::vector<uint8_t> WindowAfter(const GzipChunk& chunk, const std::vector<uint8_t>& before) {
+            std::vector<uint8_t> window(before);
+            size_t byteLength = chunk.byteCount - chunk.historySize;
+            size_t markerTail = std::min(chunk.markerCount, WindowSize - std::min(byteLength, WindowSize));
+            if (markerTail > 0) {
+                std::vector<uint8_t> resolved(markerTail);
+                ResolveMarkers(chunk.markers.data() + chunk.markerCount - markerTail, markerTail,
+                               before.data(), resolved.data());
+                AppendToWindow(window, resolved.data(), markerTail);
+            }
+            AppendToWindow(window, chunk.bytes.data() + chunk.historySize, byteLength);
+            return window;
+        }
+    } // namespace
+
+    ParallelGzipArchiveSource::ParallelGzipArchiveSource(unsigned threadCount, size_t chunkSize)
+        : m_chunkSize(std::max<size_t>(chunkSize, 64 * 1024)),
+          m_threadCount(threadCount > 0 ? threadCount : ThreadPool::DefaultThreadCount()) {}
+
+    ParallelGzipArchiveSource::~ParallelGzipArchiveSource() = default;
+
+    bool ParallelGzipArchiveSource::Open(const std::wstring& filePath) {
+        if (!m_file.Open(filePath)) {
+            return false;
+        }
+        m_data = reinterpret_cast<const uint8_t*>(m_file.Data());
+        m_size = static_cast<size_t>(m_file.Size());
+
+        size_t headerSize = 0;
+        uint32_t mtime = 0;
+        if (!GzipDecoder::ParseHeader(m_data, m_size, headerSize, mtime)) {
+            return false;
+        }
+
+        m_chunkCount = (m_size + m_chunkSize - 1) / m_chunkSize;
+        m_window = std::make_shared<const std::vector<uint8_t>>(WindowSize, uint8_t(0));
+        m_pool = std::make_unique<ThreadPool>(m_threadCount);
+        return true;
+    }
+
+    uint64_t ParallelGzipArchiveSource::ChunkStopBit(size_t index) const {
+        return index + 1 < m_chunkCount ? uint64_t(index + 1) * m_chunkSize * 8 : NoEntry;
+    }
+
+    std::unique_ptr<GzipChunk> ParallelGzipArchiveSource::DecodeSpeculative(size_t index) const {
+        auto chunk = std::make_unique<GzipChunk>();
+        chunk->stopBit = ChunkStopBit(index);
+        if (index == 0) {
+            chunk->ok = DecodeChunk(m_data, m_size, *chunk, nullptr);
+            return chunk;
+        }
+
+        auto probe = std::make_unique<InflateDecoder>();
+        uint64_t from = uint64_t(index) * m_chunkSize * 8;
+        for (;;) {
+            GzipEntryKind kind = GzipEntryKind::Member;
+            uint64_t entry = FindEntry(m_data, m_size, from, chunk->stopBit, *probe, kind);
+            if (entry == NoEntry) {
+                return chunk;
+            }
+
+            auto attempt = std::make_unique<GzipChunk>();
+            attempt->stopBit = chunk->stopBit;
+            attempt->startBit = entry;
+            attempt->startKind = kind;
+            attempt->ok = DecodeChunk(m_data, m_size, *attempt, nullptr);
+            // A false start rarely survives two blocks; anything later is left to the in-order check
+            if (attempt->ok || attempt->blocks >= 2) {
+                return attempt;
+            }
+            from = entry + 1;
+        }
+    }
+
+    void ParallelGzipArchiveSource::SubmitChunks() {
+        // Bounded look-ahead keeps decoded-but-unread output at a few chunks per thread
+        const size_t depth = m_threadCount + 2;
+        while (m_pending.size() + m_verified.size() < depth && m_nextSubmit < m_chunkCount) {
+            size_t index = m_nextSubmit++;
+            TraceRecorder* trace = m_trace;
+            m_pending.push_back(m_pool->Submit([this, index, trace] {
+                // A chunk skipped after cancellation is never verified
+                if (Cancelled()) {
+                    return std::make_unique<GzipChunk>();
+                }
+                TraceRecorder::Span span(trace, "decompress-block");
+                std::unique_ptr<GzipChunk> chunk = DecodeSpeculative(index);
+                span.AddBytes(ChunkOutputSize(*chunk));
+                return chunk;
+            }));
+        }
+    }
+
+    bool ParallelGzipArchiveSource::VerifyNext(bool wait) {
+        if (m_streamDone || m_pending.empty()) {
+            return false;
+        }
+        if (!wait && m_pending.front().wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return false;
+        }
+        std::unique_ptr<GzipChunk> chunk = m_pending.front().get();
+        m_pending.pop_front();
+        size_t index = m_nextChunk++;
+
+        if (!chunk->ok || chunk->startBit != m_expectedBit || chunk->startKind != m_expectedKind) {
+            if (m_expectedBit >= chunk->stopBit) {
+                return true; // Range already decoded as part of the previous chunk
+            }
+            if (Cancelled()) {
+                return false;
+            }
+            // Wrong or missing speculative start: decode the range again from the verified position
+            chunk = std::make_unique<GzipChunk>();
+            chunk->startBit = m_expectedBit;
+            chunk->startKind = m_expectedKind;
+            chunk->stopBit = ChunkStopBit(index);
+            const uint8_t* window = m_expectedKind == GzipEntryKind::Member ? nullptr : m_window->data();
+            TraceRecorder::Span span(m_trace, "decompress-block");
+            if (!DecodeChunk(m_data, m_size, *chunk, window)) {
+                throw ExtractionException(L"corrupt or truncated gzip data");
+            }
+            span.AddBytes(ChunkOutputSize(*chunk));
+        }
+
+        // Only the window is needed to go on verifying; full marker resolution runs on the pool
+        auto before = m_window;
+        m_window = std::make_shared<const std::vector<uint8_t>>(WindowAfter(*chunk, *before));
+        m_expectedBit = chunk->endBit;
+        m_expectedKind = chunk->endKind;
+        m_streamDone = chunk->streamEnd;
+
+        VerifiedChunk verified;
+        if (chunk->markerCount > 0) {
+            GzipChunk* target = chunk.get();
+            TraceRecorder* trace = m_trace;
+            verified.resolution = m_pool->Submit([target, before, trace] {
+                TraceRecorder::Span span(trace, "resolve-markers", target->markerCount);
+                ResolveChunk(*target, before->data());
+            });
+        }
+        verified.chunk = std::move(chunk);
+        m_verified.push_back(std::move(verified));
+        return true;
+    }
+
+    bool ParallelGzipArchiveSource::NextChunk() {
+        m_current.reset();
+        if (Cancelled()) {
+            return false;
+        }
+        SubmitChunks();
+        while (m_verified.empty()) {
+            if (!VerifyNext(true)) {
+                return false;
+            }
+            SubmitChunks();
+        }
+        // Verify whatever is already decoded so its resolution overlaps with this chunk
+        while (VerifyNext(false)) {
+            SubmitChunks();
+        }
+
+        VerifiedChunk next = std::move(m_verified.front());
+        m_verified.pop_front();
+        if (next.resolution.valid()) {
+            next.resolution.get();
+        }
+        CheckMembers(*next.chunk);
+        SubmitChunks();
+
+        m_current = std::move(next.chunk);
+        m_inputPosition = std::min<uint64_t>(m_current->endBit / 8, m_size);
+        m_segments.clear();
+        m_segments.emplace_back(m_current->resolved.data(), m_current->resolved.size());
+        m_segments.emplace_back(m_current->bytes.data() + m_current->historySize,
+                                m_current->byteCount - m_current->historySize);
+        m_segment = 0;
+        return true;
+    }
+
+    void ParallelGzipArchiveSource::CheckMembers(const GzipChunk& chunk) {
+        for (const auto& piece : chunk.pieces) {
+            m_memberCrc = Crc32Combine(m_memberCrc, piece.crc, piece.length);
+            m_memberSize += piece.length;
+            if (piece.endsMember) {
+                if (m_memberCrc != piece.trailerCrc || static_cast<uint32_t>(m_memberSize) != piece.trailerSize) {
+                    throw ExtractionException(L"corrupt or truncated gzip data");
+                }
+                m_memberCrc = 0;
+                m_memberSize = 0;
+            }
+        }
+    }
+
+    bool ParallelGzipArchiveSource::Advance() {
+        while (m_cursor == m_cursorEnd) {
+            if (m_segment < m_segments.size()) {
+                m_cursor = m_segments[m_segment].first;
+                m_cursorEnd = m_cursor + m_segments[m_segment].second;
+                ++m_segment;
+            } else if (!NextChunk()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const char* ParallelGzipArchiveSource::ReadBlock(size_t length) {
+        if (!Advance()) {
+            return nullptr;
+        }
+        if (static_cast<size_t>(m_cursorEnd - m_cursor) >= length) {
+            const char* block = reinterpret_cast<const char*>(m_cursor);
+            m_cursor += length;
+            m_position += length;
+            return block;
+        }
+
+        // The block straddles two output segments
+        m_stitch.resize(length);
+        size_t copied = 0;
+        while (copied < length) {
+            if (!Advance()) {
+                return nullptr;
+            }
+            size_t count = std::min(length - copied, static_cast<size_t>(m_cursorEnd - m_cursor));
+            std::memcpy(m_stitch.data() + copied, m_cursor, count);
+            m_cursor += count;
+            copied += count;
+        }
+        m_position += length;
+        return m_stitch.data();
+    }
+
+    size_t ParallelGzipArchiveSource::Read(const char*& data, size_t maxLength) {
+        if (!Advance()) {
+            return 0;
+        }
+        size_t length = std::min(maxLength, static_cast<size_t>(m_cursorEnd - m_cursor));
+        data = reinterpret_cast<const char*>(m_cursor);
+        m_cursor += length;
+        m_position += length;
+        return length;
+    }
+
+    bool ParallelGzipArchiveSource::Skip(uint64_t length) {
+        while (length > 0) {
+            if (!Advance()) {
+                return false;
+            }
+            size_t skipped = static_cast<size_t>(std::min<uint64_t>(length, m_cursorEnd - m_cursor));
+            m_cursor += skipped;
+            m_position += skipped;
+            length -= skipped;
+        }
+        return true;
+    }
+
+} // namespace ArchiveEngine
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "ArchiveSource.h"
+#include "ThreadPool.h"
+#include <deque>
+#include <future>
+
+namespace ArchiveEngine {
+
+    struct GzipChunk;
+    enum class GzipEntryKind : uint8_t;
+
+    // Archive source that inflates a gzip file on a pool of threads.
+    //
+    // The compressed file is cut into fixed-size chunks that are decoded independently,
+    // each starting at the first gzip member header, dynamic-Huffman block or stored
+    // block found in it. A chunk entered in the middle of a member does not know its
+    // 32 KB window, so it decodes to 16-bit marker symbols until its own output covers
+    // a full window and then continues with the regular byte decoder.
+    //
+    // Chunks are consumed strictly in order. A chunk is only used if it starts exactly
+    // where the previous one stopped; its markers are then resolved from the preceding
+    // output and member CRCs are checked by combining per-piece CRCs. A chunk whose
+    // speculative start proves wrong is decoded again sequentially from the verified
+    // position, so guesses never reach the output.
+    class ParallelGzipArchiveSource : public IArchiveSource {
+    public:
+        static constexpr size_t DefaultChunkSize = 4 * 1024 * 1024;
+
+        explicit ParallelGzipArchiveSource(unsigned threadCount, size_t chunkSize = DefaultChunkSize);
+        ~ParallelGzipArchiveSource() override;
+
+        bool Open(const std::wstring& filePath);
+
+        const char* ReadBlock(size_t length) override;
+        size_t Read(const char*& data, size_t maxLength) override;
+        bool Skip(uint64_t length) override;
+        uint64_t Position() const override { return m_position; }
+        uint64_t InputPosition() const override { return m_inputPosition; }
+
+    private:
+        // Chunk whose start has been verified; its markers are resolved on the pool
+        struct VerifiedChunk {
+            std::unique_ptr<GzipChunk> chunk;
+            std::future<void> resolution;
+        };
+
+        bool Advance();
+        bool NextChunk();
+        bool VerifyNext(bool wait);
+        void SubmitChunks();
+        std::unique_ptr<GzipChunk> DecodeSpeculative(size_t index) const;
+        void CheckMembers(const GzipChunk& chunk);
+        uint64_t ChunkStopBit(size_t index) const;
+
+        MappedFile m_file;
+        const uint8_t* m_data = nullptr;
+        size_t m_size = 0;
+        size_t m_chunkSize;
+        size_t m_chunkCount = 0;
+        unsigned m_threadCount;
+
+        // Speculatively decoded chunks in flight, then verified ones, oldest first
+        std::deque<std::future<std::unique_ptr<GzipChunk>>> m_pending;
+        std::deque<VerifiedChunk> m_verified;
+        size_t m_nextSubmit = 0;
+        size_t m_nextChunk = 0;
+
+        // Verified stream state: where the next chunk must start and the 32 KB of output before it
+        uint64_t m_expectedBit = 0;
+        GzipEntryKind m_expectedKind{};
+        bool m_streamDone = false;
+        std::shared_ptr<const std::vector<uint8_t>> m_window;
+
+        // Member being checked as chunks are handed out
+        uint32_t m_memberCrc = 0;
+        uint64_t m_memberSize = 0;
+
+        // Output of the current chunk, handed out segment by segment
+        std::unique_ptr<GzipChunk> m_current;
+        std::vector<std::pair<const uint8_t*, size_t>> m_segments;
+        size_t m_segment = 0;
+        const uint8_t* m_cursor = nullptr;
+        const uint8_t* m_cursorEnd = nullptr;
+        std::vector<char> m_stitch;
+        uint64_t m_position = 0;
+        uint64_t m_inputPosition = 0;
+
+        // Declared last: workers are joined before the mapping goes away
+        std::unique_ptr<ThreadPool> m_pool;
+    };
+
+} // namespace ArchiveEngine
@@ -0,0 +1,211 @@
+#include "PathMatcher.h"
+#include "ArchiveExtractor.h"
+#include <algorithm>
+
+namespace ArchiveEngine {
+
+    PathMatcher::PathMatcher(const std::vector<std::wstring>& patterns) {
+        for (const auto& pattern : patterns) {
+            // Entry names are widened byte by byte, so patterns are narrowed the same way
+            std::string raw;
+            raw.reserve(pattern.size());
+            for (wchar_t ch : pattern) {
+                raw += ch == L'\\' ? '/' : static_cast<char>(ch);
+            }
+            std::string_view path = Normalize(raw);
+            if (path.empty()) {
+                continue;
+            }
+
+            if (path.find_first_of("*?") == std::string_view::npos) {
+                m_exact.emplace_back(path);
+                continue;
+            }
+
+            Glob glob;
+            for (size_t i = 0; i < path.size();) {
+                if (path[i] == '*') {
+                    if (i + 1 < path.size() && path[i + 1] == '*') {
+                        // "**/" may also match no directories at all
+                        i += 2;
+                        while (i < path.size() && path[i] == '*') {
+                            ++i;
+                        }
+                        bool slash = i < path.size() && path[i] == '/';
+                        glob.push_back({ TokenType::DoubleStar, slash ? "/" : "" });
+                        i += slash ? 1 : 0;
+                    } else {
+                        glob.push_back({ TokenType::Star, "" });
+                        ++i;
+                    }
+                } else if (path[i] == '?') {
+                    glob.push_back({ TokenType::AnyChar, "" });
+                    ++i;
+                } else {
+                    size_t end = path.find_first_of("*?", i);
+                    if (end == std::string_view::npos) {
+                        end = path.size();
+                    }
+                    glob.push_back({ TokenType::Literal, std::string(path.substr(i, end - i)) });
+                    i = end;
+                }
+            }
+            m_globs.push_back(std::move(glob));
+        }
+
+        std::sort(m_exact.begin(), m_exact.end());
+        m_exact.erase(std::unique(m_exact.begin(), m_exact.end()), m_exact.end());
+    }
+
+    bool PathMatcher::Matches(std::string_view path) const {
+        path = Normalize(path);
+        if (path.empty()) {
+            return false;
+        }
+
+        // The entry itself, then each directory above it
+        if (MatchesPrefix(path)) {
+            return true;
+        }
+        for (size_t slash = path.find('/'); slash != std::string_view::npos; slash = path.find('/', slash + 1)) {
+            if (MatchesPrefix(path.substr(0, slash))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool PathMatcher::Matches(const std::wstring& path) const {
+        std::string raw = Utils::NarrowBytes(path);
+        return Matches(std::string_view(raw));
+    }
+
+    void PathMatcher::MarkExact(std::string_view path, std::vector<bool>& matched) const {
+        path = Normalize(path);
+        if (path.empty()) {
+            return;
+        }
+        auto mark = [&](std::string_view prefix) {
+            auto it = std::lower_bound(m_exact.begin(), m_exact.end(), prefix,
+                                       [](const std::string& exact, std::string_view value) { return exact < value; });
+            if (it != m_exact.end() && *it == prefix) {
+                matched[static_cast<size_t>(it - m_exact.begin())] = true;
+            }
+        };
+        mark(path);
+        for (size_t slash = path.find('/'); slash != std::string_view::npos; slash = path.find('/', slash + 1)) {
+            mark(path.substr(0, slash));
+        }
+    }
+
+    void PathMatcher::MarkExact(const std::wstring& path, std::vector<bool>& matched) const {
+        std::string raw = Utils::NarrowBytes(path);
+        MarkExact(std::string_view(raw), matched);
+    }
+
+    std::wstring PathMatcher::Unmatched(const std::vector<bool>& matched) const {
+        std::wstring list;
+        for (size_t i = 0; i < m_exact.size(); ++i) {
+            if (!matched[i]) {
+                list += (list.empty() ? L"" : L", ") + Utils::WidenBytes(m_exact[i]);
+            }
+        }
+        return list;
+    }
+
+    std::string_view PathMatcher::Normalize(std::string_view path) {
+        while (path.size() >= 2 && path[0] == '.' && path[1] == '/') {
+            path.remove_prefix(2);
+        }
+        while (!path.empty() && path.back() == '/') {
+            path.remove_suffix(1);
+        }
+        if (path == ".") {
+            return std::string_view();
+        }
+        return path;
+    }
+
+    bool PathMatcher::MatchesPrefix(std::string_view path) const {
+        if (std::binary_search(m_exact.begin(), m_exact.end(), path,
+                               [](std::string_view a, std::string_view b) { return a < b; })) {
+            return true;
+        }
+        for (const auto& glob : m_globs) {
+            if (MatchGlob(glob, path)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool PathMatcher::MatchGlob(const Glob& glob, std::string_view path) {
+        // reachable[i]: the tokens so far can match the first i bytes of the path. Each
+        // token maps that set forward in one pass, in place, so matching takes time
+        // proportional to the tokens times the path length whatever the pattern.
+        char stackBuffer[256];
+        std::vector<char> heapBuffer;
+        char* reachable = stackBuffer;
+        if (path.size() + 1 > sizeof(stackBuffer)) {
+            heapBuffer.resize(path.size() + 1);
+            reachable = heapBuffer.data();
+        }
+        std::fill(reachable, reachable + path.size() + 1, 0);
+        reachable[0] = 1;
+
+        for (const Token& token : glob) {
+            bool any = false;
+            switch (token.type) {
+            case TokenType::Literal: {
+                // Positions only move forward, so the set is updated from the end
+                size_t length = token.literal.size();
+                for (size_t i = path.size() + 1; i-- > 0;) {
+                    reachable[i] = i >= length && reachable[i - length] &&
+                                   path.compare(i - length, length, token.literal) == 0;
+                    any = any || reachable[i];
+                }
+                break;
+            }
+            case TokenType::AnyChar:
+                for (size_t i = path.size() + 1; i-- > 0;) {
+                    reachable[i] = i >= 1 && reachable[i - 1] && path[i - 1] != '/';
+                    any = any || reachable[i];
+                }
+                break;
+            case TokenType::Star: {
+                // Any run of bytes that does not cross a separator
+                bool open = false;
+                for (size_t i = 0; i <= path.size(); ++i) {
+                    open = open || reachable[i];
+                    reachable[i] = open;
+                    any = any || open;
+                    if (i < path.size() && path[i] == '/') {
+                        open = false;
+                    }
+                }
+                break;
+            }
+            case TokenType::DoubleStar: {
+                // "**" matches any run of bytes; "**/" nothing, or any run of whole directories
+                bool open = false;
+                for (size_t i = 0; i <= path.size(); ++i) {
+                    bool start = reachable[i] != 0;
+                    if (token.literal.empty()) {
+                        reachable[i] = open || start;
+                    } else {
+                        reachable[i] = start || (open && path[i - 1] == '/');
+                    }
+                    open = open || start;
+                    any = any || reachable[i];
+                }
+                break;
+            }
+            }
+            if (!any) {
+                return false;
+            }
+        }
+        return reachable[path.size()] != 0;
+    }
+
+} // namespace ArchiveEngine
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ArchiveEngine {
+
+    // Selects archive entries by path for selective extraction.
+    //
+    // Each pattern is either an exact entry path or a glob: '*' and '?' match within one
+    // path component, '**' matches across components. A pattern that selects a directory
+    // also selects everything below it. Patterns are compiled once; matching works on the
+    // raw entry name bytes in time proportional to the pattern length times the path
+    // length, and allocates only for very long paths. Leading "./" and trailing '/' are
+    // ignored on both sides, and '\' in patterns is read as '/'.
+    class PathMatcher {
+    public:
+        explicit PathMatcher(const std::vector<std::wstring>& patterns);
+
+        bool Matches(std::string_view path) const;
+        bool Matches(const std::wstring& path) const;
+
+        // True when every pattern is an exact path, so the selection is finite
+        bool ExactOnly() const { return m_globs.empty(); }
+
+        // Number of distinct exact paths, and each of them in sorted order
+        size_t ExactCount() const { return m_exact.size(); }
+        const std::string& Exact(size_t index) const { return m_exact[index]; }
+
+        // Sets `matched[i]` for every exact path that selects `path`: the path itself or
+        // a directory above it. `matched` holds one flag per exact path.
+        void MarkExact(std::string_view path, std::vector<bool>& matched) const;
+        void MarkExact(const std::wstring& path, std::vector<bool>& matched) const;
+
+        // Exact paths whose flag in `matched` is still clear, as a list for error messages
+        std::wstring Unmatched(const std::vector<bool>& matched) const;
+
+    private:
+        enum class TokenType { Literal, AnyChar, Star, DoubleStar };
+
+        struct Token {
+            TokenType type;
+            std::string literal;
+        };
+
+        using Glob = std::vector<Token>;
+
+        static std::string_view Normalize(std::string_view path);
+        static bool MatchGlob(const Glob& glob, std::string_view path);
+        bool MatchesPrefix(std::string_view path) const;
+
+        std::vector<std::string> m_exact;  // Sorted, unique
+        std::vector<Glob> m_globs;
+    };
+
+} // namespace ArchiveEngine
@@ -0,0 +1,105 @@
+#include "PathValidator.h"
+#include <cstdint>
+#include <cwctype>
+#include <filesystem>
+#include <string_view>
+
+namespace ArchiveEngine {
+
+    namespace {
+
+        constexpr wchar_t Separator = static_cast<wchar_t>(std::filesystem::path::preferred_separator);
+
+        bool IsSeparator(wchar_t ch) {
+            return ch == L'/' || ch == L'\\';
+        }
+
+        bool IsReservedCharacter(wchar_t ch) {
+            return static_cast<uint32_t>(ch) < 32 || ch == L'<' || ch == L'>' || ch == L':' || ch == L'"' ||
+                   ch == L'|' || ch == L'?' || ch == L'*';
+        }
+
+        // Windows device names, which refer to the device in any directory
+        bool IsDeviceName(const wchar_t* name, size_t length) {
+            if (length != 3 && length != 4) {
+                return false;
+            }
+            wchar_t lower[4];
+            for (size_t i = 0; i < length; ++i) {
+                lower[i] = static_cast<wchar_t>(std::towlower(static_cast<wint_t>(name[i])));
+            }
+            std::wstring_view stem(lower, 3);
+            if (length == 3) {
+                return stem == L"con" || stem == L"prn" || stem == L"aux" || stem == L"nul";
+            }
+            return (stem == L"com" || stem == L"lpt") && lower[3] >= L'1' && lower[3] <= L'9';
+        }
+
+    } // namespace
+
+    PathValidator::PathValidator(const std::wstring& destinationPath) {
+        std::error_code ec;
+        std::filesystem::path base = std::filesystem::canonical(destinationPath, ec);
+        if (ec) {
+            base = std::filesystem::absolute(destinationPath, ec).lexically_normal();
+        }
+        m_base = base.wstring();
+        if (m_base.size() > 1 && IsSeparator(m_base.back())) {
+            m_base.pop_back();
+        }
+    }
+
+    bool PathValidator::Resolve(const std::wstring& entryPath, std::wstring& outputPath) const {
+        outputPath = m_base;
+        return Normalize(entryPath, outputPath);
+    }
+
+    bool PathValidator::Normalize(const std::wstring& entryPath, std::wstring& relative) const {
+        // Absolute paths, including drive-relative ones, never name a place in the destination
+        if (!entryPath.empty() && IsSeparator(entryPath[0])) {
+            return false;
+        }
+
+        size_t position = 0;
+        while (position < entryPath.size()) {
+            size_t end = position;
+            while (end < entryPath.size() && !IsSeparator(entryPath[end])) {
+                ++end;
+            }
+            const wchar_t* name = entryPath.data() + position;
+            size_t length = end - position;
+            position = end + 1;
+
+            if (length == 0 || (length == 1 && name[0] == L'.')) {
+                continue;
+            }
+            size_t dots = 0;
+            while (dots < length && name[dots] == L'.') {
+                ++dots;
+            }
+            if (dots == length) {
+                return false;
+            }
+
+            // Windows drops trailing dots and spaces, so "a." and "a " would alias "a"
+            size_t trimmed = length;
+            while (trimmed > 0 && (name[trimmed - 1] == L'.' || name[trimmed - 1] == L' ')) {
+                --trimmed;
+            }
+
+            relative += Separator;
+            if (trimmed == 0) {
+                relative += L'_';
+                continue;
+            }
+            for (size_t i = 0; i < trimmed; ++i) {
+                relative += IsReservedCharacter(name[i]) ? L'_' : name[i];
+            }
+            if (IsDeviceName(name, trimmed)) {
+                relative += L'_';
+            }
+        }
+        return true;
+    }
+
+} // namespace ArchiveEngine
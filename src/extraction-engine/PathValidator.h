@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+
+namespace ArchiveEngine {
+
+    // Maps archive entry paths to output paths inside one extraction destination.
+    //
+    // The destination is canonicalized once; entry paths are then checked lexically in a
+    // single pass without touching the file system. Empty and "." components are dropped,
+    // components made only of dots ("..", "...") and absolute paths are rejected, and each
+    // component is made safe for Windows: reserved characters become '_', trailing dots
+    // and spaces are trimmed and device names get a '_' suffix. '/' and '\' both separate
+    // components.
+    //
+    // Symbolic links are the one way a lexically valid path can still escape. The engine
+    // never materializes link entries (symbolic or hard), so an extraction cannot create
+    // one to write through; links already in the destination are not followed by
+    // OutputTree on POSIX systems (O_NOFOLLOW on every component).
+    class PathValidator {
+    public:
+        explicit PathValidator(const std::wstring& destinationPath);
+
+        // Canonical destination directory
+        const std::wstring& Base() const { return m_base; }
+
+        // Builds the output path of `entryPath`; false if it would not be inside the destination
+        bool Resolve(const std::wstring& entryPath, std::wstring& outputPath) const;
+
+    private:
+        // Appends the checked components of `entryPath` to `relative`, separated by the
+        // platform separator
+        bool Normalize(const std::wstring& entryPath, std::wstring& relative) const;
+
+        std::wstring m_base;
+    };
+
+} // namespace ArchiveEngine
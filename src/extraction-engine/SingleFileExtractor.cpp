@@ -0,0 +1,195 @@
+#include "SingleFileExtractor.h"
+#include "PathMatcher.h"
+#include <chrono>
+#include <cstring>
+#include <cwchar>
+#include <filesystem>
+#include <fstream>
+
+namespace ArchiveEngine {
+
+    SingleFileExtractor::SingleFileExtractor(const wchar_t* extension)
+        : m_extension(extension) {}
+
+    bool SingleFileExtractor::CanExtract(const std::wstring& filePath) const {
+        std::wstring extension = Utils::ToLowerCase(Utils::GetFileExtension(filePath));
+        return extension == m_extension;
+    }
+
+    bool SingleFileExtractor::VisitEntries(const std::wstring& filePath, const ExtractionOptions& options,
+                                           const EntryVisitor& visitor) const {
+        // The single entry is small enough to list the usual way
+        std::vector<ArchiveEntry> entries;
+        if (!GetArchiveInfo(filePath, options, entries)) {
+            return false;
+        }
+        for (const auto& entry : entries) {
+            std::string name = Utils::ToUtf8(entry.name);
+            ArchiveEntryView view;
+            view.name = name;
+            view.size = entry.size;
+            view.compressedSize = entry.compressedSize;
+            view.isDirectory = entry.isDirectory;
+            view.lastModified = entry.lastModified;
+            view.permissions = entry.permissions;
+            if (!visitor(view)) {
+                break;
+            }
+        }
+        return true;
+    }
+
+    ExtractionResult SingleFileExtractor::Extract(
+        const std::wstring& archivePath,
+        const std::wstring& destinationPath,
+        ProgressCallback callback) const {
+        return Extract(archivePath, destinationPath, ExtractionOptions(), callback);
+    }
+
+    ExtractionResult SingleFileExtractor::Extract(
+        const std::wstring& archivePath,
+        const std::wstring& destinationPath,
+        const ExtractionOptions& options,
+        ProgressCallback callback) const {
+
+        ExtractionResult result;
+        result.success = false;
+        result.bytesProcessed = 0;
+        result.totalUncompressedSize = 0;
+        result.extractedFiles.clear();
+
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        ExtractionProgress localProgress;
+        ExtractionProgress& progress = options.progress ? *options.progress : localProgress;
+        progress.Reset();
+        ProgressFinisher finisher(progress);
+        ProgressThrottle throttle(std::chrono::milliseconds(options.progressInterval));
+
+        try {
+            if (!Utils::CreateDirectoryRecursive(destinationPath)) {
+                result.errorMessage = L"Failed to create destination directory: " + destinationPath;
+                return result;
+            }
+
+            auto source = OpenSource(archivePath, options);
+            if (!source) {
+                result.errorMessage = L"Cannot open archive file: " + archivePath;
+                return result;
+            }
+            source->SetCancellation(options.cancellation.get());
+
+            std::wstring fileName = GetOutputName(archivePath);
+            std::wstring outputPath = Utils::CombinePath(destinationPath, fileName);
+
+            // There is a single member stream; progress is compressed bytes consumed
+            uint64_t totalSize = Utils::GetFileSize(archivePath);
+
+            std::ofstream outputFile(std::filesystem::path(outputPath), std::ios::binary);
+            if (!outputFile.is_open()) {
+                result.errorMessage = L"Failed to create output file: " + outputPath;
+                return result;
+            }
+
+            progress.SetTotal(totalSize);
+            progress.SetPhase(ProgressPhase::Extracting);
+
+            uint64_t processedBytes = 0;
+            const char* data = nullptr;
+            bool cancelled = false;
+            while (size_t length = source->Read(data, SIZE_MAX)) {
+                progress.SetCurrent(source->InputPosition());
+                progress.Publish();
+                if (options.Cancelled() ||
+                    (callback && throttle.Due() && !callback(source->InputPosition(), totalSize, fileName, L"Decompressing"))) {
+                    cancelled = true;
+                    break;
+                }
+                outputFile.write(data, static_cast<std::streamsize>(length));
+                processedBytes += length;
+            }
+
+            // The source also ends early once cancelled; the file cut short is removed
+            if (cancelled || options.Cancelled()) {
+                outputFile.close();
+                std::error_code ec;
+                std::filesystem::remove(std::filesystem::path(outputPath), ec);
+                result.cancelled = true;
+                result.errorMessage = L"Extraction cancelled by user";
+                return result;
+            }
+
+            if (!outputFile) {
+                result.errorMessage = L"Failed to write output file: " + outputPath;
+                return result;
+            }
+
+            progress.SetCurrent(totalSize);
+            progress.AddEntry();
+            if (callback) {
+                callback(totalSize, totalSize, L"", L"Complete");
+            }
+
+            result.extractedFiles.push_back(fileName);
+            result.success = true;
+            result.bytesProcessed = processedBytes;
+            result.totalUncompressedSize = processedBytes;
+
+        } catch (const std::exception& e) {
+            result.errorMessage = L"Exception during extraction: " +
+                std::wstring(e.what(), e.what() + strlen(e.what()));
+        }
+
+        auto endTime = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
+        result.timeElapsed = duration.count() / 1000.0;
+
+        return result;
+    }
+
+    ExtractionResult SingleFileExtractor::Extract(
+        const std::wstring& archivePath,
+        const std::wstring& destinationPath,
+        const std::vector<std::wstring>& paths,
+        const ExtractionOptions& options,
+        ProgressCallback callback) const {
+        // The decompressed file is the only entry
+        PathMatcher matcher(paths);
+        std::wstring outputName = GetOutputName(archivePath);
+        ExtractionResult result;
+        if (matcher.Matches(outputName)) {
+            result = Extract(archivePath, destinationPath, options, callback);
+        } else {
+            result.success = true;
+            result.bytesProcessed = 0;
+            result.totalUncompressedSize = 0;
+            result.timeElapsed = 0.0;
+        }
+
+        // Requested paths other than the file's own name are not in the archive
+        std::vector<bool> found(matcher.ExactCount());
+        matcher.MarkExact(outputName, found);
+        std::wstring missing = matcher.Unmatched(found);
+        if (result.success && !missing.empty()) {
+            result.success = false;
+            result.errorMessage = L"Not found in archive: " + missing;
+        }
+        return result;
+    }
+
+    std::vector<std::wstring> SingleFileExtractor::GetSupportedExtensions() const {
+        return { m_extension };
+    }
+
+    std::wstring SingleFileExtractor::GetOutputName(const std::wstring& archivePath) const {
+        std::wstring name = Utils::GetFileName(archivePath);
+        size_t extensionLength = std::wcslen(m_extension);
+        if (Utils::EndsWith(Utils::ToLowerCase(name), m_extension) && name.length() > extensionLength) {
+            name.resize(name.length() - extensionLength);
+        } else {
+            name += L".out";
+        }
+        return Utils::SanitizePath(name);
+    }
+
+} // namespace ArchiveEngine
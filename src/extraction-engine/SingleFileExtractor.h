@@ -0,0 +1,54 @@
+#pragma once
+
+#include "ArchiveExtractor.h"
+#include "ArchiveSource.h"
+
+namespace ArchiveEngine {
+
+    // Base of the extractors for formats holding one compressed file (.gz, .bz2).
+    //
+    // The only entry is named after the archive without its extension, as gunzip and
+    // bunzip2 name it. Extraction decodes the source a format opens in OpenSource into
+    // that one file, reporting progress as compressed bytes consumed; a file cut short
+    // by cancellation is removed.
+    class SingleFileExtractor : public IArchiveExtractor {
+    public:
+        using IArchiveExtractor::GetArchiveInfo;
+
+        // IArchiveExtractor implementation
+        bool CanExtract(const std::wstring& filePath) const override;
+        bool VisitEntries(const std::wstring& filePath, const ExtractionOptions& options,
+                          const EntryVisitor& visitor) const override;
+        ExtractionResult Extract(
+            const std::wstring& archivePath,
+            const std::wstring& destinationPath,
+            ProgressCallback callback = nullptr) const override;
+        ExtractionResult Extract(
+            const std::wstring& archivePath,
+            const std::wstring& destinationPath,
+            const ExtractionOptions& options,
+            ProgressCallback callback = nullptr) const override;
+        ExtractionResult Extract(
+            const std::wstring& archivePath,
+            const std::wstring& destinationPath,
+            const std::vector<std::wstring>& paths,
+            const ExtractionOptions& options,
+            ProgressCallback callback = nullptr) const override;
+        std::vector<std::wstring> GetSupportedExtensions() const override;
+
+    protected:
+        // `extension` is the lowercase extension of the format, dot included
+        explicit SingleFileExtractor(const wchar_t* extension);
+
+        // Opens the byte stream of the decompressed file
+        virtual std::unique_ptr<IArchiveSource> OpenSource(const std::wstring& filePath,
+                                                           const ExtractionOptions& options) const = 0;
+
+        // archive.txt.gz -> archive.txt; a name without the extension gets ".out" appended
+        std::wstring GetOutputName(const std::wstring& archivePath) const;
+
+    private:
+        const wchar_t* m_extension;
+    };
+
+} // namespace ArchiveEngine
@@ -0,0 +1,395 @@
+#include "TarEntryReader.h"
+#include "TarHeaderDecoder.h"
+#include <cstring>
+#include <limits>
+
+namespace ArchiveEngine {
+
+    namespace {
+
+        constexpr size_t BlockSize = 512;
+
+        // Extension headers are read into memory; anything larger is not a real one
+        constexpr uint64_t MaxMetadataSize = 16 * 1024 * 1024;
+
+        // Old GNU header layout: the sparse map replaces the ustar prefix area
+        constexpr size_t SparseEntrySize = 24;  // offset[12], numbytes[12]
+        constexpr size_t GnuSparseOffset = 386;
+        constexpr size_t GnuSparseEntries = 4;
+        constexpr size_t GnuIsExtendedOffset = 482;
+        constexpr size_t GnuRealSizeOffset = 483;
+        constexpr size_t GnuExtensionEntries = 21;
+        constexpr size_t GnuExtensionIsExtendedOffset = 504;
+
+        bool ParseDecimal(std::string_view text, uint64_t& value) {
+            if (text.empty()) {
+                return false;
+            }
+            uint64_t result = 0;
+            for (char ch : text) {
+                if (ch < '0' || ch > '9' || result > (std::numeric_limits<uint64_t>::max() - 9) / 10) {
+                    return false;
+                }
+                result = result * 10 + (ch - '0');
+            }
+            value = result;
+            return true;
+        }
+
+    } // namespace
+
+    void TarEntryReader::Pending::Clear() {
+        path.clear();
+        linkPath.clear();
+        longName.clear();
+        longLink.clear();
+        sparseName.clear();
+        sparseNumbers.clear();
+        sparseMajor = -1;
+        hasPath = hasLinkPath = hasLongName = hasLongLink = hasSparseName = false;
+        hasSize = hasMtime = hasRealSize = hasSparseBlocks = sparse = false;
+    }
+
+    TarEntryReader::Status TarEntryReader::Next(TarEntry& entry) {
+        m_pending.Clear();
+        bool extended = false;
+
+        for (;;) {
+            uint64_t offset = m_source.Position();
+            const TarHeader* header = ReadHeaderBlock();
+            if (!header) {
+                return Status::End;
+            }
+            // A non-zero block where a header belongs must be one. Skipping it would read
+            // whatever follows, possibly member data, as headers.
+            const char* block = reinterpret_cast<const char*>(header);
+            TarHeaderFields fields;
+            if (!header->IsValid() || !DecodeTarHeader(block, fields)) {
+                return Status::Corrupt;
+            }
+            if (!extended) {
+                entry.headerOffset = offset;
+            }
+
+            switch (header->typeflag) {
+            case TarFileType::PAXHeader:
+                if (!ReadPayload(fields.size, m_payload) || !ParsePaxRecords(m_payload)) {
+                    return Status::Corrupt;
+                }
+                extended = true;
+                continue;
+
+            case TarFileType::GlobalPAXHeader:
+                if (!m_source.Skip(fields.size + Padding(fields.size))) {
+                    return Status::Corrupt;
+                }
+                continue;
+
+            case TarFileType::GnuLongName:
+                if (!ReadPayload(fields.size, m_pending.longName)) {
+                    return Status::Corrupt;
+                }
+                m_pending.longName.resize(strnlen(m_pending.longName.data(), m_pending.longName.size()));
+                m_pending.hasLongName = true;
+                extended = true;
+                continue;
+
+            case TarFileType::GnuLongLink:
+                if (!ReadPayload(fields.size, m_pending.longLink)) {
+                    return Status::Corrupt;
+                }
+                m_pending.longLink.resize(strnlen(m_pending.longLink.data(), m_pending.longLink.size()));
+                m_pending.hasLongLink = true;
+                extended = true;
+                continue;
+            }
+
+            entry.type = header->typeflag;
+            entry.size = m_pending.hasSize ? m_pending.size : fields.size;
+            entry.mtime = m_pending.hasMtime ? m_pending.mtime : fields.mtime;
+            entry.permissions = fields.permissions;
+            entry.sparse = false;
+            entry.regions.clear();
+
+            if (m_pending.hasSparseName) {
+                entry.name = m_pending.sparseName;
+            } else if (m_pending.hasPath) {
+                entry.name = m_pending.path;
+            } else if (m_pending.hasLongName) {
+                entry.name = m_pending.longName;
+            } else {
+                entry.name = header->GetRawFileName(m_nameBuffer);
+            }
+            if (m_pending.hasLinkPath) {
+                entry.linkName = m_pending.linkPath;
+            } else if (m_pending.hasLongLink) {
+                entry.linkName = m_pending.longLink;
+            } else {
+                entry.linkName = header->GetRawLinkName();
+            }
+
+            // Sparse maps may continue past the header block, which invalidates it
+            if (entry.type == TarFileType::GnuSparse || m_pending.sparse) {
+                DetachNames(header, entry);
+                bool mapped = entry.type == TarFileType::GnuSparse
+                    ? ReadGnuSparseMap(block, entry)
+                    : ReadPaxSparseMap(entry);
+                if (!mapped || !ValidateSparseMap(entry)) {
+                    return Status::Corrupt;
+                }
+                entry.type = TarFileType::RegularFile;
+            } else {
+                entry.realSize = entry.size;
+            }
+
+            entry.dataOffset = m_source.Position();
+            return Status::Entry;
+        }
+    }
+
+    bool TarEntryReader::SkipData(const TarEntry& entry) {
+        uint64_t length = entry.size + Padding(entry.size);
+        return length == 0 || m_source.Skip(length);
+    }
+
+    const TarHeader* TarEntryReader::ReadHeaderBlock() {
+        // The header is used in place; no copy out of the source buffer
+        const char* block = m_source.ReadBlock(BlockSize);
+        if (block && IsZeroBlock(block)) {
+            // Two zero blocks end the archive; whatever padding follows is never read.
+            // A lone zero block is skipped.
+            block = m_source.ReadBlock(BlockSize);
+            if (!block || IsZeroBlock(block)) {
+                return nullptr;
+            }
+        }
+        return reinterpret_cast<const TarHeader*>(block);
+    }
+
+    bool TarEntryReader::ReadPayload(uint64_t size, std::string& data) {
+        if (size > MaxMetadataSize) {
+            return false;
+        }
+        data.clear();
+        uint64_t remaining = size;
+        while (remaining > 0) {
+            const char* chunk = nullptr;
+            size_t bytesRead = m_source.Read(chunk, static_cast<size_t>(remaining));
+            if (bytesRead == 0) {
+                return false;
+            }
+            data.append(chunk, bytesRead);
+            remaining -= bytesRead;
+        }
+        uint64_t padding = Padding(size);
+        return padding == 0 || m_source.Skip(padding);
+    }
+
+    bool TarEntryReader::ParsePaxRecords(std::string_view data) {
+        // Each record is "<length> <key>=<value>\n", the length counting the whole record
+        while (!data.empty()) {
+            size_t space = data.find(' ');
+            uint64_t length = 0;
+            if (space == std::string_view::npos || !ParseDecimal(data.substr(0, space), length) ||
+                length > data.size() || length < space + 3 || data[length - 1] != '\n') {
+                return false;
+            }
+            std::string_view record = data.substr(space + 1, length - space - 2);
+            size_t equals = record.find('=');
+            if (equals == std::string_view::npos ||
+                !ApplyPaxRecord(record.substr(0, equals), record.substr(equals + 1))) {
+                return false;
+            }
+            data.remove_prefix(length);
+        }
+        return true;
+    }
+
+    bool TarEntryReader::ApplyPaxRecord(std::string_view key, std::string_view value) {
+        Pending& pending = m_pending;
+        if (key == "path") {
+            pending.path.assign(value);
+            pending.hasPath = true;
+        } else if (key == "linkpath") {
+            pending.linkPath.assign(value);
+            pending.hasLinkPath = true;
+        } else if (key == "size") {
+            pending.hasSize = ParseDecimal(value, pending.size);
+            return pending.hasSize;
+        } else if (key == "mtime") {
+            // Fractional seconds are dropped; times before 1970 are not representable here
+            pending.hasMtime = ParseDecimal(value.substr(0, value.find('.')), pending.mtime);
+        } else if (key == "GNU.sparse.major") {
+            uint64_t major = 0;
+            if (!ParseDecimal(value, major)) {
+                return false;
+            }
+            pending.sparseMajor = static_cast<int>(major);
+            pending.sparse = true;
+        } else if (key == "GNU.sparse.name") {
+            pending.sparseName.assign(value);
+            pending.hasSparseName = true;
+        } else if (key == "GNU.sparse.realsize" || key == "GNU.sparse.size") {
+            pending.hasRealSize = ParseDecimal(value, pending.realSize);
+            return pending.hasRealSize;
+        } else if (key == "GNU.sparse.numblocks") {
+            pending.hasSparseBlocks = ParseDecimal(value, pending.sparseBlocks);
+            pending.sparse = true;
+            return pending.hasSparseBlocks;
+        } else if (key == "GNU.sparse.offset" || key == "GNU.sparse.numbytes") {
+            // Format 0.0 repeats these keys, one pair per region
+            uint64_t number = 0;
+            if (!ParseDecimal(value, number)) {
+                return false;
+            }
+            pending.sparseNumbers.push_back(number);
+            pending.sparse = true;
+        } else if (key == "GNU.sparse.map") {
+            // Format 0.1: "offset,length,offset,length,..."
+            while (!value.empty()) {
+                size_t comma = value.find(',');
+                uint64_t number = 0;
+                if (!ParseDecimal(value.substr(0, comma), number)) {
+                    return false;
+                }
+                pending.sparseNumbers.push_back(number);
+                value = comma == std::string_view::npos ? std::string_view() : value.substr(comma + 1);
+            }
+            pending.sparse = true;
+        }
+        return true;
+    }
+
+    bool TarEntryReader::ReadGnuSparseMap(const char* header, TarEntry& entry) {
+        entry.sparse = true;
+
+        // An entry with an empty offset ends the map in its block
+        auto parseEntries = [&entry](const char* base, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                const char* field = base + i * SparseEntrySize;
+                if (field[0] == '\0') {
+                    break;
+                }
+                SparseRegion region;
+                if (!ParseTarNumber(field, 12, region.offset) || !ParseTarNumber(field + 12, 12, region.length)) {
+                    return false;
+                }
+                entry.regions.push_back(region);
+            }
+            return true;
+        };
+
+        if (!parseEntries(header + GnuSparseOffset, GnuSparseEntries) ||
+            !ParseTarNumber(header + GnuRealSizeOffset, 12, entry.realSize)) {
+            return false;
+        }
+        bool extended = header[GnuIsExtendedOffset] != 0;
+        while (extended) {
+            const char* block = m_source.ReadBlock(BlockSize);
+            if (!block || !parseEntries(block, GnuExtensionEntries)) {
+                return false;
+            }
+            extended = block[GnuExtensionIsExtendedOffset] != 0;
+        }
+        return true;
+    }
+
+    bool TarEntryReader::ReadPaxSparseMap(TarEntry& entry) {
+        entry.sparse = true;
+
+        if (m_pending.sparseMajor >= 1) {
+            // Format 1.0: the map leads the payload as decimal lines (region count, then
+            // offset and length of each region), padded to a whole block
+            uint64_t number = 0;
+            bool digits = false;
+            bool haveCount = false;
+            uint64_t count = 0;
+            uint64_t parsed = 0;
+            uint64_t offset = 0;
+            while (!haveCount || parsed < count * 2) {
+                if (entry.size < BlockSize) {
+                    return false;
+                }
+                const char* block = m_source.ReadBlock(BlockSize);
+                if (!block) {
+                    return false;
+                }
+                entry.size -= BlockSize;
+
+                for (size_t i = 0; i < BlockSize && (!haveCount || parsed < count * 2); ++i) {
+                    char ch = block[i];
+                    if (ch >= '0' && ch <= '9') {
+                        if (number > (std::numeric_limits<uint64_t>::max() - 9) / 10) {
+                            return false;
+                        }
+                        number = number * 10 + (ch - '0');
+                        digits = true;
+                        continue;
+                    }
+                    if (ch != '\n' || !digits) {
+                        return false;
+                    }
+                    if (!haveCount) {
+                        if (number > std::numeric_limits<uint64_t>::max() / 2) {
+                            return false;
+                        }
+                        count = number;
+                        haveCount = true;
+                    } else if (parsed++ % 2 == 0) {
+                        offset = number;
+                    } else {
+                        entry.regions.push_back({ offset, number });
+                    }
+                    number = 0;
+                    digits = false;
+                }
+            }
+        } else {
+            // Formats 0.0 and 0.1 carry the map in the extended header
+            const std::vector<uint64_t>& numbers = m_pending.sparseNumbers;
+            if (numbers.size() % 2 != 0 ||
+                (m_pending.hasSparseBlocks && m_pending.sparseBlocks != numbers.size() / 2)) {
+                return false;
+            }
+            for (size_t i = 0; i < numbers.size(); i += 2) {
+                entry.regions.push_back({ numbers[i], numbers[i + 1] });
+            }
+        }
+
+        if (m_pending.hasRealSize) {
+            entry.realSize = m_pending.realSize;
+        } else {
+            entry.realSize = entry.regions.empty() ? 0 : entry.regions.back().offset + entry.regions.back().length;
+        }
+        return true;
+    }
+
+    void TarEntryReader::DetachNames(const TarHeader* header, TarEntry& entry) {
+        const char* begin = reinterpret_cast<const char*>(header);
+        const char* end = begin + sizeof(TarHeader);
+        if (entry.name.data() >= begin && entry.name.data() < end) {
+            m_nameBuffer.assign(entry.name.data(), entry.name.size());
+            entry.name = m_nameBuffer;
+        }
+        if (entry.linkName.data() >= begin && entry.linkName.data() < end) {
+            m_linkBuffer.assign(entry.linkName.data(), entry.linkName.size());
+            entry.linkName = m_linkBuffer;
+        }
+    }
+
+    bool TarEntryReader::ValidateSparseMap(const TarEntry& entry) const {
+        // Regions must be in order, inside the file, and account for the whole payload
+        uint64_t end = 0;
+        uint64_t stored = 0;
+        for (const auto& region : entry.regions) {
+            if (region.offset < end || region.length > entry.realSize ||
+                region.offset > entry.realSize - region.length) {
+                return false;
+            }
+            end = region.offset + region.length;
+            stored += region.length;
+        }
+        return stored == entry.size;
+    }
+
+} // namespace ArchiveEngine
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "ArchiveSource.h"
+#include "TarExtractor.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ArchiveEngine {
+
+    // Stored data region of a sparse file; the rest of the file reads as zeros
+    struct SparseRegion {
+        uint64_t offset;
+        uint64_t length;
+    };
+
+    // One archive member with its GNU and PAX extension headers applied
+    struct TarEntry {
+        std::string_view name;        // Valid until the next call to TarEntryReader::Next
+        std::string_view linkName;
+        char type;                    // TarFileType flag; sparse files report RegularFile
+        uint64_t size;                // Payload bytes to read, excluding padding
+        uint64_t realSize;            // Size of the extracted file
+        uint64_t mtime;
+        uint32_t permissions;
+        uint64_t headerOffset;        // Offset of the member's first header in the TAR stream
+        uint64_t dataOffset;          // Offset of the payload in the TAR stream
+        bool sparse;
+        std::vector<SparseRegion> regions;  // Where the payload of a sparse file goes, in order
+
+        bool IsDirectory() const { return type == TarFileType::Directory; }
+        bool IsRegularFile() const {
+            return type == TarFileType::RegularFile || type == TarFileType::AlternateRegularFile;
+        }
+    };
+
+    // Reads archive members from a TAR stream.
+    //
+    // GNU long names ('L', 'K'), PAX extended headers (path, linkpath, size, mtime) and
+    // sparse files are folded into the member they describe: old GNU sparse ('S') and
+    // PAX sparse formats 0.0, 0.1 and 1.0. Global PAX headers and blocks without a ustar
+    // magic are skipped. Reading ends at the end-of-archive marker.
+    class TarEntryReader {
+    public:
+        enum class Status { Entry, End, Corrupt };
+
+        explicit TarEntryReader(IArchiveSource& source) : m_source(source) {}
+
+        // Reads the next member's headers. The caller then reads exactly `size` payload
+        // bytes and skips the padding, or calls SkipData.
+        Status Next(TarEntry& entry);
+
+        // Skips the payload and padding of the member returned last
+        bool SkipData(const TarEntry& entry);
+
+        // Bytes of padding after a payload of `size` bytes
+        static uint64_t Padding(uint64_t size) { return (512 - size % 512) % 512; }
+
+    private:
+        // Metadata from extension headers, applied to the next member. Cleared rather
+        // than replaced so the strings keep their capacity.
+        struct Pending {
+            std::string path;
+            std::string linkPath;
+            std::string longName;
+            std::string longLink;
+            std::string sparseName;
+            std::vector<uint64_t> sparseNumbers;  // Offset, length pairs of PAX 0.0 and 0.1
+            uint64_t size = 0;
+            uint64_t mtime = 0;
+            uint64_t realSize = 0;
+            uint64_t sparseBlocks = 0;
+            int sparseMajor = -1;
+            bool hasPath = false;
+            bool hasLinkPath = false;
+            bool hasLongName = false;
+            bool hasLongLink = false;
+            bool hasSparseName = false;
+            bool hasSize = false;
+            bool hasMtime = false;
+            bool hasRealSize = false;
+            bool hasSparseBlocks = false;
+            bool sparse = false;
+
+            void Clear();
+        };
+
+        const TarHeader* ReadHeaderBlock();
+        bool ReadPayload(uint64_t size, std::string& data);
+        bool ParsePaxRecords(std::string_view data);
+        bool ApplyPaxRecord(std::string_view key, std::string_view value);
+        bool ReadGnuSparseMap(const char* header, TarEntry& entry);
+        bool ReadPaxSparseMap(TarEntry& entry);
+        void DetachNames(const TarHeader* header, TarEntry& entry);
+        bool ValidateSparseMap(const TarEntry& entry) const;
+
+        IArchiveSource& m_source;
+        Pending m_pending;
+        std::string m_nameBuffer;
+        std::string m_linkBuffer;
+        std::string m_payload;
+    };
+
+} // namespace ArchiveEngine
@@ -1,5 +1,11 @@
 #include "TarExtractor.h"
+#include "ArchiveIndex.h"
+#include "TarEntryReader.h"
+#include "TarHeaderDecoder.h"
+#include "PathValidator.h"
+#include <algorithm>
 #include <fstream>
+#include <filesystem>
 #include <iostream>
 #include <chrono>
 #include <cstring>
@@ -12,67 +18,22 @@ namespace ArchiveEngine {
         return (strncmp(magic, "ustar", 5) == 0);
     }
 
-    uint64_t TarHeader::GetFileSize() const {
-        // Convert octal string to decimal
-        uint64_t result = 0;
-        for (int i = 0; i < 11 && size[i] != '\0' && size[i] != ' '; ++i) {
-            if (size[i] >= '0' && size[i] <= '7') {
-                result = result * 8 + (size[i] - '0');
-            }
-        }
-        return result;
-    }
-
-    uint64_t TarHeader::GetModificationTime() const {
-        uint64_t result = 0;
-        for (int i = 0; i < 11 && mtime[i] != '\0' && mtime[i] != ' '; ++i) {
-            if (mtime[i] >= '0' && mtime[i] <= '7') {
-                result = result * 8 + (mtime[i] - '0');
-            }
-        }
-        return result;
-    }
-
-    std::wstring TarHeader::GetFileName() const {
-        std::string fullName;
+    std::string_view TarHeader::GetRawFileName(std::string& buffer) const {
+        std::string_view baseName(name, strnlen(name, sizeof(name)));
         
-        // Check if prefix is used
-        if (prefix[0] != '\0') {
-            fullName = std::string(prefix, strnlen(prefix, sizeof(prefix)));
-            fullName += "/";
+        // Check if prefix is used; only then is the path assembled in the buffer.
+        // GNU headers ("ustar  ") keep other fields where ustar has the prefix.
+        if (prefix[0] == '\0' || std::memcmp(magic, "ustar ", 6) == 0) {
+            return baseName;
         }
-        
-        fullName += std::string(name, strnlen(name, sizeof(name)));
-        
-        // Convert to wide string
-        return std::wstring(fullName.begin(), fullName.end());
-    }
-
-    std::wstring TarHeader::GetLinkName() const {
-        std::string link = std::string(linkname, strnlen(linkname, sizeof(linkname)));
-        return std::wstring(link.begin(), link.end());
-    }
-
-    bool TarHeader::IsDirectory() const {
-        return typeflag == TarFileType::Directory;
+        buffer.assign(prefix, strnlen(prefix, sizeof(prefix)));
+        buffer += '/';
+        buffer.append(baseName);
+        return buffer;
     }
 
-    bool TarHeader::IsRegularFile() const {
-        return typeflag == TarFileType::RegularFile || typeflag == TarFileType::AlternateRegularFile;
-    }
-
-    bool TarHeader::IsSymbolicLink() const {
-        return typeflag == TarFileType::SymbolicLink;
-    }
-
-    uint32_t TarHeader::GetPermissions() const {
-        uint32_t result = 0;
-        for (int i = 0; i < 7 && mode[i] != '\0' && mode[i] != ' '; ++i) {
-            if (mode[i] >= '0' && mode[i] <= '7') {
-                result = result * 8 + (mode[i] - '0');
-            }
-        }
-        return result;
+    std::string_view TarHeader::GetRawLinkName() const {
+        return std::string_view(linkname, strnlen(linkname, sizeof(linkname)));
     }
 
     // TarExtractor implementation
@@ -82,55 +43,195 @@ namespace ArchiveEngine {
     }
 
     bool TarExtractor::GetArchiveInfo(const std::wstring& filePath, std::vector<ArchiveEntry>& entries) const {
+        return GetArchiveInfo(filePath, ExtractionOptions(), entries);
+    }
+
+    bool TarExtractor::GetArchiveInfo(const std::wstring& filePath, const ExtractionOptions& options,
+                                      std::vector<ArchiveEntry>& entries) const {
         entries.clear();
-        
-        std::ifstream file(filePath, std::ios::binary);
-        if (!file.is_open()) {
-            return false;
-        }
+        return VisitEntries(filePath, options, [&entries](const ArchiveEntryView& view) {
+            ArchiveEntry entry;
+            entry.name = Utils::WidenBytes(view.name);
+            entry.size = view.size;
+            entry.compressedSize = view.compressedSize;
+            entry.isDirectory = view.isDirectory;
+            entry.lastModified = view.lastModified;
+            entry.permissions = view.permissions;
+            entry.linkTarget = Utils::WidenBytes(view.linkTarget);
+            entries.push_back(std::move(entry));
+            return true;
+        });
+    }
 
-        TarHeader header;
-        while (ReadTarHeader(file, header)) {
-            if (!header.IsValid()) {
-                // Skip invalid headers or end of archive
-                continue;
+    bool TarExtractor::VisitEntries(const std::wstring& filePath, const ExtractionOptions& options,
+                                    const EntryVisitor& visitor) const {
+        // A current index answers the listing without touching the archive
+        if (options.useIndex) {
+            ArchiveIndex index;
+            if (index.Load(filePath)) {
+                for (size_t i = 0; i < index.Size(); ++i) {
+                    IndexEntry indexed = index.Entry(i);
+                    ArchiveEntryView entry;
+                    entry.name = indexed.name;
+                    entry.linkTarget = indexed.linkTarget;
+                    entry.size = indexed.size;
+                    entry.compressedSize = indexed.storedSize;
+                    entry.isDirectory = indexed.type == TarFileType::Directory;
+                    entry.lastModified = indexed.mtime;
+                    entry.permissions = indexed.permissions;
+                    if (!visitor(entry)) {
+                        break;
+                    }
+                }
+                return true;
+            }
+        }
+        
+        // Compressed sources throw on corrupt or truncated data; the listing just fails
+        try {
+            auto source = OpenSource(filePath, options);
+            if (!source) {
+                return false;
             }
+            ArchiveIndexWriter indexWriter;
+            TarEntryReader reader(*source);
+            TarEntry member;
+
+            for (;;) {
+                TarEntryReader::Status status = reader.Next(member);
+                if (status == TarEntryReader::Status::End) {
+                    break;
+                }
+                if (status == TarEntryReader::Status::Corrupt) {
+                    // A corrupt header leaves the position of the next one unknown
+                    return false;
+                }
 
-            ArchiveEntry entry;
-            entry.name = header.GetFileName();
-            entry.size = header.GetFileSize();
-            entry.compressedSize = header.GetFileSize(); // TAR is uncompressed
-            entry.isDirectory = header.IsDirectory();
-            entry.lastModified = header.GetModificationTime();
-            entry.permissions = header.GetPermissions();
-            entry.linkTarget = header.GetLinkName();
+                // Names are viewed in place in the header block; only prefixed paths are assembled
+                ArchiveEntryView entry;
+                entry.name = member.name;
+                entry.linkTarget = member.linkName;
+                entry.size = member.realSize;
+                entry.compressedSize = member.size; // TAR is uncompressed; sparse files store less
+                entry.isDirectory = member.IsDirectory();
+                entry.lastModified = member.mtime;
+                entry.permissions = member.permissions;
+
+                if (options.useIndex) {
+                    indexWriter.Add(entry.name, entry.linkTarget, member.headerOffset, member.dataOffset,
+                                    entry.size, member.size, entry.lastModified, entry.permissions, member.type);
+                }
 
-            entries.push_back(entry);
+                // A listing cut short is not indexed
+                if (!visitor(entry)) {
+                    return true;
+                }
 
-            // Skip file data
-            uint64_t fileSize = header.GetFileSize();
-            if (fileSize > 0) {
-                // Calculate blocks (TAR uses 512-byte blocks)
-                uint64_t blocks = (fileSize + 511) / 512;
-                file.seekg(blocks * 512, std::ios::cur);
+                // Skip file data
+                reader.SkipData(member);
+            }
+
+            // The listing stands even if the index cannot be written
+            if (options.useIndex) {
+                indexWriter.Save(filePath);
             }
+
+            return true;
+        } catch (const ExtractionException&) {
+            return false;
         }
+    }
+
+    ExtractionResult TarExtractor::Extract(
+        const std::wstring& archivePath,
+        const std::wstring& destinationPath,
+        ProgressCallback callback) const {
+        return Extract(archivePath, destinationPath, ExtractionOptions(), callback);
+    }
 
-        return true;
+    ExtractionResult TarExtractor::Extract(
+        const std::wstring& archivePath,
+        const std::wstring& destinationPath,
+        const ExtractionOptions& options,
+        ProgressCallback callback) const {
+        return ExtractEntries(archivePath, destinationPath, nullptr, options, callback);
     }
 
     ExtractionResult TarExtractor::Extract(
         const std::wstring& archivePath,
         const std::wstring& destinationPath,
+        const std::vector<std::wstring>& paths,
+        const ExtractionOptions& options,
+        ProgressCallback callback) const {
+        PathMatcher matcher(paths);
+        return ExtractEntries(archivePath, destinationPath, &matcher, options, callback);
+    }
+
+    ExtractionResult TarExtractor::ExtractEntries(
+        const std::wstring& archivePath,
+        const std::wstring& destinationPath,
+        const PathMatcher* matcher,
+        const ExtractionOptions& options,
         ProgressCallback callback) const {
+        std::unique_ptr<ExtractionStatsRecorder> stats;
+        if (options.collectStats) {
+            stats = std::make_unique<ExtractionStatsRecorder>();
+        }
+        std::unique_ptr<TraceRecorder> trace;
+        if (!options.tracePath.empty()) {
+            trace = std::make_unique<TraceRecorder>();
+        }
+
+        // Statistics and traces are kept for failed extractions as well. All threads
+        // recording into them have been joined by the time the extraction returns.
+        ExtractedFileLog files;
+        ExtractionResult result = ExtractEntries(archivePath, destinationPath, matcher, options, callback,
+                                                 stats.get(), trace.get(), files);
+
+        // Files are listed as they are handed over; those a writer later removed or never
+        // got to, as after cancellation, are taken off the list again
+        files.Prune(result.extractedFiles);
+
+        // Whatever failed once cancellation was requested failed because of it
+        if (!result.success && options.Cancelled()) {
+            result.cancelled = true;
+            result.errorMessage = L"Extraction cancelled by user";
+        }
+        if (stats) {
+            auto snapshot = std::make_shared<ExtractionStats>();
+            stats->Fill(*snapshot);
+            result.stats = std::move(snapshot);
+        }
+        if (trace) {
+            trace->Write(options.tracePath);
+        }
+        return result;
+    }
+
+    ExtractionResult TarExtractor::ExtractEntries(
+        const std::wstring& archivePath,
+        const std::wstring& destinationPath,
+        const PathMatcher* matcher,
+        const ExtractionOptions& options,
+        ProgressCallback callback,
+        ExtractionStatsRecorder* stats,
+        TraceRecorder* trace,
+        ExtractedFileLog& files) const {
         
         ExtractionResult result;
         result.success = false;
         result.bytesProcessed = 0;
+        result.totalUncompressedSize = 0;
         result.extractedFiles.clear();
         
         auto startTime = std::chrono::high_resolution_clock::now();
 
+        ExtractionProgress localProgress;
+        ExtractionProgress& progress = options.progress ? *options.progress : localProgress;
+        progress.Reset();
+        ProgressFinisher finisher(progress);
+        ProgressThrottle throttle(std::chrono::milliseconds(options.progressInterval));
+
         try {
             // Ensure destination directory exists
             if (!Utils::CreateDirectoryRecursive(destinationPath)) {
@@ -138,80 +239,265 @@ namespace ArchiveEngine {
                 return result;
             }
 
-            std::ifstream file(archivePath, std::ios::binary);
-            if (!file.is_open()) {
+            // Entry paths are checked against the destination resolved once here; outputs are
+            // created relative to open directory handles below it
+            PathValidator paths(destinationPath);
+            OutputTree output(paths.Base(), stats, trace, options.cancellation.get(), &files);
+
+            auto source = OpenSource(archivePath, options);
+            if (!source) {
                 result.errorMessage = L"Cannot open archive file: " + archivePath;
                 return result;
             }
+            source->SetTrace(trace);
+            source->SetCancellation(options.cancellation.get());
 
-            // Get total size for progress reporting
-            uint64_t totalSize = GetTotalUncompressedSize(archivePath);
-            uint64_t processedBytes = 0;
+            // Files are handed to the writers and closed in the background while reading goes on
+            std::unique_ptr<FileWriterPool> writers;
+            if (options.writerThreads > 0) {
+                writers = std::make_unique<FileWriterPool>(options.writerThreads, options.writeBufferBudget, output);
+            }
+            std::wstring failedName;
+
+            // Small files are written in batches where io_uring is available
+            std::unique_ptr<UringFileWriter> batch;
+            if (options.batchSmallFiles) {
+                batch = std::make_unique<UringFileWriter>(output);
+                if (!batch->IsAvailable()) {
+                    batch.reset();
+                }
+            }
 
-            TarHeader header;
-            while (ReadTarHeader(file, header)) {
-                if (!header.IsValid()) {
-                    // Check if we've hit the end of the archive (two consecutive null blocks)
-                    file.seekg(-512, std::ios::cur);
-                    char testBlock[512];
-                    file.read(testBlock, 512);
-                    bool isNullBlock = true;
-                    for (int i = 0; i < 512; ++i) {
-                        if (testBlock[i] != 0) {
-                            isNullBlock = false;
-                            break;
+            ArchiveIndex index;
+            bool indexed = options.useIndex && index.Load(archivePath);
+            ArchiveIndexWriter indexWriter;
+
+            // With an index, a selection becomes the list of headers to visit; the source
+            // seeks (or for compressed archives, decodes) straight past everything else
+            std::vector<uint64_t> selectedHeaders;
+            bool useSelection = matcher && indexed;
+            uint64_t totalSize = 0;
+            bool lookedUp = false;
+            if (useSelection && matcher->ExactOnly()) {
+                // Exact paths of files are looked up by name, which finds the last copy of each.
+                // A directory, or a path stored in another form ("./name"), needs the scan below.
+                lookedUp = true;
+                for (size_t i = 0; i < matcher->ExactCount(); ++i) {
+                    size_t position = index.Find(matcher->Exact(i));
+                    if (position == ArchiveIndex::NotFound || index.Entry(position).type == TarFileType::Directory) {
+                        lookedUp = false;
+                        break;
+                    }
+                    IndexEntry entry = index.Entry(position);
+                    selectedHeaders.push_back(entry.headerOffset);
+                    totalSize += entry.size;
+                }
+                if (lookedUp) {
+                    std::sort(selectedHeaders.begin(), selectedHeaders.end());
+                } else {
+                    selectedHeaders.clear();
+                    totalSize = 0;
+                }
+            }
+            if (indexed && !lookedUp) {
+                for (size_t i = 0; i < index.Size(); ++i) {
+                    IndexEntry entry = index.Entry(i);
+                    if (useSelection) {
+                        if (!matcher->Matches(entry.name)) {
+                            continue;
                         }
+                        selectedHeaders.push_back(entry.headerOffset);
+                    }
+                    totalSize += entry.size;
+                }
+            }
+
+            // Get total size for progress reporting. In single-pass mode the denominator
+            // is the archive size and progress is the archive offset, so no pre-scan is needed.
+            // A current index supplies the exact total without a pre-scan either; a selection
+            // without one reports the archive offset rather than scan the archive twice.
+            bool offsetProgress = options.singlePass || (matcher && !indexed);
+            if (offsetProgress) {
+                totalSize = Utils::GetFileSize(archivePath);
+            } else if (!indexed) {
+                progress.SetPhase(ProgressPhase::Scanning);
+                totalSize = GetTotalUncompressedSize(archivePath);
+            }
+            uint64_t processedBytes = 0;
+            progress.SetTotal(totalSize);
+            progress.SetPhase(ProgressPhase::Extracting);
+
+            // Exact paths seen so far, for reporting those the archive does not hold. Without
+            // an index the whole archive is read even once all of them have been seen: a path
+            // stored again further on (an appended update) replaces the earlier copy.
+            std::vector<bool> found(matcher ? matcher->ExactCount() : 0);
+            size_t nextSelected = 0;
+            TarEntryReader reader(*source);
+            TarEntry entry;
+
+            for (;;) {
+                if (options.Cancelled()) {
+                    return result;
+                }
+                if (useSelection) {
+                    if (nextSelected == selectedHeaders.size()) {
+                        break;
                     }
-                    if (isNullBlock) {
-                        break; // End of archive
+                    uint64_t offset = selectedHeaders[nextSelected++];
+                    if (offset < source->Position() || !source->Skip(offset - source->Position())) {
+                        result.errorMessage = L"Archive index does not match archive: " + archivePath;
+                        return result;
                     }
+                }
+
+                // Checksum and numeric fields are checked before anything is created on disk
+                TarEntryReader::Status status;
+                {
+                    uint64_t headerStart = source->Position();
+                    ExtractionStatsRecorder::Scope scope(stats, ExtractionPhase::ReadHeader);
+                    TraceRecorder::Span span(trace, "read-header");
+                    status = reader.Next(entry);
+                    scope.AddBytes(source->Position() - headerStart);
+                    span.AddBytes(source->Position() - headerStart);
+                }
+                if (status == TarEntryReader::Status::End) {
+                    break;
+                }
+                if (status == TarEntryReader::Status::Corrupt) {
+                    result.errorMessage = L"Corrupt header in archive: " + archivePath;
+                    return result;
+                }
+
+                // The name points into the source buffer and is only valid until the payload is read
+                uint64_t fileSize = entry.realSize;
+                if (options.useIndex && !indexed) {
+                    indexWriter.Add(entry.name, entry.linkName, entry.headerOffset, entry.dataOffset, fileSize,
+                                    entry.size, entry.mtime, entry.permissions, entry.type);
+                }
+
+                // Unselected payloads are skipped without being read (a seek for plain archives)
+                if (matcher && !matcher->Matches(entry.name)) {
+                    reader.SkipData(entry);
                     continue;
                 }
+                if (!found.empty()) {
+                    matcher->MarkExact(entry.name, found);
+                }
 
-                std::wstring fileName = header.GetFileName();
-                std::wstring outputPath = Utils::CombinePath(destinationPath, fileName);
+                std::wstring fileName = Utils::WidenBytes(entry.name);
 
-                // Security check
-                if (!Utils::IsValidExtractionPath(destinationPath, fileName)) {
+                // Security check; the output path is sanitized in the same pass
+                std::wstring outputPath;
+                bool resolved;
+                {
+                    ExtractionStatsRecorder::Scope scope(stats, ExtractionPhase::ValidatePath);
+                    resolved = paths.Resolve(fileName, outputPath);
+                }
+                if (!resolved) {
                     result.errorMessage = L"Security violation: Invalid path in archive: " + fileName;
                     return result;
                 }
 
-                // Sanitize the output path
-                outputPath = Utils::CombinePath(destinationPath, Utils::SanitizePath(fileName));
-
                 // Report progress
-                if (callback) {
-                    if (!callback(processedBytes, totalSize, fileName, L"Extracting")) {
+                if (callback && throttle.Due()) {
+                    uint64_t current = offsetProgress ? source->InputPosition() : processedBytes;
+                    if (!callback(current, totalSize, fileName, L"Extracting")) {
+                        result.cancelled = true;
                         result.errorMessage = L"Extraction cancelled by user";
                         return result;
                     }
                 }
 
-                if (header.IsDirectory()) {
+                if (entry.IsDirectory()) {
                     // Extract directory
-                    if (!Utils::CreateDirectoryRecursive(outputPath)) {
+                    if (!output.MakeDirectory(outputPath)) {
                         result.errorMessage = L"Failed to create directory: " + fileName + L" at " + outputPath;
                         return result;
                     }
-                } else if (header.IsRegularFile()) {
+                } else if (entry.IsRegularFile()) {
                     // Extract regular file
-                    if (!ExtractFile(file, header, outputPath, callback)) {
+                    OutputFileAttributes attributes = GetOutputAttributes(entry, options);
+                    bool batched = batch && entry.realSize <= UringFileWriter::MaxFileSize && !entry.sparse &&
+                                   !options.writeHoles && !attributes.direct;
+                    ExtractionStatsRecorder::Scope scope(batched || writers ? stats : nullptr, ExtractionPhase::QueueData,
+                                                         entry.size);
+                    // An earlier copy of the path still pending in the other back end is
+                    // written out first, so it cannot replace this one afterwards
+                    if (batched && writers) {
+                        writers->WaitFor(outputPath);
+                    } else if (!batched && batch) {
+                        batch->WaitFor(outputPath);
+                    }
+                    bool extracted = batched
+                        ? BatchFile(*source, entry, outputPath, fileName, attributes, *batch)
+                        : writers
+                        ? QueueFile(*source, entry, outputPath, fileName, options, *writers)
+                        : ExtractFile(*source, entry, outputPath, options, output);
+                    if (!batched && !writers) {
+                        output.NoteFile(fileName, extracted ? FileOutcome::Written : FileOutcome::Lost);
+                    }
+                    if (!extracted) {
                         result.errorMessage = L"Failed to extract file: " + fileName;
                         return result;
                     }
                 } else {
                     // Skip unsupported file types (symbolic links, etc.)
-                    uint64_t fileSize = header.GetFileSize();
-                    if (fileSize > 0) {
-                        uint64_t blocks = (fileSize + 511) / 512;
-                        file.seekg(blocks * 512, std::ios::cur);
-                    }
+                    reader.SkipData(entry);
                 }
 
                 result.extractedFiles.push_back(fileName);
-                processedBytes += header.GetFileSize();
+                processedBytes += fileSize;
+                progress.SetCurrent(offsetProgress ? source->InputPosition() : processedBytes);
+                progress.AddEntry();
+                progress.Publish();
+
+                if (writers && writers->Failed()) {
+                    writers->Finish(failedName);
+                    result.errorMessage = L"Failed to extract file: " + failedName;
+                    return result;
+                }
+                if (batch && batch->Failed()) {
+                    batch->Finish(failedName);
+                    result.errorMessage = L"Failed to extract file: " + failedName;
+                    return result;
+                }
+            }
+
+            // A cancelled source ends its stream early, which reads like the end of the archive
+            if (options.Cancelled()) {
+                return result;
+            }
+
+            progress.SetPhase(ProgressPhase::Finishing);
+            if (writers && !writers->Finish(failedName)) {
+                result.errorMessage = L"Failed to extract file: " + failedName;
+                return result;
+            }
+            if (batch && !batch->Finish(failedName)) {
+                result.errorMessage = L"Failed to extract file: " + failedName;
+                return result;
+            }
+
+            // Index only archives that were read to the end without error
+            if (options.useIndex && !indexed) {
+                indexWriter.Save(archivePath);
+            }
+
+            // Everything else selected has been extracted; requested paths the archive
+            // lacks still fail the extraction
+            std::wstring missing = matcher ? matcher->Unmatched(found) : std::wstring();
+            if (!missing.empty()) {
+                result.errorMessage = L"Not found in archive: " + missing;
+                return result;
+            }
+
+            // The exact uncompressed total is known now that the whole archive has been read
+            result.totalUncompressedSize = processedBytes;
+            if (offsetProgress) {
+                totalSize = processedBytes;
             }
+            progress.SetTotal(totalSize);
+            progress.SetCurrent(totalSize);
 
             // Final progress update
             if (callback) {
@@ -241,113 +527,172 @@ namespace ArchiveEngine {
         return L"TAR Extractor";
     }
 
-    // Private helper methods
-    bool TarExtractor::ReadTarHeader(std::ifstream& file, TarHeader& header) const {
-        file.read(reinterpret_cast<char*>(&header), sizeof(TarHeader));
-        return file.gcount() == sizeof(TarHeader);
+    std::unique_ptr<IArchiveSource> TarExtractor::OpenSource(const std::wstring& filePath,
+                                                             const ExtractionOptions& options) const {
+        return OpenArchiveSource(filePath, options.readAheadWindow);
     }
 
-    bool TarExtractor::ValidateChecksum(const TarHeader& header) const {
-        // Calculate checksum
-        uint32_t calculatedChecksum = 0;
-        const char* bytes = reinterpret_cast<const char*>(&header);
-        
-        for (size_t i = 0; i < sizeof(TarHeader); ++i) {
-            if (i >= 148 && i < 156) {
-                // Checksum field should be treated as spaces for calculation
-                calculatedChecksum += ' ';
-            } else {
-                calculatedChecksum += static_cast<unsigned char>(bytes[i]);
+    // Private helper methods
+    bool TarExtractor::CopyEntryData(IArchiveSource& source, const TarEntry& entry, size_t maxChunk,
+                                     bool writeHoles, const DataSink& write) const {
+        // A plain file is one region covering all of it
+        SparseRegion whole = { 0, entry.size };
+        const SparseRegion* regions = entry.sparse ? entry.regions.data() : &whole;
+        size_t regionCount = entry.sparse ? entry.regions.size() : 1;
+
+        for (size_t i = 0; i < regionCount; ++i) {
+            uint64_t offset = regions[i].offset;
+            uint64_t bytesRemaining = regions[i].length;
+            while (bytesRemaining > 0) {
+                const char* data = nullptr;
+                size_t bytesRead = source.Read(data, static_cast<size_t>(std::min(static_cast<uint64_t>(maxChunk), bytesRemaining)));
+                if (bytesRead == 0) {
+                    return false;
+                }
+                if (!writeHoles) {
+                    if (!write(offset, data, bytesRead)) {
+                        return false;
+                    }
+                } else {
+                    // Zero blocks aligned to the file are left out of the write, so the
+                    // file system can keep them as holes; the rest goes out in runs
+                    size_t runStart = 0;
+                    size_t position = 0;
+                    while (position < bytesRead) {
+                        size_t blockEnd = static_cast<size_t>(std::min<uint64_t>(
+                            bytesRead, position + HoleBlockSize - (offset + position) % HoleBlockSize));
+                        if (IsZeroMemory(data + position, blockEnd - position)) {
+                            if (position > runStart && !write(offset + runStart, data + runStart, position - runStart)) {
+                                return false;
+                            }
+                            runStart = blockEnd;
+                        }
+                        position = blockEnd;
+                    }
+                    if (bytesRead > runStart && !write(offset + runStart, data + runStart, bytesRead - runStart)) {
+                        return false;
+                    }
+                }
+                offset += bytesRead;
+                bytesRemaining -= bytesRead;
             }
         }
 
-        // Get stored checksum
-        uint32_t storedChecksum = OctalToDecimal(header.checksum, sizeof(header.checksum));
-        
-        return calculatedChecksum == storedChecksum;
+        // Skip to next 512-byte boundary
+        uint64_t padding = TarEntryReader::Padding(entry.size);
+        return padding == 0 || source.Skip(padding);
     }
 
-    uint64_t TarExtractor::OctalToDecimal(const char* octal, size_t length) const {
-        uint64_t result = 0;
-        for (size_t i = 0; i < length && octal[i] != '\0' && octal[i] != ' '; ++i) {
-            if (octal[i] >= '0' && octal[i] <= '7') {
-                result = result * 8 + (octal[i] - '0');
-            }
+    OutputFileAttributes TarExtractor::GetOutputAttributes(const TarEntry& entry, const ExtractionOptions& options) const {
+        OutputFileAttributes attributes;
+        attributes.permissions = entry.permissions;
+        attributes.mtime = entry.mtime;
+
+        // Files that may keep holes are neither reserved in full nor written in order
+        bool dense = !entry.sparse && !options.writeHoles;
+        if (dense && options.preallocateThreshold > 0 && entry.realSize >= options.preallocateThreshold) {
+            attributes.preallocate = entry.realSize;
         }
-        return result;
+        attributes.direct = dense && options.directWriteThreshold > 0 && entry.realSize >= options.directWriteThreshold;
+        return attributes;
     }
 
-    bool TarExtractor::ExtractFile(std::ifstream& tarFile, const TarHeader& header, 
-                                  const std::wstring& outputPath, ProgressCallback callback) const {
-        uint64_t fileSize = header.GetFileSize();
-        
-        // Create parent directory if it doesn't exist
-        std::wstring parentDir = Utils::GetParentDirectory(outputPath);
-        if (!parentDir.empty() && !Utils::CreateDirectoryRecursive(parentDir)) {
-            return false;
-        }
+    bool TarExtractor::CanCopyInKernel(const IArchiveSource& source, const TarEntry& entry,
+                                       const OutputFileAttributes& attributes, const ExtractionOptions& options) const {
+        // Only a payload stored as is, in one piece, maps onto a range of the archive file
+        return source.Descriptor() >= 0 && !entry.sparse && !options.writeHoles && !attributes.direct &&
+               options.kernelCopyThreshold > 0 && entry.realSize >= options.kernelCopyThreshold;
+    }
 
-        std::ofstream outputFile(outputPath, std::ios::binary);
-        if (!outputFile.is_open()) {
+    bool TarExtractor::ExtractFile(IArchiveSource& source, const TarEntry& entry, const std::wstring& outputPath,
+                                   const ExtractionOptions& options, OutputTree& output) const {
+        // Creates the parent directory if it doesn't exist
+        OutputFileAttributes attributes = GetOutputAttributes(entry, options);
+        OutputFile outputFile;
+        if (!output.OpenFile(outputPath, attributes, outputFile)) {
             return false;
         }
 
-        const size_t bufferSize = 8192;
-        char buffer[bufferSize];
-        uint64_t bytesRemaining = fileSize;
-
-        while (bytesRemaining > 0) {
-            size_t bytesToRead = static_cast<size_t>(std::min(static_cast<uint64_t>(bufferSize), bytesRemaining));
-            tarFile.read(buffer, bytesToRead);
-            size_t bytesRead = tarFile.gcount();
-            
-            if (bytesRead == 0) {
-                break;
-            }
-
-            outputFile.write(buffer, bytesRead);
-            bytesRemaining -= bytesRead;
+        // Large payloads of plain archives go from file to file without entering the process.
+        // Otherwise payload bytes are written straight from the source buffer (the mapping
+        // for plain archives). Gaps between writes read back as zeros.
+        bool copied;
+        if (CanCopyInKernel(source, entry, attributes, options)) {
+            copied = outputFile.CopyFrom(source.Descriptor(), entry.dataOffset, 0, entry.size) &&
+                     source.Skip(entry.size + TarEntryReader::Padding(entry.size));
+        } else {
+            copied = CopyEntryData(source, entry, 16 * 1024 * 1024, options.writeHoles,
+                [&](uint64_t offset, const char* data, size_t length) {
+                    return !options.Cancelled() && outputFile.Write(offset, data, length);
+                });
         }
 
-        // Skip to next 512-byte boundary
-        if (fileSize % 512 != 0) {
-            uint64_t padding = 512 - (fileSize % 512);
-            tarFile.seekg(padding, std::ios::cur);
+        // A file cut short by cancellation is removed rather than left behind
+        if (!copied && options.Cancelled()) {
+            output.RemoveFile(outputPath, outputFile);
+            return false;
         }
-
-        return true;
+        return copied && outputFile.Close(entry.realSize);
     }
 
-    bool TarExtractor::ExtractDirectory(const TarHeader& header, const std::wstring& outputPath) const {
-        return Utils::CreateDirectoryRecursive(outputPath);
+    bool TarExtractor::QueueFile(IArchiveSource& source, const TarEntry& entry, const std::wstring& outputPath,
+                                 const std::wstring& fileName, const ExtractionOptions& options,
+                                 FileWriterPool& writers) const {
+        OutputFileAttributes attributes = GetOutputAttributes(entry, options);
+        writers.BeginFile(outputPath, fileName, attributes);
+
+        // The writer copies large payloads of plain archives straight from the archive file
+        if (CanCopyInKernel(source, entry, attributes, options)) {
+            writers.Copy(source.Descriptor(), entry.dataOffset, 0, entry.size);
+            writers.EndFile(entry.realSize);
+            return source.Skip(entry.size + TarEntryReader::Padding(entry.size));
+        }
+
+        // Payload is copied out of the source buffer in bounded chunks; the writer
+        // creates the parent directory, writes and closes the file
+        bool copied = CopyEntryData(source, entry, 1024 * 1024, options.writeHoles,
+            [&](uint64_t offset, const char* data, size_t length) {
+                if (options.Cancelled()) {
+                    return false;
+                }
+                writers.Write(offset, data, length);
+                return true;
+            });
+        writers.EndFile(entry.realSize);
+        return copied;
     }
 
-    std::wstring TarExtractor::ConvertPath(const std::string& path) const {
-        return std::wstring(path.begin(), path.end());
+    bool TarExtractor::BatchFile(IArchiveSource& source, const TarEntry& entry, const std::wstring& outputPath,
+                                 const std::wstring& fileName, const OutputFileAttributes& attributes,
+                                 UringFileWriter& batch) const {
+        // The payload is copied into the batch buffer, which is written once the batch is submitted
+        char* data = nullptr;
+        size_t size = static_cast<size_t>(entry.realSize);
+        if (!batch.AddFile(outputPath, fileName, attributes, size, data)) {
+            return false;
+        }
+        return CopyEntryData(source, entry, size > 0 ? size : 1, false,
+            [&](uint64_t offset, const char* chunk, size_t length) {
+                std::memcpy(data + offset, chunk, length);
+                return true;
+            });
     }
 
     uint64_t TarExtractor::GetTotalUncompressedSize(const std::wstring& filePath) const {
         uint64_t totalSize = 0;
         
-        std::ifstream file(filePath, std::ios::binary);
-        if (!file.is_open()) {
+        auto source = OpenSource(filePath, ExtractionOptions());
+        if (!source) {
             return 0;
         }
 
-        TarHeader header;
-        while (ReadTarHeader(file, header)) {
-            if (!header.IsValid()) {
-                continue;
-            }
-
-            totalSize += header.GetFileSize();
+        TarEntryReader reader(*source);
+        TarEntry entry;
+        while (reader.Next(entry) == TarEntryReader::Status::Entry) {
+            totalSize += entry.realSize;
 
             // Skip file data
-            uint64_t fileSize = header.GetFileSize();
-            if (fileSize > 0) {
-                uint64_t blocks = (fileSize + 511) / 512;
-                file.seekg(blocks * 512, std::ios::cur);
-            }
+            reader.SkipData(entry);
         }
 
         return totalSize;
@@ -1,10 +1,15 @@
 #pragma once
 
 #include "ArchiveExtractor.h"
-#include <fstream>
+#include "ArchiveSource.h"
+#include "FileWriterPool.h"
+#include "PathMatcher.h"
+#include "UringFileWriter.h"
 
 namespace ArchiveEngine {
 
+    struct TarEntry;
+
     // TAR header structure (POSIX TAR format)
     struct TarHeader {
         char name[100];        // File name
@@ -25,18 +30,17 @@ namespace ArchiveEngine {
         char prefix[155];      // Filename prefix
         char padding[12];      // Padding to 512 bytes
         
-        // Helper methods
+        // Helper methods. Numeric fields and the checksum are decoded by DecodeTarHeader.
         bool IsValid() const;
-        uint64_t GetFileSize() const;
-        uint64_t GetModificationTime() const;
-        std::wstring GetFileName() const;
-        std::wstring GetLinkName() const;
-        bool IsDirectory() const;
-        bool IsRegularFile() const;
-        bool IsSymbolicLink() const;
-        uint32_t GetPermissions() const;
+        // Path bytes as stored in the header. The view points into the header, or into
+        // `buffer` when a prefix has to be joined to the name.
+        std::string_view GetRawFileName(std::string& buffer) const;
+        std::string_view GetRawLinkName() const;
     };
 
+    // Headers are parsed in place from the archive source, so the layout must be exactly one block
+    static_assert(sizeof(TarHeader) == 512, "TarHeader must span one 512-byte TAR block");
+
     // TAR archive extractor
     class TarExtractor : public IArchiveExtractor {
     public:
@@ -46,22 +50,75 @@ namespace ArchiveEngine {
         // IArchiveExtractor implementation
         bool CanExtract(const std::wstring& filePath) const override;
         bool GetArchiveInfo(const std::wstring& filePath, std::vector<ArchiveEntry>& entries) const override;
+        bool GetArchiveInfo(const std::wstring& filePath, const ExtractionOptions& options,
+                            std::vector<ArchiveEntry>& entries) const override;
+        bool VisitEntries(const std::wstring& filePath, const ExtractionOptions& options,
+                          const EntryVisitor& visitor) const override;
+        ExtractionResult Extract(
+            const std::wstring& archivePath,
+            const std::wstring& destinationPath,
+            ProgressCallback callback = nullptr) const override;
+        ExtractionResult Extract(
+            const std::wstring& archivePath,
+            const std::wstring& destinationPath,
+            const ExtractionOptions& options,
+            ProgressCallback callback = nullptr) const override;
         ExtractionResult Extract(
             const std::wstring& archivePath,
             const std::wstring& destinationPath,
+            const std::vector<std::wstring>& paths,
+            const ExtractionOptions& options,
             ProgressCallback callback = nullptr) const override;
         std::vector<std::wstring> GetSupportedExtensions() const override;
         std::wstring GetExtractorName() const override;
 
+    protected:
+        // Opens the byte stream holding the TAR data; compressed variants decode here
+        virtual std::unique_ptr<IArchiveSource> OpenSource(const std::wstring& filePath,
+                                                           const ExtractionOptions& options) const;
+
     private:
+        // Extracts every entry, or only those selected by `matcher` when it is set
+        ExtractionResult ExtractEntries(
+            const std::wstring& archivePath,
+            const std::wstring& destinationPath,
+            const PathMatcher* matcher,
+            const ExtractionOptions& options,
+            ProgressCallback callback) const;
+
+        // As above, timing the phases into `stats` and recording spans into `trace`
+        // when they are set. What became of each file is in `files` once it returns,
+        // background writers included.
+        ExtractionResult ExtractEntries(
+            const std::wstring& archivePath,
+            const std::wstring& destinationPath,
+            const PathMatcher* matcher,
+            const ExtractionOptions& options,
+            ProgressCallback callback,
+            ExtractionStatsRecorder* stats,
+            TraceRecorder* trace,
+            ExtractedFileLog& files) const;
+
+        // Receives a run of file data and the offset in the output file it belongs at
+        using DataSink = std::function<bool(uint64_t offset, const char* data, size_t length)>;
+
+        // Granularity at which zero runs are left as holes
+        static constexpr size_t HoleBlockSize = 4096;
+
         // Helper methods
-        bool ReadTarHeader(std::ifstream& file, TarHeader& header) const;
-        bool ValidateChecksum(const TarHeader& header) const;
-        uint64_t OctalToDecimal(const char* octal, size_t length) const;
-        bool ExtractFile(std::ifstream& tarFile, const TarHeader& header, 
-                        const std::wstring& outputPath, ProgressCallback callback) const;
-        bool ExtractDirectory(const TarHeader& header, const std::wstring& outputPath) const;
-        std::wstring ConvertPath(const std::string& path) const;
+        bool CopyEntryData(IArchiveSource& source, const TarEntry& entry, size_t maxChunk,
+                           bool writeHoles, const DataSink& write) const;
+        OutputFileAttributes GetOutputAttributes(const TarEntry& entry, const ExtractionOptions& options) const;
+        bool CanCopyInKernel(const IArchiveSource& source, const TarEntry& entry,
+                             const OutputFileAttributes& attributes, const ExtractionOptions& options) const;
+        bool ExtractFile(IArchiveSource& source, const TarEntry& entry, const std::wstring& outputPath,
+                         const ExtractionOptions& options, OutputTree& output) const;
+        bool QueueFile(IArchiveSource& source, const TarEntry& entry, const std::wstring& outputPath,
+                       const std::wstring& fileName, const ExtractionOptions& options,
+                       FileWriterPool& writers) const;
+        bool BatchFile(IArchiveSource& source, const TarEntry& entry, const std::wstring& outputPath,
+                       const std::wstring& fileName, const OutputFileAttributes& attributes,
+                       UringFileWriter& batch) const;
         uint64_t GetTotalUncompressedSize(const std::wstring& filePath) const;
     };
 
@@ -78,6 +135,9 @@ namespace ArchiveEngine {
         constexpr char ContiguousFile = '7';
         constexpr char GlobalPAXHeader = 'g';
         constexpr char PAXHeader = 'x';
+        constexpr char GnuLongName = 'L';
+        constexpr char GnuLongLink = 'K';
+        constexpr char GnuSparse = 'S';
     }
 
 } // namespace ArchiveEngine
\ No newline at end of file
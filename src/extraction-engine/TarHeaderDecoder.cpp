@@ -0,0 +1,235 @@
+#include "TarHeaderDecoder.h"
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TAR_HEADER_AVX2 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TAR_HEADER_SSE2 1
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace ArchiveEngine {
+
+    namespace {
+
+        constexpr size_t BlockSize = 512;
+        constexpr size_t ModeOffset = 100;
+        constexpr size_t SizeOffset = 124;
+        constexpr size_t MtimeOffset = 136;
+        constexpr size_t ChecksumOffset = 148;
+        constexpr size_t ChecksumWidth = 8;
+
+        // Sums of the block's bytes read as unsigned and as signed chars. POSIX specifies
+        // the unsigned sum; some historical writers used the signed one.
+        void SumBlock(const char* block, uint64_t& unsignedSum, int64_t& signedSum) {
+            // Flipping the top bit maps a signed byte s to s + 128, so one unsigned
+            // byte sum of the flipped bytes yields the signed sum
+            uint64_t flippedSum = 0;
+#if defined(TAR_HEADER_AVX2)
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i flip = _mm256_set1_epi8(static_cast<char>(0x80));
+            __m256i plain = zero;
+            __m256i flipped = zero;
+            for (size_t i = 0; i < BlockSize; i += 32) {
+                __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+                plain = _mm256_add_epi64(plain, _mm256_sad_epu8(bytes, zero));
+                flipped = _mm256_add_epi64(flipped, _mm256_sad_epu8(_mm256_xor_si256(bytes, flip), zero));
+            }
+            alignas(32) uint64_t lanes[8];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), plain);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes + 4), flipped);
+            unsignedSum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+            flippedSum = lanes[4] + lanes[5] + lanes[6] + lanes[7];
+#elif defined(TAR_HEADER_SSE2)
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i flip = _mm_set1_epi8(static_cast<char>(0x80));
+            __m128i plain = zero;
+            __m128i flipped = zero;
+            for (size_t i = 0; i < BlockSize; i += 16) {
+                __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+                plain = _mm_add_epi64(plain, _mm_sad_epu8(bytes, zero));
+                flipped = _mm_add_epi64(flipped, _mm_sad_epu8(_mm_xor_si128(bytes, flip), zero));
+            }
+            alignas(16) uint64_t lanes[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes), plain);
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes + 2), flipped);
+            unsignedSum = lanes[0] + lanes[1];
+            flippedSum = lanes[2] + lanes[3];
+#else
+            unsignedSum = 0;
+            for (size_t i = 0; i < BlockSize; ++i) {
+                uint8_t byte = static_cast<uint8_t>(block[i]);
+                unsignedSum += byte;
+                flippedSum += byte ^ 0x80;
+            }
+#endif
+            signedSum = static_cast<int64_t>(flippedSum) - 128 * static_cast<int64_t>(BlockSize);
+        }
+
+#if defined(TAR_HEADER_SSE2)
+        inline unsigned CountTrailingZeros(uint32_t value) {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward(&index, value);
+            return static_cast<unsigned>(index);
+#else
+            return static_cast<unsigned>(__builtin_ctz(value));
+#endif
+        }
+
+        bool ParseOctal(const char* field, size_t width, uint64_t& value) {
+            // Classify all lanes at once: spaces*, octal digits*, then NUL/space or the field end
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(field));
+            const uint32_t widthMask = width >= 16 ? 0xFFFFu : (1u << width) - 1;
+            __m128i digits = _mm_sub_epi8(bytes, _mm_set1_epi8('0'));
+            __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digits, _mm_set1_epi8(7)), digits);
+            uint32_t digitMask = static_cast<uint32_t>(_mm_movemask_epi8(isDigit)) & widthMask;
+            uint32_t spaceMask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')))) & widthMask;
+            uint32_t nulMask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_setzero_si128()))) & widthMask;
+
+            uint32_t nonSpace = ~spaceMask & widthMask;
+            if (nonSpace == 0) {
+                value = 0;
+                return true;
+            }
+            unsigned start = CountTrailingZeros(nonSpace);
+            unsigned end = start + CountTrailingZeros(~(digitMask >> start));
+            if (end < width && (((spaceMask | nulMask) >> end) & 1) == 0) {
+                return false;
+            }
+
+            // Weight lane i by 8^(15 - i) with padding lanes zeroed, then shift out the
+            // 16 - end trailing digit positions
+            const __m128i lane = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+            __m128i keep = _mm_and_si128(_mm_cmpgt_epi8(lane, _mm_set1_epi8(static_cast<char>(start) - 1)),
+                                         _mm_cmplt_epi8(lane, _mm_set1_epi8(static_cast<char>(end))));
+            digits = _mm_and_si128(digits, keep);
+
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i pairWeights = _mm_setr_epi16(8, 1, 8, 1, 8, 1, 8, 1);
+            __m128i pairs = _mm_packs_epi32(_mm_madd_epi16(_mm_unpacklo_epi8(digits, zero), pairWeights),
+                                            _mm_madd_epi16(_mm_unpackhi_epi8(digits, zero), pairWeights));
+            __m128i quads = _mm_madd_epi16(pairs, _mm_setr_epi16(64, 1, 64, 1, 64, 1, 64, 1));
+            quads = _mm_packs_epi32(quads, quads);
+            __m128i octets = _mm_madd_epi16(quads, _mm_setr_epi16(4096, 1, 4096, 1, 4096, 1, 4096, 1));
+
+            uint64_t high = static_cast<uint32_t>(_mm_cvtsi128_si32(octets));
+            uint64_t low = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(octets, 4)));
+            value = ((high << 24) | low) >> (3 * (16 - end));
+            return true;
+        }
+#else
+        bool ParseOctal(const char* field, size_t width, uint64_t& value) {
+            size_t i = 0;
+            while (i < width && field[i] == ' ') {
+                ++i;
+            }
+            uint64_t result = 0;
+            while (i < width && field[i] >= '0' && field[i] <= '7') {
+                result = result * 8 + (field[i] - '0');
+                ++i;
+            }
+            if (i < width && field[i] != ' ' && field[i] != '\0') {
+                return false;
+            }
+            value = result;
+            return true;
+        }
+#endif
+
+    } // namespace
+
+    bool ParseTarNumber(const char* field, size_t width, uint64_t& value) {
+        uint8_t lead = static_cast<uint8_t>(field[0]);
+        if (lead & 0x80) {
+            // Base-256: big-endian in the remaining bits. Negative values are never valid here.
+            if (lead & 0x40) {
+                return false;
+            }
+            uint64_t result = lead & 0x3F;
+            for (size_t i = 1; i < width; ++i) {
+                if (result >> 56) {
+                    return false;
+                }
+                result = (result << 8) | static_cast<uint8_t>(field[i]);
+            }
+            value = result;
+            return true;
+        }
+        return ParseOctal(field, width, value);
+    }
+
+    bool IsZeroBlock(const char* block) {
+        return IsZeroMemory(block, BlockSize);
+    }
+
+    bool IsZeroMemory(const char* data, size_t length) {
+        size_t i = 0;
+#if defined(TAR_HEADER_AVX2)
+        __m256i bits = _mm256_setzero_si256();
+        for (; i + 32 <= length; i += 32) {
+            bits = _mm256_or_si256(bits, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)));
+        }
+        if (!_mm256_testz_si256(bits, bits)) {
+            return false;
+        }
+#elif defined(TAR_HEADER_SSE2)
+        __m128i bits = _mm_setzero_si128();
+        for (; i + 16 <= length; i += 16) {
+            bits = _mm_or_si128(bits, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(bits, _mm_setzero_si128())) != 0xFFFF) {
+            return false;
+        }
+#endif
+        uint64_t word = 0;
+        for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+            uint64_t next;
+            std::memcpy(&next, data + i, sizeof(next));
+            word |= next;
+        }
+        uint8_t tail = 0;
+        for (; i < length; ++i) {
+            tail |= static_cast<uint8_t>(data[i]);
+        }
+        return word == 0 && tail == 0;
+    }
+
+    bool DecodeTarHeader(const char* block, TarHeaderFields& fields) {
+        uint64_t unsignedSum = 0;
+        int64_t signedSum = 0;
+        SumBlock(block, unsignedSum, signedSum);
+
+        // The checksum is computed with its own field read as spaces
+        uint64_t storedChecksum = 0;
+        if (!ParseTarNumber(block + ChecksumOffset, ChecksumWidth, storedChecksum)) {
+            return false;
+        }
+        for (size_t i = ChecksumOffset; i < ChecksumOffset + ChecksumWidth; ++i) {
+            unsignedSum -= static_cast<uint8_t>(block[i]);
+            signedSum -= static_cast<signed char>(block[i]);
+        }
+        unsignedSum += ChecksumWidth * ' ';
+        signedSum += ChecksumWidth * ' ';
+        if (storedChecksum != unsignedSum && static_cast<int64_t>(storedChecksum) != signedSum) {
+            return false;
+        }
+
+        uint64_t mode = 0;
+        if (!ParseTarNumber(block + ModeOffset, 8, mode) ||
+            !ParseTarNumber(block + SizeOffset, 12, fields.size) ||
+            !ParseTarNumber(block + MtimeOffset, 12, fields.mtime)) {
+            return false;
+        }
+        fields.permissions = static_cast<uint32_t>(mode);
+        return true;
+    }
+
+} // namespace ArchiveEngine
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ArchiveEngine {
+
+    // Numeric fields of a TAR header
+    struct TarHeaderFields {
+        uint64_t size;
+        uint64_t mtime;        // Unix timestamp
+        uint32_t permissions;
+    };
+
+    // Validates the checksum of a 512-byte TAR header block and parses its numeric fields
+    // in one pass. Returns false if the checksum does not match or a field is not a
+    // well-formed number, so corrupt headers are rejected before anything is written.
+    //
+    // The byte sums use AVX2 or SSE2 and the octal fields are decoded with SSE2 where
+    // the compiler targets them, with a scalar fallback elsewhere. Octal fields may be
+    // padded with leading spaces and end in NUL or space; size and mtime also accept
+    // the base-256 form GNU tar uses for values that do not fit in octal.
+    bool DecodeTarHeader(const char* block, TarHeaderFields& fields);
+
+    // True if the 512-byte block is all zeros, as in the end-of-archive marker
+    bool IsZeroBlock(const char* block);
+
+    // True if all `length` bytes are zero
+    bool IsZeroMemory(const char* data, size_t length);
+
+    // Parses one numeric header field of at most 16 bytes; false if malformed.
+    // 16 bytes must be readable from `field` whatever the width.
+    bool ParseTarNumber(const char* field, size_t width, uint64_t& value);
+
+} // namespace ArchiveEngine
@@ -0,0 +1,48 @@
+#include "ThreadPool.h"
+
+namespace ArchiveEngine {
+
+    ThreadPool::ThreadPool(unsigned threadCount) {
+        if (threadCount == 0) {
+            threadCount = 1;
+        }
+        m_threads.reserve(threadCount);
+        for (unsigned i = 0; i < threadCount; ++i) {
+            m_threads.emplace_back(&ThreadPool::WorkerLoop, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+            m_tasks.clear();
+        }
+        m_wake.notify_all();
+        for (auto& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    unsigned ThreadPool::DefaultThreadCount() {
+        unsigned count = std::thread::hardware_concurrency();
+        return count > 0 ? count : 1;
+    }
+
+    void ThreadPool::WorkerLoop() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+                if (m_stopping) {
+                    return;
+                }
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+} // namespace ArchiveEngine
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ArchiveEngine {
+
+    // Fixed set of worker threads running queued tasks in submission order.
+    // Tasks still queued when the pool is destroyed are dropped; their futures
+    // report broken_promise.
+    class ThreadPool {
+    public:
+        explicit ThreadPool(unsigned threadCount);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        template <typename Task>
+        auto Submit(Task&& task) -> std::future<decltype(task())> {
+            using Result = decltype(task());
+            auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<Task>(task));
+            std::future<Result> future = packaged->get_future();
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_tasks.emplace_back([packaged] { (*packaged)(); });
+            }
+            m_wake.notify_one();
+            return future;
+        }
+
+        unsigned Size() const { return static_cast<unsigned>(m_threads.size()); }
+
+        // Hardware threads available to the process, at least 1
+        static unsigned DefaultThreadCount();
+
+    private:
+        void WorkerLoop();
+
+        std::vector<std::thread> m_threads;
+        std::deque<std::function<void()>> m_tasks;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        bool m_stopping = false;
+    };
+
+} // namespace ArchiveEngine
@@ -0,0 +1,105 @@
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+namespace ArchiveEngine {
+
+    namespace {
+
+        std::atomic<uint64_t> g_nextRecorderId{ 1 };
+
+        // Buffer the calling thread last recorded into, and for which recorder
+        struct LocalCache {
+            uint64_t recorder = 0;
+            void* buffer = nullptr;
+        };
+        thread_local LocalCache t_cache;
+
+    } // namespace
+
+    // TraceRecorder implementation
+    TraceRecorder::TraceRecorder(size_t capacity)
+        : m_id(g_nextRecorderId.fetch_add(1, std::memory_order_relaxed)),
+          m_capacity(capacity > 0 ? capacity : 1),
+          m_origin(Clock::now()) {}
+
+    TraceRecorder::~TraceRecorder() = default;
+
+    TraceRecorder::ThreadBuffer& TraceRecorder::LocalBuffer() {
+        if (t_cache.recorder == m_id) {
+            return *static_cast<ThreadBuffer*>(t_cache.buffer);
+        }
+
+        // First span of this thread, or the thread went back and forth between recorders
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::thread::id self = std::this_thread::get_id();
+        ThreadBuffer* buffer = nullptr;
+        for (auto& candidate : m_buffers) {
+            if (candidate->owner == self) {
+                buffer = candidate.get();
+                break;
+            }
+        }
+        if (!buffer) {
+            auto created = std::make_unique<ThreadBuffer>();
+            created->owner = self;
+            created->thread = static_cast<unsigned>(m_buffers.size()) + 1;
+            created->events.resize(m_capacity);
+            buffer = created.get();
+            m_buffers.push_back(std::move(created));
+        }
+        t_cache.recorder = m_id;
+        t_cache.buffer = buffer;
+        return *buffer;
+    }
+
+    void TraceRecorder::Record(const char* name, Clock::time_point start, Clock::time_point end, uint64_t bytes) {
+        ThreadBuffer& buffer = LocalBuffer();
+        Event& event = buffer.events[buffer.recorded % m_capacity];
+        event.name = name;
+        event.start = std::chrono::duration_cast<std::chrono::nanoseconds>(start - m_origin).count();
+        event.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        event.bytes = bytes;
+        ++buffer.recorded;
+    }
+
+    bool TraceRecorder::Write(const std::wstring& filePath) const {
+        std::ofstream file(std::filesystem::path(filePath), std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        uint64_t dropped = 0;
+        bool first = true;
+        char line[256];
+        file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        for (const auto& buffer : m_buffers) {
+            // Oldest kept span first; timestamps are in microseconds
+            uint64_t kept = std::min<uint64_t>(buffer->recorded, m_capacity);
+            dropped += buffer->recorded - kept;
+            for (uint64_t i = buffer->recorded - kept; i < buffer->recorded; ++i) {
+                const Event& event = buffer->events[i % m_capacity];
+                std::snprintf(line, sizeof(line),
+                              "%s\n{\"name\":\"%s\",\"cat\":\"extraction\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+                              "\"ts\":%" PRId64 ".%03d,\"dur\":%" PRId64 ".%03d,\"args\":{\"bytes\":%" PRIu64 "}}",
+                              first ? "" : ",", event.name, buffer->thread,
+                              event.start / 1000, static_cast<int>(event.start % 1000),
+                              event.duration / 1000, static_cast<int>(event.duration % 1000),
+                              event.bytes);
+                file << line;
+                first = false;
+            }
+        }
+        std::snprintf(line, sizeof(line), "\n],\"otherData\":{\"droppedSpans\":%" PRIu64 "}}\n", dropped);
+        file << line;
+
+        file.close();
+        return !file.fail();
+    }
+
+} // namespace ArchiveEngine
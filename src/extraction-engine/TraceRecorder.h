@@ -0,0 +1,88 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ArchiveEngine {
+
+    // Records timed spans from every thread taking part in an extraction and writes
+    // them out in the Chrome trace event format, viewable in Perfetto or chrome://tracing.
+    //
+    // Each thread appends to a ring buffer of its own, so recording takes no lock once
+    // the thread's first span is in; when a buffer fills, its oldest spans are dropped.
+    // Span names must be string literals, since only the pointer is kept.
+    class TraceRecorder {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr size_t DefaultCapacity = 64 * 1024;  // Spans kept per thread
+
+        explicit TraceRecorder(size_t capacity = DefaultCapacity);
+        ~TraceRecorder();
+
+        TraceRecorder(const TraceRecorder&) = delete;
+        TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+        void Record(const char* name, Clock::time_point start, Clock::time_point end, uint64_t bytes);
+
+        // Writes every span kept so far as trace JSON. Threads must have stopped recording.
+        bool Write(const std::wstring& filePath) const;
+
+        // Times one span on the calling thread. Does nothing without a recorder.
+        class Span {
+        public:
+            Span(TraceRecorder* recorder, const char* name, uint64_t bytes = 0)
+                : m_recorder(recorder), m_name(name), m_bytes(bytes) {
+                if (m_recorder) {
+                    m_start = Clock::now();
+                }
+            }
+            ~Span() {
+                if (m_recorder) {
+                    m_recorder->Record(m_name, m_start, Clock::now(), m_bytes);
+                }
+            }
+
+            Span(const Span&) = delete;
+            Span& operator=(const Span&) = delete;
+
+            void AddBytes(uint64_t bytes) { m_bytes += bytes; }
+
+        private:
+            TraceRecorder* m_recorder;
+            const char* m_name;
+            uint64_t m_bytes;
+            Clock::time_point m_start;
+        };
+
+    private:
+        struct Event {
+            const char* name;
+            int64_t start;     // Nanoseconds since the recorder was created
+            int64_t duration;  // Nanoseconds
+            uint64_t bytes;
+        };
+
+        struct ThreadBuffer {
+            std::thread::id owner;
+            unsigned thread;   // Numbered in order of first span
+            std::vector<Event> events;
+            uint64_t recorded = 0;  // Total, including overwritten ones
+        };
+
+        ThreadBuffer& LocalBuffer();
+
+        uint64_t m_id;  // Tells recorders apart in the per-thread cache, even at a reused address
+        size_t m_capacity;
+        Clock::time_point m_origin;
+        mutable std::mutex m_mutex;  // Guards the list of buffers, not their contents
+        std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+    };
+
+} // namespace ArchiveEngine
@@ -0,0 +1,370 @@
+#include "UringFileWriter.h"
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ArchiveEngine {
+
+#ifdef __linux__
+    namespace {
+
+        // Submission entries are consumed when submitted, so the ring only has to hold
+        // the three entries per file of one batch
+        constexpr unsigned RingEntries = 512;
+
+        enum Operation : uint64_t { OpenOperation = 0, WriteOperation = 1, CloseOperation = 2 };
+
+        uint64_t MakeUserData(unsigned batch, size_t file, Operation operation) {
+            return (static_cast<uint64_t>(batch) << 32) | (static_cast<uint64_t>(file) << 2) | operation;
+        }
+
+        int SetupRing(unsigned entries, io_uring_params* params) {
+            return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+        }
+
+        int EnterRing(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+            return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+        }
+
+        int RegisterRing(int fd, unsigned opcode, const void* arg, unsigned count) {
+            return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+        }
+
+        // Ring indices are shared with the kernel
+        unsigned LoadAcquire(const unsigned* index) {
+            return __atomic_load_n(index, __ATOMIC_ACQUIRE);
+        }
+
+        void StoreRelease(unsigned* index, unsigned value) {
+            __atomic_store_n(index, value, __ATOMIC_RELEASE);
+        }
+
+    } // namespace
+
+    UringFileWriter::UringFileWriter(OutputTree& output)
+        : m_output(output) {
+        m_available = Setup();
+        for (unsigned i = 0; i < 2; ++i) {
+            m_batches[i].slotBase = i * BatchFiles;
+            if (m_available) {
+                m_batches[i].files.reserve(BatchFiles);
+                m_batches[i].data.reserve(BatchBytes);
+            }
+        }
+    }
+
+    UringFileWriter::~UringFileWriter() {
+        // Buffers must outlive the requests that refer to them; queued files never submitted are dropped
+        if (m_available) {
+            Wait(m_batches[m_current ^ 1]);
+            for (const PendingFile& file : m_batches[m_current].files) {
+                m_output.NoteFile(file.name, FileOutcome::Dropped);
+            }
+        }
+        if (m_ring.sqes != nullptr) {
+            munmap(m_ring.sqes, m_ring.sqesSize);
+        }
+        if (m_ring.rings != nullptr) {
+            munmap(m_ring.rings, m_ring.ringsSize);
+        }
+        if (m_ring.fd >= 0) {
+            ::close(m_ring.fd);
+        }
+    }
+
+    bool UringFileWriter::IsAvailable() const {
+        return m_available;
+    }
+
+    bool UringFileWriter::Setup() {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        int fd = SetupRing(RingEntries, &params);
+        if (fd < 0) {
+            return false;
+        }
+        m_ring.fd = fd;
+
+        // openat and close on fixed file slots arrived in 5.15; the CQE skip feature of
+        // 5.17 serves as the marker. Both rings share one mapping since 5.4.
+        if (!(params.features & IORING_FEAT_CQE_SKIP) || !(params.features & IORING_FEAT_SINGLE_MMAP)) {
+            return false;
+        }
+
+        size_t sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        size_t cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        size_t ringsSize = sqSize > cqSize ? sqSize : cqSize;
+        void* rings = mmap(nullptr, ringsSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (rings == MAP_FAILED) {
+            return false;
+        }
+        m_ring.rings = rings;
+        m_ring.ringsSize = ringsSize;
+
+        size_t sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            return false;
+        }
+        m_ring.sqes = sqes;
+        m_ring.sqesSize = sqesSize;
+
+        char* base = static_cast<char*>(rings);
+        m_ring.sqTail = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+        m_ring.sqMask = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+        m_ring.sqArray = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+        m_ring.cqHead = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+        m_ring.cqTail = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+        m_ring.cqMask = *reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+        m_ring.cqes = base + params.cq_off.cqes;
+
+        // A sparse table of fixed file slots: openat fills a slot, close empties it
+        std::vector<int> slots(2 * BatchFiles, -1);
+        return RegisterRing(fd, IORING_REGISTER_FILES, slots.data(), static_cast<unsigned>(slots.size())) == 0;
+    }
+
+    bool UringFileWriter::AddFile(const std::wstring& path, const std::wstring& name,
+                                  const OutputFileAttributes& attributes, size_t size, char*& data) {
+        PendingFile file;
+        file.directory = m_output.OpenParent(path, file.fileName);
+        if (!file.directory) {
+            return false;
+        }
+
+        // A path already queued goes out first, so the later entry wins as it would on disk
+        Batch* batch = &m_batches[m_current];
+        if (batch->files.size() == BatchFiles || batch->data.size() + size > BatchBytes || batch->paths.count(path) != 0) {
+            Flush();
+            batch = &m_batches[m_current];
+        }
+
+        file.name = name;
+        file.dataOffset = batch->data.size();
+        file.length = size;
+        file.path = path;
+        file.attributes = attributes;
+        file.failed = false;
+        file.exists = false;
+        batch->files.push_back(std::move(file));
+        batch->paths.insert(path);
+        batch->data.resize(batch->data.size() + size);
+        data = batch->data.data() + batch->files.back().dataOffset;
+        return true;
+    }
+
+    void UringFileWriter::WaitFor(const std::wstring& path) {
+        if (!m_available) {
+            return;
+        }
+        if (m_batches[m_current].paths.count(path) != 0) {
+            Flush();
+        }
+        Batch& inFlight = m_batches[m_current ^ 1];
+        if (inFlight.paths.count(path) != 0) {
+            ExtractionStatsRecorder::Scope scope(m_output.Stats(), ExtractionPhase::WriteData);
+            TraceRecorder::Span span(m_output.Trace(), "write-batch");
+            Wait(inFlight);
+        }
+    }
+
+    bool UringFileWriter::Finish(std::wstring& failedName) {
+        if (m_available) {
+            Flush();
+            ExtractionStatsRecorder::Scope scope(m_output.Stats(), ExtractionPhase::WriteData);
+            TraceRecorder::Span span(m_output.Trace(), "write-batch");
+            Wait(m_batches[m_current ^ 1]);
+        }
+        failedName = m_failedName;
+        return !m_failed;
+    }
+
+    void UringFileWriter::Flush() {
+        // The previous batch completes before the next starts, which keeps files in archive order
+        Batch& batch = m_batches[m_current];
+        if (batch.files.empty()) {
+            return;
+        }
+        ExtractionStatsRecorder::Scope scope(m_output.Stats(), ExtractionPhase::WriteData, batch.data.size());
+        TraceRecorder::Span span(m_output.Trace(), "write-batch", batch.data.size());
+        Wait(m_batches[m_current ^ 1]);
+        Submit(batch);
+        m_current ^= 1;
+    }
+
+    void UringFileWriter::Submit(Batch& batch) {
+        unsigned batchIndex = static_cast<unsigned>(&batch - m_batches);
+        unsigned tail = *m_ring.sqTail;
+        io_uring_sqe* sqes = static_cast<io_uring_sqe*>(m_ring.sqes);
+        auto nextSqe = [&]() {
+            unsigned index = tail++ & m_ring.sqMask;
+            m_ring.sqArray[index] = index;
+            io_uring_sqe* sqe = &sqes[index];
+            std::memset(sqe, 0, sizeof(*sqe));
+            return sqe;
+        };
+
+        // One linked chain per file; opens and writes post completions only on failure
+        for (size_t i = 0; i < batch.files.size(); ++i) {
+            const PendingFile& file = batch.files[i];
+            unsigned slot = batch.slotBase + static_cast<unsigned>(i);
+
+            io_uring_sqe* open = nextSqe();
+            open->opcode = IORING_OP_OPENAT;
+            open->flags = IOSQE_IO_LINK | IOSQE_CQE_SKIP_SUCCESS;
+            open->fd = file.directory->fd;
+            open->addr = reinterpret_cast<uint64_t>(file.fileName.c_str());
+            open->len = file.attributes.permissions & 0777;  // Masked by the umask
+            open->open_flags = O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW;  // Fixed files are never inherited
+            open->file_index = slot + 1;
+            open->user_data = MakeUserData(batchIndex, i, OpenOperation);
+
+            io_uring_sqe* write = nextSqe();
+            write->opcode = IORING_OP_WRITE;
+            write->flags = IOSQE_FIXED_FILE | IOSQE_IO_LINK | IOSQE_CQE_SKIP_SUCCESS;
+            write->fd = static_cast<int>(slot);
+            write->addr = reinterpret_cast<uint64_t>(batch.data.data() + file.dataOffset);
+            write->len = static_cast<uint32_t>(file.length);
+            write->off = 0;
+            write->user_data = MakeUserData(batchIndex, i, WriteOperation);
+
+            io_uring_sqe* close = nextSqe();
+            close->opcode = IORING_OP_CLOSE;
+            close->file_index = slot + 1;
+            close->user_data = MakeUserData(batchIndex, i, CloseOperation);
+        }
+        StoreRelease(m_ring.sqTail, tail);
+        batch.inFlight = batch.files.size();
+
+        unsigned remaining = static_cast<unsigned>(batch.files.size() * 3);
+        while (remaining > 0) {
+            int submitted = EnterRing(m_ring.fd, remaining, 0, 0);
+            CountSystemCalls();
+            if (submitted >= 0) {
+                remaining -= static_cast<unsigned>(submitted);
+            } else if (errno == EBUSY || errno == EAGAIN) {
+                Reap(false);
+            } else if (errno != EINTR) {
+                // The unsubmitted chains never complete; fail them all
+                for (PendingFile& file : batch.files) {
+                    file.failed = true;
+                }
+                batch.inFlight = 0;
+                return;
+            }
+        }
+    }
+
+    void UringFileWriter::Wait(Batch& batch) {
+        while (batch.inFlight > 0) {
+            Reap(true);
+        }
+
+        for (size_t i = 0; i < batch.files.size(); ++i) {
+            PendingFile& file = batch.files[i];
+            if (file.exists) {
+                // A file already on disk is replaced through OutputTree, which also resets
+                // its mode; the kernel only applies one to files it creates
+                OutputFile output;
+                file.failed = !m_output.OpenFile(file.path, file.attributes, output) ||
+                              !output.Write(0, batch.data.data() + file.dataOffset, file.length) ||
+                              !output.Close(file.length);
+            } else if (file.failed) {
+                // The close linked to a failed open or write never ran; empty the slot here
+                // so the file does not stay open until the slot is reused
+                int closed = -1;
+                io_uring_files_update update;
+                std::memset(&update, 0, sizeof(update));
+                update.offset = batch.slotBase + static_cast<unsigned>(i);
+                update.fds = reinterpret_cast<uint64_t>(&closed);
+                RegisterRing(m_ring.fd, IORING_REGISTER_FILES_UPDATE, &update, 1);
+                CountSystemCalls();
+            } else {
+                // The modification time is set by name once the file is closed
+                struct timespec times[2];
+                times[0].tv_sec = 0;
+                times[0].tv_nsec = UTIME_NOW;
+                times[1].tv_sec = static_cast<time_t>(file.attributes.mtime);
+                times[1].tv_nsec = 0;
+                file.failed = utimensat(file.directory->fd, file.fileName.c_str(), times, AT_SYMLINK_NOFOLLOW) != 0;
+                CountSystemCalls();
+            }
+            if (file.failed && !m_failed) {
+                m_failed = true;
+                m_failedName = file.name;
+            }
+            m_output.NoteFile(file.name, file.failed ? FileOutcome::Lost : FileOutcome::Written);
+        }
+        batch.files.clear();
+        batch.data.clear();
+        batch.paths.clear();
+    }
+
+    void UringFileWriter::Reap(bool wait) {
+        if (wait) {
+            CountSystemCalls();
+        }
+        if (wait && EnterRing(m_ring.fd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+            // Nothing will complete any more
+            for (Batch& batch : m_batches) {
+                for (PendingFile& file : batch.files) {
+                    file.failed = true;
+                }
+                batch.inFlight = 0;
+            }
+            return;
+        }
+
+        const io_uring_cqe* cqes = static_cast<const io_uring_cqe*>(m_ring.cqes);
+        unsigned head = *m_ring.cqHead;
+        unsigned tail = LoadAcquire(m_ring.cqTail);
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe = cqes[head & m_ring.cqMask];
+            Batch& batch = m_batches[cqe.user_data >> 32];
+            PendingFile& file = batch.files[(cqe.user_data & 0xFFFFFFFFu) >> 2];
+            Operation operation = static_cast<Operation>(cqe.user_data & 3);
+
+            // Each chain posts one completion: its close, or else the first operation that
+            // failed (a short write included), after which the rest of it is cancelled silently.
+            // An open that found the file already there is retried in Wait.
+            if (operation == OpenOperation && cqe.res == -EEXIST) {
+                file.exists = true;
+            } else if (operation != CloseOperation || cqe.res < 0) {
+                file.failed = true;
+            }
+            --batch.inFlight;
+        }
+        StoreRelease(m_ring.cqHead, head);
+    }
+#else
+    UringFileWriter::UringFileWriter(OutputTree&) {
+    }
+
+    UringFileWriter::~UringFileWriter() {
+    }
+
+    bool UringFileWriter::IsAvailable() const {
+        return false;
+    }
+
+    bool UringFileWriter::AddFile(const std::wstring&, const std::wstring&, const OutputFileAttributes&, size_t, char*&) {
+        return false;
+    }
+
+    void UringFileWriter::WaitFor(const std::wstring&) {
+    }
+
+    bool UringFileWriter::Finish(std::wstring& failedName) {
+        failedName.clear();
+        return true;
+    }
+#endif
+
+} // namespace ArchiveEngine
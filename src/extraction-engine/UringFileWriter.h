@@ -0,0 +1,111 @@
+#pragma once
+
+#include "OutputTree.h"
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace ArchiveEngine {
+
+    // Creates and writes small files in batches through io_uring.
+    //
+    // Each file becomes one linked openat, write, close chain on a fixed file slot, so a
+    // batch of files costs one submission instead of several system calls per file, and
+    // the kernel works through the chains in parallel. One batch is in flight while the
+    // next one is filled. Files are created relative to OutputTree's directory handles
+    // with O_EXCL, so permission bits are applied at creation (masked by the umask), and
+    // the modification time once the file is closed. A file that already exists is
+    // replaced through OutputTree once its batch has completed.
+    //
+    // Requires Linux 5.17 or later. Where io_uring is missing, too old or blocked,
+    // IsAvailable() is false and files should be written through OutputTree instead.
+    class UringFileWriter {
+    public:
+        // Largest file accepted by AddFile
+        static constexpr size_t MaxFileSize = 64 * 1024;
+
+        explicit UringFileWriter(OutputTree& output);
+        ~UringFileWriter();  // Waits for the files in flight
+
+        UringFileWriter(const UringFileWriter&) = delete;
+        UringFileWriter& operator=(const UringFileWriter&) = delete;
+
+        bool IsAvailable() const;
+
+        // Queues the file `path` of `size` bytes (at most MaxFileSize); `name` identifies it
+        // in error reports. `data` receives where its contents go, valid until the next
+        // call. False if its directory cannot be created.
+        bool AddFile(const std::wstring& path, const std::wstring& name, const OutputFileAttributes& attributes,
+                     size_t size, char*& data);
+
+        // Writes out any file at `path` that is queued or in flight, so that the path can
+        // be written by other means without a batch replacing it afterwards
+        void WaitFor(const std::wstring& path);
+
+        // True once any file has failed to be written
+        bool Failed() const { return m_failed; }
+
+        // Writes everything queued. Returns false and the name of the first file that
+        // could not be written if any failed.
+        bool Finish(std::wstring& failedName);
+
+    private:
+        bool m_available = false;
+        bool m_failed = false;
+        std::wstring m_failedName;
+
+#ifdef __linux__
+        struct PendingFile {
+            OutputTree::DirectoryPtr directory;  // Keeps the descriptor open while in flight
+            std::string fileName;
+            std::wstring path;
+            std::wstring name;
+            size_t dataOffset;
+            size_t length;
+            OutputFileAttributes attributes;
+            bool failed;
+            bool exists;  // The open found a file there already
+        };
+
+        struct Batch {
+            std::vector<PendingFile> files;
+            std::vector<char> data;              // Reserved up front, never reallocated
+            std::unordered_set<std::wstring> paths;
+            unsigned slotBase = 0;               // First fixed file slot of the batch
+            size_t inFlight = 0;                 // Chains submitted and not yet completed
+        };
+
+        // Shared rings and submission entries mapped from the kernel
+        struct Ring {
+            int fd = -1;
+            void* rings = nullptr;
+            size_t ringsSize = 0;
+            void* sqes = nullptr;
+            size_t sqesSize = 0;
+            unsigned* sqTail = nullptr;
+            unsigned sqMask = 0;
+            unsigned* sqArray = nullptr;
+            unsigned* cqHead = nullptr;
+            unsigned* cqTail = nullptr;
+            unsigned cqMask = 0;
+            void* cqes = nullptr;
+        };
+
+        static constexpr unsigned BatchFiles = 128;
+        static constexpr size_t BatchBytes = 2 * 1024 * 1024;
+
+        bool Setup();
+        void Flush();
+        void Submit(Batch& batch);
+        void Wait(Batch& batch);
+        void Reap(bool wait);
+
+        OutputTree& m_output;
+        Ring m_ring;
+        Batch m_batches[2];
+        unsigned m_current = 0;  // Batch being filled; the other one may be in flight
+#endif
+    };
+
+} // namespace ArchiveEngine
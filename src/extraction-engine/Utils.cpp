@@ -4,14 +4,13 @@
 #include <sstream>
 #include <iomanip>
 #include <codecvt>
-#include <windows.h>
 
 namespace ArchiveEngine {
     namespace Utils {
 
         bool CreateDirectoryRecursive(const std::wstring& path) {
             std::error_code ec;
-            bool result = std::filesystem::create_directories(path, ec);
+            std::filesystem::create_directories(path, ec);
             if (ec) {
                 // If it failed, check if directory already exists
                 return std::filesystem::exists(path) && std::filesystem::is_directory(path);
@@ -165,6 +164,27 @@ namespace ArchiveEngine {
             return components;
         }
 
+        std::string ToUtf8(const std::wstring& str) {
+            std::wstring_convert<std::codecvt_utf8<wchar_t>, wchar_t> converter;
+            return converter.to_bytes(str);
+        }
+
+        std::wstring WidenBytes(std::string_view bytes) {
+            std::wstring str(bytes.size(), L'\0');
+            for (size_t i = 0; i < bytes.size(); ++i) {
+                str[i] = static_cast<wchar_t>(static_cast<unsigned char>(bytes[i]));
+            }
+            return str;
+        }
+
+        std::string NarrowBytes(std::wstring_view str) {
+            std::string bytes(str.size(), '\0');
+            for (size_t i = 0; i < str.size(); ++i) {
+                bytes[i] = static_cast<char>(str[i]);
+            }
+            return bytes;
+        }
+
         std::wstring FormatDuration(double seconds) {
             if (seconds < 1.0) {
                 return std::to_wstring(static_cast<int>(seconds * 1000)) + L"ms";
@@ -422,18 +422,10 @@ void ArchiveExtractor::ExtractArchive(const std::wstring& archivePath, const std
         
         if (!extractor) {
             std::wstring extension = GetFileExtension(archivePath);
-            if (extension == L".gz" || extension == L".bz2" || extension == L".tar.gz" || extension == L".tar.bz2") {
-                MessageBox(NULL, 
-                    L"Compressed archive formats (.gz, .bz2, .tar.gz, .tar.bz2) are not yet implemented.\n"
-                    L"They will be available in the next update when compression library integration is complete.\n\n"
-                    L"Currently supported: .tar archives only.",
-                    L"Archive Extractor - Format Not Yet Available", MB_OK | MB_ICONINFORMATION);
-            } else {
-                MessageBox(NULL, 
-                    (L"Unsupported archive format: " + extension + 
-                     L"\n\nSupported formats: .tar\nComing soon: .gz, .bz2, .tar.gz, .tar.bz2").c_str(),
-                    L"Archive Extractor - Unsupported Format", MB_OK | MB_ICONWARNING);
-            }
+            MessageBox(NULL, 
+                (L"Unsupported archive format: " + extension + 
+                 L"\n\nSupported formats: .tar, .gz, .tar.gz, .tgz, .bz2, .tar.bz2, .tbz2").c_str(),
+                L"Archive Extractor - Unsupported Format", MB_OK | MB_ICONWARNING);
             return;
         }
 
@@ -444,8 +436,10 @@ void ArchiveExtractor::ExtractArchive(const std::wstring& archivePath, const std
             return true; // Continue extraction
         };
 
-        // Perform extraction
-        auto result = extractor->Extract(archivePath, destinationPath, progressCallback);
+        // Perform extraction, reading the archive only once
+        ArchiveEngine::ExtractionOptions options;
+        options.singlePass = true;
+        auto result = extractor->Extract(archivePath, destinationPath, options, progressCallback);
 
         if (result.success) {
             std::wstring message = L"Successfully extracted " + std::to_wstring(result.extractedFiles.size()) + 
@@ -536,7 +530,8 @@ bool ArchiveExtractor::TestArchive(const std::wstring& archivePath)
         if (!extractor)
             return false;
 
-        // Get archive information without extracting
+        // Get archive information without extracting. The archive itself is read every
+        // time: a sidecar index would skip it, and the test must not write next to it.
         std::vector<ArchiveEngine::ArchiveEntry> entries;
         return extractor->GetArchiveInfo(archivePath, entries);
     }
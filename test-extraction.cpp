@@ -1,6 +1,7 @@
 #include "src/extraction-engine/ArchiveExtractor.h"
 #include <iostream>
 #include <filesystem>
+#include <cstring>
 
 int wmain(int argc, wchar_t* argv[]) {
     if (argc != 3) {
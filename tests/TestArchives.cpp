@@ -0,0 +1,255 @@
+#include "TestArchives.h"
+#include <algorithm>
+#include <atomic>
+#include <bzlib.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <zlib.h>
+
+namespace ArchiveEngine {
+namespace Testing {
+
+    namespace {
+
+        void WriteOctal(std::string& block, size_t offset, size_t width, uint64_t value) {
+            // Zero-padded digits ending in NUL, as GNU tar writes them. Values too wide
+            // for the field keep their low digits.
+            char digits[32];
+            int length = std::snprintf(digits, sizeof(digits), "%0*llo", static_cast<int>(width - 1),
+                                       static_cast<unsigned long long>(value));
+            std::memcpy(&block[offset], digits + length - (width - 1), width - 1);
+            block[offset + width - 1] = '\0';
+        }
+
+        std::string PaxRecord(const std::string& key, const std::string& value) {
+            // The length prefix counts its own digits
+            size_t body = key.size() + value.size() + 3;  // ' ', '=' and '\n'
+            size_t length = body + 1;
+            while (std::to_string(length).size() + body != length) {
+                ++length;
+            }
+            return std::to_string(length) + " " + key + "=" + value + "\n";
+        }
+
+        std::string PadToBlock(std::string data) {
+            data.resize((data.size() + 511) / 512 * 512, '\0');
+            return data;
+        }
+
+    } // namespace
+
+    TempDirectory::TempDirectory() {
+        static std::atomic<unsigned> counter{ 0 };
+        std::random_device random;
+        m_path = std::filesystem::temp_directory_path() /
+                 ("archive-engine-test-" + std::to_string(random()) + "-" + std::to_string(counter++));
+        std::filesystem::create_directories(m_path);
+    }
+
+    TempDirectory::~TempDirectory() {
+        std::error_code ec;
+        std::filesystem::remove_all(m_path, ec);
+    }
+
+    void WriteFile(const std::wstring& path, const std::string& data) {
+        std::ofstream file(std::filesystem::path(path), std::ios::binary | std::ios::trunc);
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!file) {
+            throw std::runtime_error("cannot write test file");
+        }
+    }
+
+    std::string ReadFile(const std::wstring& path) {
+        std::ifstream file(std::filesystem::path(path), std::ios::binary);
+        if (!file) {
+            return std::string();
+        }
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    std::string SampleData(size_t size, uint32_t seed, bool compressible) {
+        static const char* const words[] = { "archive", "block", "header", "stream", "window",
+                                             "member", "entry", "sparse", "tar", "gzip" };
+        std::mt19937 random(seed);
+        std::string data;
+        data.reserve(size + 16);
+        while (data.size() < size) {
+            if (compressible) {
+                data += words[random() % 10];
+                data += random() % 8 == 0 ? '\n' : ' ';
+            } else {
+                data += static_cast<char>(random() & 0xFF);
+            }
+        }
+        data.resize(size);
+        return data;
+    }
+
+    std::string ReadAll(IArchiveSource& source, size_t piece) {
+        std::string output;
+        const char* data = nullptr;
+        while (size_t length = source.Read(data, piece)) {
+            output.append(data, length);
+        }
+        return output;
+    }
+
+    std::string GzipCompress(const std::string& data, int level) {
+        z_stream stream;
+        std::memset(&stream, 0, sizeof(stream));
+        // 16 + 15 window bits: a gzip wrapper around a 32 KiB window
+        if (deflateInit2(&stream, level, Z_DEFLATED, 16 + 15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            throw std::runtime_error("deflateInit2 failed");
+        }
+        std::string output(deflateBound(&stream, static_cast<uLong>(data.size())), '\0');
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+        stream.avail_in = static_cast<uInt>(data.size());
+        stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+        stream.avail_out = static_cast<uInt>(output.size());
+        int status = deflate(&stream, Z_FINISH);
+        output.resize(stream.total_out);
+        deflateEnd(&stream);
+        if (status != Z_STREAM_END) {
+            throw std::runtime_error("deflate failed");
+        }
+        return output;
+    }
+
+    std::string Bzip2Compress(const std::string& data, int blockSize100k) {
+        // Worst case per the libbzip2 manual: 1% larger plus 600 bytes
+        unsigned int length = static_cast<unsigned int>(data.size() + data.size() / 100 + 600);
+        std::string output(length, '\0');
+        if (BZ2_bzBuffToBuffCompress(&output[0], &length, const_cast<char*>(data.data()),
+                                     static_cast<unsigned int>(data.size()), blockSize100k, 0, 0) != BZ_OK) {
+            throw std::runtime_error("BZ2_bzBuffToBuffCompress failed");
+        }
+        output.resize(length);
+        return output;
+    }
+
+    std::string TarBuilder::Header(const std::string& name, uint64_t size, char type,
+                                   uint32_t mode, uint64_t mtime, bool gnu) {
+        std::string block(512, '\0');
+        std::memcpy(&block[0], name.data(), std::min<size_t>(name.size(), 100));
+        WriteOctal(block, 100, 8, mode);
+        WriteOctal(block, 108, 8, 0);
+        WriteOctal(block, 116, 8, 0);
+        WriteOctal(block, 124, 12, size);
+        WriteOctal(block, 136, 12, mtime);
+        block[156] = type;
+        std::memcpy(&block[257], gnu ? "ustar  " : "ustar\0" "00", 8);
+        SetChecksum(block);
+        return block;
+    }
+
+    void TarBuilder::SetChecksum(std::string& header) {
+        // Summed with the checksum field itself read as spaces
+        std::memset(&header[148], ' ', 8);
+        uint32_t sum = 0;
+        for (unsigned char ch : header) {
+            sum += ch;
+        }
+        std::snprintf(&header[148], 7, "%06o", sum);
+        header[154] = '\0';
+        header[155] = ' ';
+    }
+
+    void TarBuilder::AddData(const std::string& data) {
+        m_data += PadToBlock(data);
+    }
+
+    void TarBuilder::AddFile(const std::string& name, const std::string& data, uint32_t mode) {
+        m_data += Header(name, data.size(), '0', mode);
+        AddData(data);
+    }
+
+    void TarBuilder::AddDirectory(const std::string& name, uint32_t mode) {
+        m_data += Header(name, 0, '5', mode);
+    }
+
+    void TarBuilder::AddBase256File(const std::string& name, const std::string& data) {
+        std::string header = Header(name, 0, '0', 0644, 1700000000, true);
+        // Leading 0x80, then the value big-endian in the remaining 11 bytes
+        std::memset(&header[124], 0, 12);
+        header[124] = static_cast<char>(0x80);
+        uint64_t size = data.size();
+        for (int i = 11; i > 0 && size > 0; --i, size >>= 8) {
+            header[124 + i] = static_cast<char>(size & 0xFF);
+        }
+        SetChecksum(header);
+        m_data += header;
+        AddData(data);
+    }
+
+    void TarBuilder::AddGnuSparse(const std::string& name, uint64_t realSize,
+                                  const std::vector<SparseRegion>& regions) {
+        std::string stored;
+        for (const auto& region : regions) {
+            stored += region.second;
+        }
+
+        std::string header = Header(name, stored.size(), 'S', 0644, 1700000000, true);
+        auto writeRegion = [](std::string& block, size_t offset, const SparseRegion& region) {
+            WriteOctal(block, offset, 12, region.first);
+            WriteOctal(block, offset + 12, 12, region.second.size());
+        };
+
+        // Four regions fit in the header, 21 in each extension block
+        size_t next = 0;
+        for (; next < regions.size() && next < 4; ++next) {
+            writeRegion(header, 386 + next * 24, regions[next]);
+        }
+        WriteOctal(header, 483, 12, realSize);
+        header[482] = next < regions.size() ? 1 : 0;
+        SetChecksum(header);
+        m_data += header;
+
+        while (next < regions.size()) {
+            std::string extension(512, '\0');
+            for (size_t slot = 0; slot < 21 && next < regions.size(); ++slot, ++next) {
+                writeRegion(extension, slot * 24, regions[next]);
+            }
+            extension[504] = next < regions.size() ? 1 : 0;
+            m_data += extension;
+        }
+        AddData(stored);
+    }
+
+    void TarBuilder::AddPaxSparse(const std::string& name, uint64_t realSize,
+                                  const std::vector<SparseRegion>& regions) {
+        std::string map = std::to_string(regions.size()) + "\n";
+        std::string stored;
+        for (const auto& region : regions) {
+            map += std::to_string(region.first) + "\n" + std::to_string(region.second.size()) + "\n";
+            stored += region.second;
+        }
+        map = PadToBlock(map);
+
+        std::string records = PaxRecord("GNU.sparse.major", "1") +
+                              PaxRecord("GNU.sparse.minor", "0") +
+                              PaxRecord("GNU.sparse.name", name) +
+                              PaxRecord("GNU.sparse.realsize", std::to_string(realSize));
+        m_data += Header("PaxHeaders/" + name, records.size(), 'x');
+        AddData(records);
+        m_data += Header("GNUSparseFile.0/" + name, map.size() + stored.size(), '0');
+        AddData(map + stored);
+    }
+
+    std::string TarBuilder::Finish() const {
+        return m_data + std::string(1024, '\0');
+    }
+
+    std::string TarBuilder::Expand(uint64_t realSize, const std::vector<SparseRegion>& regions) {
+        std::string data(static_cast<size_t>(realSize), '\0');
+        for (const auto& region : regions) {
+            data.replace(static_cast<size_t>(region.first), region.second.size(), region.second);
+        }
+        return data;
+    }
+
+} // namespace Testing
+} // namespace ArchiveEngine
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "extraction-engine/ArchiveSource.h"
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ArchiveEngine {
+namespace Testing {
+
+    // Scratch directory, removed with everything in it when the test ends
+    class TempDirectory {
+    public:
+        TempDirectory();
+        ~TempDirectory();
+
+        TempDirectory(const TempDirectory&) = delete;
+        TempDirectory& operator=(const TempDirectory&) = delete;
+
+        const std::filesystem::path& Path() const { return m_path; }
+        std::wstring operator/(const std::string& name) const { return (m_path / name).wstring(); }
+
+    private:
+        std::filesystem::path m_path;
+    };
+
+    void WriteFile(const std::wstring& path, const std::string& data);
+    std::string ReadFile(const std::wstring& path);
+
+    // Deterministic test data: words from a small vocabulary when `compressible`,
+    // uniformly random bytes otherwise
+    std::string SampleData(size_t size, uint32_t seed, bool compressible = true);
+
+    // Everything `source` produces, read in pieces of at most `piece` bytes
+    std::string ReadAll(IArchiveSource& source, size_t piece = SIZE_MAX);
+
+    // One gzip member or bzip2 stream as written by zlib and libbzip2
+    std::string GzipCompress(const std::string& data, int level = 6);
+    std::string Bzip2Compress(const std::string& data, int blockSize100k = 9);
+
+    // Stored data region of a sparse file: its offset and contents
+    using SparseRegion = std::pair<uint64_t, std::string>;
+
+    // Assembles a TAR archive in memory, one member at a time
+    class TarBuilder {
+    public:
+        // A 512-byte ustar header with its checksum set; GNU headers carry the
+        // "ustar  " magic and their own layout past the link name
+        static std::string Header(const std::string& name, uint64_t size, char type,
+                                  uint32_t mode = 0644, uint64_t mtime = 1700000000, bool gnu = false);
+
+        // Recomputes the checksum of a header edited after the fact
+        static void SetChecksum(std::string& header);
+
+        void AddFile(const std::string& name, const std::string& data, uint32_t mode = 0644);
+        void AddDirectory(const std::string& name, uint32_t mode = 0755);
+
+        // A regular file whose size field is in GNU base-256 form
+        void AddBase256File(const std::string& name, const std::string& data);
+
+        // Sparse files in the old GNU format ('S', with extension blocks past four
+        // regions) and in PAX format 1.0 (the map leading the data)
+        void AddGnuSparse(const std::string& name, uint64_t realSize, const std::vector<SparseRegion>& regions);
+        void AddPaxSparse(const std::string& name, uint64_t realSize, const std::vector<SparseRegion>& regions);
+
+        // Appends raw bytes, e.g. a hand-edited header
+        void AddRaw(const std::string& data) { m_data += data; }
+
+        // The archive with its end-of-archive blocks
+        std::string Finish() const;
+
+        // Contents of a sparse file: zeros except for `regions`
+        static std::string Expand(uint64_t realSize, const std::vector<SparseRegion>& regions);
+
+    private:
+        void AddData(const std::string& data);
+
+        std::string m_data;
+    };
+
+} // namespace Testing
+} // namespace ArchiveEngine
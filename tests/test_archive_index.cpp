@@ -0,0 +1,143 @@
+#include "TestArchives.h"
+#include "extraction-engine/ArchiveIndex.h"
+#include "extraction-engine/TarExtractor.h"
+#include <chrono>
+#include <cstring>
+#include <gtest/gtest.h>
+
+using namespace ArchiveEngine;
+using namespace ArchiveEngine::Testing;
+
+namespace {
+
+    ExtractionResult ExtractTar(const std::wstring& archive, const std::wstring& destination,
+                                const ExtractionOptions& options = ExtractionOptions()) {
+        TarExtractor extractor;
+        return extractor.Extract(archive, destination, options);
+    }
+
+    ExtractionResult ExtractSelected(const std::wstring& archive, const std::wstring& destination,
+                                     const std::vector<std::wstring>& paths, bool useIndex) {
+        TarExtractor extractor;
+        ExtractionOptions options;
+        options.useIndex = useIndex;
+        return extractor.Extract(archive, destination, paths, options);
+    }
+
+} // namespace
+
+TEST(ArchiveIndex, IsWrittenByExtractionAndFindsLastCopy) {
+    TempDirectory temp;
+    TarBuilder tar;
+    tar.AddFile("a.txt", "first");
+    tar.AddDirectory("d/");
+    tar.AddFile("d/b.txt", "b");
+    tar.AddFile("a.txt", "second");
+    WriteFile(temp / "idx.tar", tar.Finish());
+
+    ExtractionOptions options;
+    options.useIndex = true;
+    ASSERT_TRUE(ExtractTar(temp / "idx.tar", temp / "out", options).success);
+
+    ArchiveIndex index;
+    ASSERT_TRUE(index.Load(temp / "idx.tar"));
+    ASSERT_EQ(index.Size(), 4u);
+    EXPECT_EQ(index.Find("a.txt"), 3u);
+    EXPECT_EQ(index.Find("d/b.txt"), 2u);
+    EXPECT_EQ(index.Find("nothing"), ArchiveIndex::NotFound);
+    EXPECT_EQ(index.Entry(2).size, 1u);
+}
+
+TEST(ArchiveIndex, IsIgnoredOnceTheArchiveChanges) {
+    TempDirectory temp;
+    TarBuilder before;
+    before.AddFile("a.txt", "old");
+    WriteFile(temp / "s.tar", before.Finish());
+
+    ExtractionOptions options;
+    options.useIndex = true;
+    ASSERT_TRUE(ExtractTar(temp / "s.tar", temp / "out1", options).success);
+    ArchiveIndex index;
+    ASSERT_TRUE(index.Load(temp / "s.tar"));
+
+    // Same size, new modification time
+    TarBuilder same;
+    same.AddFile("a.txt", "new");
+    WriteFile(temp / "s.tar", same.Finish());
+    std::filesystem::last_write_time(temp / "s.tar",
+                                     std::filesystem::last_write_time(temp / "s.tar") + std::chrono::hours(1));
+    EXPECT_FALSE(ArchiveIndex().Load(temp / "s.tar"));
+    ASSERT_TRUE(ExtractSelected(temp / "s.tar", temp / "out2", { L"a.txt" }, true).success);
+    EXPECT_EQ(ReadFile(temp / "out2/a.txt"), "new");
+
+    // New size; the rewritten index covers the new entries
+    ASSERT_TRUE(ExtractTar(temp / "s.tar", temp / "out3", options).success);
+    TarBuilder grown;
+    grown.AddFile("a.txt", "newer");
+    grown.AddFile("b.txt", SampleData(3000, 45));
+    WriteFile(temp / "s.tar", grown.Finish());
+    EXPECT_FALSE(ArchiveIndex().Load(temp / "s.tar"));
+    ExtractionResult result = ExtractSelected(temp / "s.tar", temp / "out4", { L"b.txt" }, true);
+    ASSERT_TRUE(result.success);
+    EXPECT_EQ(ReadFile(temp / "out4/b.txt"), SampleData(3000, 45));
+
+    ASSERT_TRUE(ExtractTar(temp / "s.tar", temp / "out5", options).success);
+    ArchiveIndex rebuilt;
+    ASSERT_TRUE(rebuilt.Load(temp / "s.tar"));
+    EXPECT_EQ(rebuilt.Size(), 2u);
+}
+
+TEST(ArchiveIndex, AnswersListingsWithoutReadingTheArchive) {
+    TempDirectory temp;
+    TarBuilder tar;
+    tar.AddDirectory("d/", 0700);
+    tar.AddFile("d/a.txt", SampleData(3000, 53), 0640);
+    std::string archive = tar.Finish();
+    WriteFile(temp / "l.tar", archive);
+
+    ExtractionOptions options;
+    options.useIndex = true;
+    std::vector<ArchiveEntry> listed;
+    ASSERT_TRUE(TarExtractor().GetArchiveInfo(temp / "l.tar", options, listed));
+    ASSERT_TRUE(std::filesystem::exists(ArchiveIndex::IndexPath(temp / "l.tar")));
+
+    // Damage the headers but keep the size and modification time the index was checked against
+    auto mtime = std::filesystem::last_write_time(temp / "l.tar");
+    std::memset(&archive[0], 'x', 1024);
+    WriteFile(temp / "l.tar", archive);
+    std::filesystem::last_write_time(temp / "l.tar", mtime);
+
+    std::vector<ArchiveEntry> entries;
+    EXPECT_FALSE(TarExtractor().GetArchiveInfo(temp / "l.tar", entries));
+    ASSERT_TRUE(TarExtractor().GetArchiveInfo(temp / "l.tar", options, entries));
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[0].name, L"d/");
+    EXPECT_TRUE(entries[0].isDirectory);
+    EXPECT_EQ(entries[1].name, L"d/a.txt");
+    EXPECT_EQ(entries[1].size, 3000u);
+    EXPECT_EQ(entries[1].permissions, 0640u);
+    EXPECT_EQ(entries[1].lastModified, listed[1].lastModified);
+}
+
+TEST(ArchiveIndex, FindsEveryPathAmongManyEntries) {
+    TempDirectory temp;
+    TarBuilder tar;
+    for (int i = 999; i >= 0; --i) {
+        tar.AddFile("dir" + std::to_string(i % 7) + "/file" + std::to_string(i), "");
+    }
+    WriteFile(temp / "many.tar", tar.Finish());
+
+    ExtractionOptions options;
+    options.useIndex = true;
+    std::vector<ArchiveEntry> entries;
+    ASSERT_TRUE(TarExtractor().GetArchiveInfo(temp / "many.tar", options, entries));
+    ArchiveIndex index;
+    ASSERT_TRUE(index.Load(temp / "many.tar"));
+    for (int i = 0; i < 1000; ++i) {
+        std::string name = "dir" + std::to_string(i % 7) + "/file" + std::to_string(i);
+        ASSERT_EQ(index.Find(name), static_cast<size_t>(999 - i)) << name;
+    }
+    EXPECT_EQ(index.Find("dir0"), ArchiveIndex::NotFound);
+    EXPECT_EQ(index.Find("dir0/file"), ArchiveIndex::NotFound);
+    EXPECT_EQ(index.Find("dir9/file999"), ArchiveIndex::NotFound);
+}
@@ -0,0 +1,180 @@
+#include "TestArchives.h"
+#include "extraction-engine/ArchiveExtractor.h"
+#include "extraction-engine/ArchiveSource.h"
+#include "extraction-engine/TarExtractor.h"
+#include <gtest/gtest.h>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+using namespace ArchiveEngine;
+using namespace ArchiveEngine::Testing;
+
+namespace {
+
+    // Reads `data` back through `source` in blocks of `block` bytes, skipping every
+    // third block, and checks each one and the position after it
+    void CheckBlocksAndSkips(IArchiveSource& source, const std::string& data, size_t block) {
+        uint64_t position = 0;
+        for (size_t i = 0; position + block <= data.size(); ++i) {
+            if (i % 3 == 2) {
+                ASSERT_TRUE(source.Skip(block));
+            } else {
+                const char* bytes = source.ReadBlock(block);
+                ASSERT_NE(bytes, nullptr) << position;
+                ASSERT_EQ(std::string(bytes, block), data.substr(position, block)) << position;
+            }
+            position += block;
+            ASSERT_EQ(source.Position(), position);
+        }
+        EXPECT_EQ(source.ReadBlock(data.size() - position + 1), nullptr);
+    }
+
+} // namespace
+
+TEST(ArchiveSource, MappedAndReadAheadSourcesAgree) {
+    TempDirectory temp;
+    std::string data = SampleData(1024 * 1024 + 333, 180, false);
+    WriteFile(temp / "data.bin", data);
+
+    MappedArchiveSource mapped;
+    ASSERT_TRUE(mapped.Open(temp / "data.bin"));
+    EXPECT_TRUE(ReadAll(mapped, 7777) == data);
+
+    // The smallest window, so blocks straddle buffers and reads wait on the reader
+    for (size_t piece : { size_t(1000), size_t(65536), SIZE_MAX }) {
+        ReadAheadArchiveSource source(0);
+        ASSERT_TRUE(source.Open(temp / "data.bin"));
+        EXPECT_TRUE(ReadAll(source, piece) == data) << piece;
+        EXPECT_EQ(source.Position(), data.size());
+    }
+
+    ReadAheadArchiveSource blocks(0);
+    ASSERT_TRUE(blocks.Open(temp / "data.bin"));
+    CheckBlocksAndSkips(blocks, data, 1000);
+    MappedArchiveSource mappedBlocks;
+    ASSERT_TRUE(mappedBlocks.Open(temp / "data.bin"));
+    CheckBlocksAndSkips(mappedBlocks, data, 1000);
+}
+
+TEST(ArchiveSource, MappedSourceHandsOutBlocksInPlace) {
+    TempDirectory temp;
+    std::string data = SampleData(3 * 512 + 100, 183, false);
+    WriteFile(temp / "data.bin", data);
+
+    MappedFile file;
+    ASSERT_TRUE(file.Open(temp / "data.bin"));
+    ASSERT_EQ(file.Size(), data.size());
+
+    // Blocks are pointers into the mapping, one after another, with no copy in between
+    MappedArchiveSource source;
+    ASSERT_TRUE(source.Open(temp / "data.bin"));
+    const char* first = source.ReadBlock(512);
+    ASSERT_NE(first, nullptr);
+    ASSERT_TRUE(source.Skip(512));
+    const char* third = source.ReadBlock(512);
+    ASSERT_NE(third, nullptr);
+    EXPECT_EQ(third - first, 1024);
+    EXPECT_EQ(std::string(third, 512), data.substr(1024, 512));
+#ifndef _WIN32
+    EXPECT_GE(source.Descriptor(), 0);
+#endif
+
+    // What is left is shorter than a block; reading one fails without moving
+    EXPECT_EQ(source.ReadBlock(512), nullptr);
+    const char* rest = nullptr;
+    EXPECT_EQ(source.Read(rest, SIZE_MAX), 100u);
+    EXPECT_EQ(rest, third + 512);
+    EXPECT_EQ(source.Position(), data.size());
+    EXPECT_FALSE(source.Skip(1));
+
+    // Empty and missing files are not mapped
+    WriteFile(temp / "empty.bin", std::string());
+    EXPECT_FALSE(MappedArchiveSource().Open(temp / "empty.bin"));
+    EXPECT_FALSE(MappedArchiveSource().Open(temp / "missing.bin"));
+}
+
+TEST(ArchiveSource, ReadAheadSkipsPastTheWindow) {
+    TempDirectory temp;
+    std::string data = SampleData(8 * 1024 * 1024, 181, false);
+    WriteFile(temp / "data.bin", data);
+
+    ReadAheadArchiveSource source(256 * 1024);
+    ASSERT_TRUE(source.Open(temp / "data.bin"));
+#ifndef _WIN32
+    EXPECT_GE(source.Descriptor(), 0);
+#endif
+    const char* bytes = source.ReadBlock(512);
+    ASSERT_NE(bytes, nullptr);
+    ASSERT_TRUE(source.Skip(5 * 1024 * 1024));
+    bytes = source.ReadBlock(512);
+    ASSERT_NE(bytes, nullptr);
+    EXPECT_EQ(std::string(bytes, 512), data.substr(5 * 1024 * 1024 + 512, 512));
+    EXPECT_FALSE(source.Skip(data.size()));
+}
+
+TEST(ArchiveSource, OpensEmptyFilesAndRequestedReadAhead) {
+    TempDirectory temp;
+    WriteFile(temp / "empty.bin", std::string());
+    WriteFile(temp / "data.bin", "contents");
+
+    // An empty file cannot be mapped and is read instead
+    auto empty = OpenArchiveSource(temp / "empty.bin");
+    ASSERT_TRUE(empty);
+    const char* data = nullptr;
+    EXPECT_EQ(empty->Read(data, 100), 0u);
+
+    auto readAhead = OpenArchiveSource(temp / "data.bin", 1024 * 1024);
+    ASSERT_TRUE(readAhead);
+    EXPECT_NE(dynamic_cast<ReadAheadArchiveSource*>(readAhead.get()), nullptr);
+    EXPECT_EQ(ReadAll(*readAhead), "contents");
+
+    EXPECT_FALSE(OpenArchiveSource(temp / "missing.bin"));
+}
+
+#ifndef _WIN32
+TEST(ArchiveSource, ReadsAheadFromPipes) {
+    TempDirectory temp;
+    std::string data = SampleData(3 * 1024 * 1024 + 17, 182, false);
+    std::filesystem::path fifo = temp.Path() / "pipe";
+    ASSERT_EQ(::mkfifo(fifo.c_str(), 0600), 0);
+
+    // Opening either end blocks until the other is opened too
+    std::thread writer([&] { WriteFile(fifo.wstring(), data); });
+    auto source = OpenArchiveSource(fifo.wstring());
+    ASSERT_TRUE(source);
+    EXPECT_EQ(source->Descriptor(), -1);
+    const char* bytes = source->ReadBlock(100);
+    ASSERT_NE(bytes, nullptr);
+    ASSERT_TRUE(source->Skip(2 * 1024 * 1024));
+    std::string rest = ReadAll(*source, 4096);
+    writer.join();
+    EXPECT_TRUE(rest == data.substr(100 + 2 * 1024 * 1024));
+}
+#endif
+
+#ifndef _WIN32
+TEST(ArchiveSource, ReadErrorsAreNotTheEndOfTheStream) {
+    TempDirectory temp;
+    std::filesystem::create_directories(temp / "archive.tar");
+
+    // A directory opens for reading but every read fails (EISDIR)
+    ReadAheadArchiveSource source(256 * 1024);
+    ASSERT_TRUE(source.Open(temp / "archive.tar"));
+    EXPECT_THROW(source.ReadBlock(512), ExtractionException);
+    const char* data = nullptr;
+    EXPECT_THROW(source.Read(data, 512), ExtractionException);
+    EXPECT_THROW(source.Skip(512), ExtractionException);
+
+    // The extractor reports the error instead of an empty archive
+    ExtractionOptions options;
+    options.readAheadWindow = 256 * 1024;
+    ExtractionResult result = TarExtractor().Extract(temp / "archive.tar", temp / "out", options);
+    EXPECT_FALSE(result.success);
+    EXPECT_NE(result.errorMessage.find(L"cannot read archive"), std::wstring::npos);
+    std::vector<ArchiveEntry> entries;
+    EXPECT_FALSE(TarExtractor().GetArchiveInfo(temp / "archive.tar", options, entries));
+}
+#endif
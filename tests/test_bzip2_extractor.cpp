@@ -0,0 +1,136 @@
+#include "TestArchives.h"
+#include "extraction-engine/Bzip2.h"
+#include "extraction-engine/Bzip2Extractor.h"
+#include <gtest/gtest.h>
+
+using namespace ArchiveEngine;
+using namespace ArchiveEngine::Testing;
+
+namespace {
+
+    std::string Decode(const std::wstring& path, unsigned threads) {
+        auto source = OpenBzip2Source(path, threads);
+        EXPECT_TRUE(source != nullptr);
+        return source ? ReadAll(*source) : std::string();
+    }
+
+    ExtractionResult ExtractBzip2(const std::wstring& archive, const std::wstring& destination) {
+        Bzip2Extractor extractor;
+        return extractor.Extract(archive, destination, ExtractionOptions());
+    }
+
+} // namespace
+
+TEST(Bzip2Extractor, DecodesLibbzip2Output) {
+    TempDirectory temp;
+    std::string text = SampleData(300 * 1024, 21);
+    std::string binary = SampleData(150 * 1024, 22, false);
+    for (int blockSize : { 1, 9 }) {
+        WriteFile(temp / "text.bz2", Bzip2Compress(text, blockSize));
+        WriteFile(temp / "binary.bz2", Bzip2Compress(binary, blockSize));
+        EXPECT_EQ(Decode(temp / "text.bz2", 1), text) << "block size " << blockSize;
+        EXPECT_EQ(Decode(temp / "binary.bz2", 1), binary) << "block size " << blockSize;
+    }
+}
+
+TEST(Bzip2Extractor, DecodesRunsAndEmptyInput) {
+    TempDirectory temp;
+    // Long runs exercise the initial run-length stage
+    std::string runs = std::string(100000, 'a') + std::string(3, 'b') + std::string(70000, '\0');
+    WriteFile(temp / "runs.bz2", Bzip2Compress(runs));
+    EXPECT_EQ(Decode(temp / "runs.bz2", 1), runs);
+
+    WriteFile(temp / "empty.bz2", Bzip2Compress(std::string()));
+    EXPECT_EQ(Decode(temp / "empty.bz2", 1), std::string());
+}
+
+TEST(Bzip2Extractor, ParallelDecoderMatchesSequential) {
+    TempDirectory temp;
+    // Incompressible data spreads 100k blocks over more than the 900k parallel cutoff
+    std::string data = SampleData(1200 * 1024, 23, false);
+    WriteFile(temp / "data.bz2", Bzip2Compress(data, 1));
+    EXPECT_EQ(Decode(temp / "data.bz2", 1), data);
+    EXPECT_EQ(Decode(temp / "data.bz2", 4), data);
+}
+
+TEST(Bzip2Extractor, DecodesConcatenatedStreams) {
+    TempDirectory temp;
+    std::string first = SampleData(200 * 1024, 24);
+    std::string second = SampleData(1000 * 1024, 25, false);
+    std::string third = SampleData(10 * 1024, 26);
+    WriteFile(temp / "multi.bz2", Bzip2Compress(first, 1) + Bzip2Compress(second, 1) + Bzip2Compress(third, 9));
+    EXPECT_EQ(Decode(temp / "multi.bz2", 1), first + second + third);
+    EXPECT_EQ(Decode(temp / "multi.bz2", 4), first + second + third);
+}
+
+TEST(Bzip2Extractor, ExtractsUnderTheArchiveNameWithoutExtension) {
+    TempDirectory temp;
+    std::string data = SampleData(64 * 1024, 27);
+    WriteFile(temp / "notes.txt.bz2", Bzip2Compress(data));
+    ExtractionResult result = ExtractBzip2(temp / "notes.txt.bz2", temp / "out");
+    ASSERT_TRUE(result.success);
+    EXPECT_EQ(ReadFile(temp / "out/notes.txt"), data);
+}
+
+TEST(Bzip2Extractor, RejectsCorruptData) {
+    TempDirectory temp;
+    std::string compressed = Bzip2Compress(SampleData(256 * 1024, 28));
+    for (size_t position : { compressed.size() / 3, compressed.size() / 2, compressed.size() - 6 }) {
+        std::string damaged = compressed;
+        damaged[position] ^= 0x04;
+        WriteFile(temp / "bad.bz2", damaged);
+        EXPECT_FALSE(ExtractBzip2(temp / "bad.bz2", temp / "out").success) << "byte " << position;
+    }
+}
+
+TEST(Bzip2Extractor, RejectsTruncatedData) {
+    TempDirectory temp;
+    std::string compressed = Bzip2Compress(SampleData(1200 * 1024, 29, false), 1);
+    for (size_t cut : { size_t(2), size_t(100), compressed.size() / 2 }) {
+        WriteFile(temp / "cut.bz2", compressed.substr(0, compressed.size() - cut));
+        EXPECT_FALSE(ExtractBzip2(temp / "cut.bz2", temp / "out").success) << cut << " bytes cut";
+
+        ExtractionOptions options;
+        options.decompressionThreads = 4;
+        Bzip2Extractor extractor;
+        EXPECT_FALSE(extractor.Extract(temp / "cut.bz2", temp / "out", options).success) << cut << " bytes cut";
+    }
+}
+
+TEST(Bzip2BlockDecoder, DecodesBlocksFoundByTheirMagic) {
+    std::string data = SampleData(250 * 1024, 30, false);
+    std::string compressed = Bzip2Compress(data, 1);
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(compressed.data());
+
+    // Blocks follow each other without padding; each one's CRC covers its own output
+    Bzip2BlockDecoder decoder;
+    std::string decoded;
+    size_t blocks = 0;
+    uint64_t position = FindBzip2Magic(bytes, compressed.size(), 0, Bzip2BlockMagic);
+    EXPECT_EQ(position, 32u);  // Just past "BZh1"
+    while (position != Bzip2NoPosition) {
+        Bzip2Block block;
+        ASSERT_TRUE(decoder.Decode(bytes, compressed.size(), position, block)) << "block " << blocks;
+        EXPECT_EQ(block.startBit, position);
+        EXPECT_LE(block.symbolCount, 100000u);
+        EXPECT_EQ(Bzip2Crc(0, block.data.data(), block.data.size()), block.crc);
+        decoded.append(block.data.begin(), block.data.end());
+        ++blocks;
+        position = FindBzip2Magic(bytes, compressed.size(), block.endBit, Bzip2BlockMagic);
+        if (position != Bzip2NoPosition) {
+            EXPECT_EQ(position, block.endBit);
+        }
+    }
+    EXPECT_EQ(blocks, 3u);
+    EXPECT_TRUE(decoded == data);
+    EXPECT_NE(FindBzip2Magic(bytes, compressed.size(), 32, Bzip2EndMagic), Bzip2NoPosition);
+}
+
+TEST(Bzip2BlockDecoder, RejectsABlockWhoseCrcDoesNotMatch) {
+    std::string compressed = Bzip2Compress(SampleData(50 * 1024, 31), 9);
+    // The stored CRC follows the 48-bit magic, which starts at byte 4
+    compressed[4 + 6 + 1] ^= 0x10;
+    Bzip2BlockDecoder decoder;
+    Bzip2Block block;
+    EXPECT_FALSE(decoder.Decode(reinterpret_cast<const uint8_t*>(compressed.data()), compressed.size(), 32, block));
+}
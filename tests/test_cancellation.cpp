@@ -0,0 +1,150 @@
+#include "TestArchives.h"
+#include "extraction-engine/OutputTree.h"
+#include "extraction-engine/TarExtractor.h"
+#include <gtest/gtest.h>
+#include <map>
+#include <set>
+#include <thread>
+
+using namespace ArchiveEngine;
+using namespace ArchiveEngine::Testing;
+
+namespace {
+
+    // Archive of `count` files of mixed sizes named f0, f1, ..., and what each holds
+    std::map<std::wstring, std::string> WriteArchive(const std::wstring& path, uint32_t count) {
+        std::map<std::wstring, std::string> contents;
+        TarBuilder tar;
+        for (uint32_t i = 0; i < count; ++i) {
+            size_t size = i % 10 == 5 ? 2 * 1024 * 1024 : i % 3 == 0 ? 1000 : 300 * 1024;
+            std::string data = SampleData(size, 200 + i, false);
+            tar.AddFile("f" + std::to_string(i), data);
+            contents[L"f" + std::to_wstring(i)] = std::move(data);
+        }
+        WriteFile(path, tar.Finish());
+        return contents;
+    }
+
+    // Every file the result lists is on disk whole, and no other file is
+    void ExpectOnlyListedFiles(const std::wstring& root, const ExtractionResult& result,
+                               const std::map<std::wstring, std::string>& contents) {
+        std::set<std::wstring> listed(result.extractedFiles.begin(), result.extractedFiles.end());
+        EXPECT_EQ(listed.size(), result.extractedFiles.size());
+        for (const auto& name : listed) {
+            EXPECT_TRUE(ReadFile(root + L"/" + name) == contents.at(name)) << name;
+        }
+        for (const auto& item : std::filesystem::directory_iterator(root)) {
+            EXPECT_EQ(listed.count(item.path().filename().wstring()), 1u) << item.path();
+        }
+    }
+
+} // namespace
+
+TEST(Cancellation, LogPrunesFilesNotOnDiskWhole) {
+    ExtractedFileLog log;
+    log.Note(L"kept", FileOutcome::Written);
+    log.Note(L"lost", FileOutcome::Lost);
+    log.Note(L"rewritten", FileOutcome::Lost);
+    log.Note(L"rewritten", FileOutcome::Written);
+    log.Note(L"twice", FileOutcome::Written);
+    log.Note(L"twice", FileOutcome::Dropped);
+    log.Note(L"dropped", FileOutcome::Dropped);
+    log.Note(L"relost", FileOutcome::Written);
+    log.Note(L"relost", FileOutcome::Lost);
+
+    std::vector<std::wstring> names = { L"kept", L"lost", L"twice", L"rewritten", L"relost",
+                                        L"twice", L"relost", L"dropped", L"rewritten" };
+    log.Prune(names);
+    std::vector<std::wstring> expected = { L"kept", L"twice", L"rewritten", L"rewritten" };
+    EXPECT_EQ(names, expected);
+
+    // Nothing is pruned while no file has gone missing
+    ExtractedFileLog clean;
+    clean.Note(L"a", FileOutcome::Written);
+    std::vector<std::wstring> all = { L"a", L"b" };
+    clean.Prune(all);
+    EXPECT_EQ(all.size(), 2u);
+}
+
+TEST(Cancellation, CallbackListsOnlyFilesLeftWhole) {
+    TempDirectory temp;
+    auto contents = WriteArchive(temp / "cancel.tar", 60);
+
+    for (unsigned writers : { 0u, 4u }) {
+        std::wstring root = temp / ("out" + std::to_string(writers));
+        ExtractionOptions options;
+        options.writerThreads = writers;
+        options.writeBufferBudget = 1024 * 1024;
+        ExtractionResult result = TarExtractor().Extract(
+            temp / "cancel.tar", root, options,
+            [](uint64_t, uint64_t, const std::wstring& fileName, const std::wstring&) { return fileName != L"f40"; });
+        EXPECT_FALSE(result.success);
+        EXPECT_TRUE(result.cancelled);
+        EXPECT_EQ(result.errorMessage, L"Extraction cancelled by user");
+        EXPECT_LE(result.extractedFiles.size(), 40u);
+        if (writers == 0) {
+            EXPECT_EQ(result.extractedFiles.size(), 40u);
+        }
+        ExpectOnlyListedFiles(std::filesystem::canonical(root).wstring(), result, contents);
+    }
+}
+
+TEST(Cancellation, TokenStopsEveryWriterAndCanBeReset) {
+    TempDirectory temp;
+    auto contents = WriteArchive(temp / "cancel.tar", 60);
+
+    auto cancellation = std::make_shared<CancellationToken>();
+    for (bool batch : { false, true }) {
+        std::wstring root = temp / (batch ? "batched" : "pooled");
+        ExtractionOptions options;
+        options.writeBufferBudget = 1024 * 1024;
+        options.batchSmallFiles = batch;
+        options.cancellation = cancellation;
+        cancellation->Reset();
+        ExtractionResult result = TarExtractor().Extract(
+            temp / "cancel.tar", root, options,
+            [&](uint64_t, uint64_t, const std::wstring& fileName, const std::wstring&) {
+                if (fileName == L"f40") {
+                    cancellation->Cancel();
+                }
+                return true;
+            });
+        EXPECT_FALSE(result.success);
+        EXPECT_TRUE(result.cancelled);
+        EXPECT_LE(result.extractedFiles.size(), 41u);
+        ExpectOnlyListedFiles(std::filesystem::canonical(root).wstring(), result, contents);
+    }
+
+    // A reset token lets the next extraction run to the end
+    cancellation->Reset();
+    ExtractionOptions options;
+    options.cancellation = cancellation;
+    ExtractionResult result = TarExtractor().Extract(temp / "cancel.tar", temp / "full", options);
+    ASSERT_TRUE(result.success);
+    EXPECT_FALSE(result.cancelled);
+    EXPECT_EQ(result.extractedFiles.size(), 60u);
+    ExpectOnlyListedFiles(std::filesystem::canonical(temp.Path() / "full").wstring(), result, contents);
+}
+
+TEST(Cancellation, CanComeFromAnotherThread) {
+    TempDirectory temp;
+    auto contents = WriteArchive(temp / "cancel.tar", 60);
+
+    ExtractionOptions options;
+    options.writeBufferBudget = 1024 * 1024;
+    options.cancellation = std::make_shared<CancellationToken>();
+    options.progress = std::make_shared<ExtractionProgress>();
+    std::thread canceller([&options] {
+        while (options.progress->Snapshot().entries < 20 &&
+               options.progress->Snapshot().phase != ProgressPhase::Done) {
+            std::this_thread::yield();
+        }
+        options.cancellation->Cancel();
+    });
+    ExtractionResult result = TarExtractor().Extract(temp / "cancel.tar", temp / "out", options);
+    canceller.join();
+
+    // The extraction may have ended before the cancellation landed
+    EXPECT_NE(result.success, result.cancelled);
+    ExpectOnlyListedFiles(std::filesystem::canonical(temp.Path() / "out").wstring(), result, contents);
+}
@@ -0,0 +1,76 @@
+#include "TestArchives.h"
+#include "extraction-engine/DirectoryCache.h"
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+using namespace ArchiveEngine;
+using namespace ArchiveEngine::Testing;
+
+// The cache serves the Windows output tree; it only uses std::filesystem, so it is
+// tested everywhere
+
+TEST(DirectoryCache, CreatesMissingAncestors) {
+    TempDirectory temp;
+    DirectoryCache cache(temp.Path().wstring());
+    ASSERT_TRUE(cache.Create(temp / "a/b/c"));
+    EXPECT_TRUE(std::filesystem::is_directory(temp / "a/b/c"));
+
+    ASSERT_TRUE(cache.CreateParent(temp / "x/y/file.txt"));
+    EXPECT_TRUE(std::filesystem::is_directory(temp / "x/y"));
+    EXPECT_FALSE(std::filesystem::exists(temp / "x/y/file.txt"));
+}
+
+TEST(DirectoryCache, AnswersKnownDirectoriesFromTheCache) {
+    TempDirectory temp;
+    DirectoryCache cache(temp.Path().wstring());
+    ASSERT_TRUE(cache.Create(temp / "a/b"));
+
+    // Once known, a directory is not looked at again, even if it has gone; spellings of
+    // the same path share one entry
+    std::filesystem::remove_all(temp / "a");
+    EXPECT_TRUE(cache.Create(temp / "a/b"));
+    EXPECT_TRUE(cache.Create(temp / "a/b/"));
+    EXPECT_TRUE(cache.Create(temp / "a/./c/../b"));
+    EXPECT_FALSE(std::filesystem::exists(temp / "a"));
+
+    // An unknown sibling is created below the known parent, which is not checked again
+    EXPECT_FALSE(cache.Create(temp / "a/d"));
+}
+
+TEST(DirectoryCache, FailsWhereAFileIsInTheWay) {
+    TempDirectory temp;
+    WriteFile(temp / "file", "data");
+    DirectoryCache cache(temp.Path().wstring());
+    EXPECT_FALSE(cache.Create(temp / "file"));
+    EXPECT_FALSE(cache.Create(temp / "file/below"));
+    EXPECT_FALSE(cache.CreateParent(temp / "file/below/name.txt"));
+    EXPECT_EQ(ReadFile(temp / "file"), "data");
+}
+
+TEST(DirectoryCache, IsSharedBetweenThreads) {
+    TempDirectory temp;
+    DirectoryCache cache(temp.Path().wstring());
+    std::vector<std::thread> threads;
+    std::atomic<int> failures(0);
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < 200; ++i) {
+                std::wstring path = temp / ("shared/" + std::to_string(i % 50) + "/" + std::to_string((i + t) % 3));
+                if (!cache.Create(path)) {
+                    ++failures;
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(failures.load(), 0);
+    for (int i = 0; i < 50; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            EXPECT_TRUE(std::filesystem::is_directory(temp / ("shared/" + std::to_string(i) + "/" + std::to_string(j))));
+        }
+    }
+}
@@ -0,0 +1,95 @@
+#include "TestArchives.h"
+#include "extraction-engine/TarExtractor.h"
+#include "extraction-engine/TarHeaderDecoder.h"
+#include <gtest/gtest.h>
+
+using namespace ArchiveEngine;
+using namespace ArchiveEngine::Testing;
+
+TEST(EndOfArchive, ZeroBlocksAreRecognizedWhereverTheyDiffer) {
+    std::string block(512 + 64, '\0');
+    EXPECT_TRUE(IsZeroBlock(block.data()));
+    EXPECT_TRUE(IsZeroMemory(block.data(), block.size()));
+    EXPECT_TRUE(IsZeroMemory(block.data(), 0));
+
+    // One non-zero byte anywhere, at every alignment within a vector
+    for (size_t i = 0; i < 512; ++i) {
+        block[i] = 1;
+        EXPECT_FALSE(IsZeroBlock(block.data())) << i;
+        EXPECT_FALSE(IsZeroMemory(block.data(), 512)) << i;
+        block[i] = 0;
+    }
+    for (size_t length = 1; length < 100; ++length) {
+        block[length - 1] = static_cast<char>(0x80);
+        EXPECT_FALSE(IsZeroMemory(block.data(), length)) << length;
+        EXPECT_TRUE(IsZeroMemory(block.data(), length - 1)) << length;
+        block[length - 1] = 0;
+    }
+}
+
+TEST(EndOfArchive, NothingPastTwoZeroBlocksIsRead) {
+    TempDirectory temp;
+    TarBuilder tar;
+    tar.AddFile("kept.txt", "kept");
+    TarBuilder after;
+    after.AddFile("ghost.txt", "ghost");
+    // A blocked tape or preallocated file: megabytes of padding, here with an archive in it
+    WriteFile(temp / "padded.tar", tar.Finish() + std::string(4 * 1024 * 1024, '\0') + after.Finish());
+
+    std::vector<ArchiveEntry> entries;
+    ASSERT_TRUE(TarExtractor().GetArchiveInfo(temp / "padded.tar", entries));
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0].name, L"kept.txt");
+
+    ExtractionResult result = TarExtractor().Extract(temp / "padded.tar", temp / "out", ExtractionOptions());
+    ASSERT_TRUE(result.success);
+    EXPECT_EQ(ReadFile(temp / "out/kept.txt"), "kept");
+    EXPECT_FALSE(std::filesystem::exists(temp / "out/ghost.txt"));
+    EXPECT_EQ(result.totalUncompressedSize, 4u);
+}
+
+TEST(EndOfArchive, ALoneZeroBlockDoesNotEndTheArchive) {
+    TempDirectory temp;
+    TarBuilder tar;
+    tar.AddFile("first.txt", "first");
+    tar.AddRaw(std::string(512, '\0'));
+    tar.AddFile("second.txt", "second");
+    WriteFile(temp / "gap.tar", tar.Finish());
+
+    std::vector<ArchiveEntry> entries;
+    ASSERT_TRUE(TarExtractor().GetArchiveInfo(temp / "gap.tar", entries));
+    EXPECT_EQ(entries.size(), 2u);
+    ASSERT_TRUE(TarExtractor().Extract(temp / "gap.tar", temp / "out", ExtractionOptions()).success);
+    EXPECT_EQ(ReadFile(temp / "out/second.txt"), "second");
+}
+
+TEST(EndOfArchive, ABlockWithoutTheMagicIsCorruptNotSkipped) {
+    TempDirectory temp;
+    // The member's payload is itself an archive; skipping its header would parse that instead
+    TarBuilder inner;
+    inner.AddFile("evil.txt", "evil");
+    std::string payload = inner.Finish();
+    TarBuilder tar;
+    tar.AddFile("first.txt", "first");
+    std::string header = TarBuilder::Header("a.bin", payload.size(), '0');
+    header[257] = 'X';  // "Xstar"
+    TarBuilder::SetChecksum(header);
+    tar.AddRaw(header);
+    tar.AddRaw(payload);
+    WriteFile(temp / "magic.tar", tar.Finish());
+
+    std::vector<ArchiveEntry> entries;
+    EXPECT_FALSE(TarExtractor().GetArchiveInfo(temp / "magic.tar", entries));
+    EXPECT_FALSE(TarExtractor().VisitEntries(temp / "magic.tar", ExtractionOptions(),
+                                             [](const ArchiveEntryView&) { return true; }));
+
+    for (unsigned writers : { 0u, 4u }) {
+        ExtractionOptions options;
+        options.writerThreads = writers;
+        std::wstring out = temp / ("out" + std::to_string(writers));
+        ExtractionResult result = TarExtractor().Extract(temp / "magic.tar", out, options);
+        EXPECT_FALSE(result.success);
+        EXPECT_FALSE(std::filesystem::exists(out + L"/evil.txt"));
+        EXPECT_FALSE(std::filesystem::exists(out + L"/a.bin"));
+    }
+}
@@ -0,0 +1,94 @@
+#include "TestArchives.h"
+#include "extraction-engine/EntryTable.h"
+#include "extraction-engine/TarExtractor.h"
+#include <gtest/gtest.h>
+
+using namespace ArchiveEngine;
+using namespace ArchiveEngine::Testing;
+
+namespace {
+
+    ArchiveEntryView MakeEntry(std::string_view name, uint64_t size, bool isDirectory = false) {
+        ArchiveEntryView entry;
+        entry.name = name;
+        entry.size = size;
+        entry.compressedSize = size;
+        entry.isDirectory = isDirectory;
+        entry.lastModified = 1700000000 + size;
+        entry.permissions = isDirectory ? 0755 : 0644;
+        return entry;
+    }
+
+} // namespace
+
+TEST(EntryTable, ReadsTarListingInArchiveOrder) {
+    TempDirectory temp;
+    TarBuilder tar;
+    tar.AddDirectory("dir/");
+    tar.AddFile("dir/a.txt", SampleData(1500, 130), 0600);
+    tar.AddFile("b.txt", "b");
+    WriteFile(temp / "list.tar", tar.Finish());
+
+    EntryTable table;
+    ASSERT_TRUE(table.Read(TarExtractor(), temp / "list.tar"));
+    ASSERT_EQ(table.Count(), 3u);
+    EXPECT_EQ(table.Name(0), "dir/");
+    EXPECT_TRUE(table.IsDirectory(0));
+    EXPECT_EQ(table.Name(1), "dir/a.txt");
+    EXPECT_EQ(table.FileSize(1), 1500u);
+    EXPECT_EQ(table.Permissions(1), 0600u);
+    EXPECT_FALSE(table.IsDirectory(1));
+    EXPECT_EQ(table.LastModified(2), 1700000000u);
+    EXPECT_EQ(table.FileSizes(), (std::vector<uint64_t>{ 0, 1500, 1 }));
+
+    // Reading again replaces the contents; a missing archive leaves the table empty
+    EXPECT_FALSE(table.Read(TarExtractor(), temp / "missing.tar"));
+    EXPECT_EQ(table.Count(), 0u);
+}
+
+TEST(EntryTable, KeepsNamesAndLinkTargetsInTheArena) {
+    EntryTable table;
+    table.Reserve(2, 32);
+    ArchiveEntryView link = MakeEntry("link", 0);
+    link.linkTarget = "target/file";
+    table.Add(link);
+    table.Add(MakeEntry("plain", 7));
+
+    EXPECT_EQ(table.Name(0), "link");
+    EXPECT_EQ(table.LinkTarget(0), "target/file");
+    EXPECT_EQ(table.Name(1), "plain");
+    EXPECT_TRUE(table.LinkTarget(1).empty());
+
+    ArchiveEntryView view = table.View(1);
+    EXPECT_EQ(view.name, "plain");
+    EXPECT_EQ(view.size, 7u);
+    EXPECT_EQ(view.lastModified, 1700000007u);
+}
+
+TEST(EntryTable, FindsLastCopyAndPrefixRanges) {
+    EntryTable table;
+    table.Add(MakeEntry("src/b.cpp", 1));
+    table.Add(MakeEntry("src/", 0, true));
+    table.Add(MakeEntry("docs/readme", 2));
+    table.Add(MakeEntry("src/a.cpp", 3));
+    table.Add(MakeEntry("src/b.cpp", 4));
+
+    EXPECT_EQ(table.Find("src/b.cpp"), 4u);
+    EXPECT_EQ(table.Find("docs/readme"), 2u);
+    EXPECT_EQ(table.Find("src"), EntryTable::NotFound);
+    EXPECT_EQ(table.Find("zzz"), EntryTable::NotFound);
+
+    auto range = table.PrefixRange("src/");
+    ASSERT_EQ(range.second - range.first, 4u);
+    EXPECT_EQ(table.SortedEntry(range.first), 1u);      // "src/"
+    EXPECT_EQ(table.SortedEntry(range.first + 1), 3u);  // "src/a.cpp"
+    EXPECT_EQ(table.SortedEntry(range.first + 2), 0u);  // First "src/b.cpp"
+    EXPECT_EQ(table.SortedEntry(range.first + 3), 4u);
+
+    range = table.PrefixRange("none/");
+    EXPECT_EQ(range.first, range.second);
+
+    // Entries added later are found too
+    table.Add(MakeEntry("new", 5));
+    EXPECT_EQ(table.Find("new"), 5u);
+}
@@ -0,0 +1,93 @@
+#include "TestArchives.h"
+#include "extraction-engine/GzipExtractor.h"
+#include "extraction-engine/TarExtractor.h"
+#include <cstring>
+#include <gtest/gtest.h>
+
+using namespace ArchiveEngine;
+using namespace ArchiveEngine::Testing;
+
+namespace {
+
+    // Archive with a directory, a file whose path is split into prefix and name, and a link
+    std::string LinkArchive(const std::string& longDirectory) {
+        TarBuilder tar;
+        tar.AddDirectory("top/", 0750);
+        std::string header = TarBuilder::Header("file.txt", 5, '0', 0604, 1600000000);
+        std::memcpy(&header[345], longDirectory.data(), longDirectory.size());
+        TarBuilder::SetChecksum(header);
+        tar.AddRaw(header);
+        tar.AddRaw(std::string("hello") + std::string(507, '\0'));
+        std::string link = TarBuilder::Header("top/link", 0, '2');
+        std::memcpy(&link[157], "file.txt", 8);
+        TarBuilder::SetChecksum(link);
+        tar.AddRaw(link);
+        return tar.Finish();
+    }
+
+} // namespace
+
+TEST(EntryVisitor, StreamsViewsInArchiveOrder) {
+    TempDirectory temp;
+    std::string longDirectory = "top/" + std::string(120, 'd');
+    WriteFile(temp / "visit.tar", LinkArchive(longDirectory));
+
+    std::vector<std::string> names;
+    std::vector<std::string> links;
+    std::vector<uint64_t> sizes;
+    ASSERT_TRUE(TarExtractor().VisitEntries(temp / "visit.tar", ExtractionOptions(), [&](const ArchiveEntryView& entry) {
+        names.emplace_back(entry.name);
+        links.emplace_back(entry.linkTarget);
+        sizes.push_back(entry.size);
+        if (entry.name == "top/") {
+            EXPECT_TRUE(entry.isDirectory);
+            EXPECT_EQ(entry.permissions, 0750u);
+        }
+        return true;
+    }));
+    std::vector<std::string> expected = { "top/", longDirectory + "/file.txt", "top/link" };
+    EXPECT_EQ(names, expected);
+    EXPECT_EQ(links[2], "file.txt");
+    EXPECT_EQ(sizes[1], 5u);
+
+    // The vector listing is built on the visitor and agrees with it
+    std::vector<ArchiveEntry> entries;
+    ASSERT_TRUE(TarExtractor().GetArchiveInfo(temp / "visit.tar", entries));
+    ASSERT_EQ(entries.size(), 3u);
+    EXPECT_EQ(entries[1].name, std::wstring(expected[1].begin(), expected[1].end()));
+    EXPECT_EQ(entries[1].lastModified, 1600000000u);
+    EXPECT_EQ(entries[1].permissions, 0604u);
+    EXPECT_EQ(entries[2].linkTarget, L"file.txt");
+}
+
+TEST(EntryVisitor, StopsWhenTheVisitorSaysSo) {
+    TempDirectory temp;
+    TarBuilder tar;
+    for (int i = 0; i < 10; ++i) {
+        tar.AddFile("f" + std::to_string(i), "x");
+    }
+    // Whatever follows the entries the visitor saw is never read
+    std::string archive = tar.Finish();
+    WriteFile(temp / "stop.tar", archive.substr(0, 3 * 1024) + std::string(512, 'x'));
+
+    size_t visited = 0;
+    EXPECT_TRUE(TarExtractor().VisitEntries(temp / "stop.tar", ExtractionOptions(), [&](const ArchiveEntryView&) {
+        return ++visited < 2;
+    }));
+    EXPECT_EQ(visited, 2u);
+}
+
+TEST(EntryVisitor, VisitsTheSingleEntryOfAGzipFile) {
+    TempDirectory temp;
+    std::string data = SampleData(12345, 54);
+    WriteFile(temp / "notes.txt.gz", GzipCompress(data));
+
+    size_t visited = 0;
+    ASSERT_TRUE(GzipExtractor().VisitEntries(temp / "notes.txt.gz", ExtractionOptions(), [&](const ArchiveEntryView& entry) {
+        EXPECT_EQ(entry.name, "notes.txt");
+        EXPECT_FALSE(entry.isDirectory);
+        ++visited;
+        return true;
+    }));
+    EXPECT_EQ(visited, 1u);
+}
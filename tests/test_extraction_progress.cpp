@@ -0,0 +1,111 @@
+#include "TestArchives.h"
+#include "extraction-engine/ExtractionProgress.h"
+#include "extraction-engine/TarExtractor.h"
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace ArchiveEngine;
+using namespace ArchiveEngine::Testing;
+
+TEST(ExtractionProgress, DeliversSnapshotsAtABoundedRate) {
+    ExtractionProgress progress;
+    std::vector<ProgressSnapshot> delivered;
+    progress.Subscribe([&delivered](const ProgressSnapshot& snapshot) { delivered.push_back(snapshot); },
+                       std::chrono::hours(1));
+    progress.SetTotal(100);
+    progress.SetPhase(ProgressPhase::Extracting);
+    for (uint64_t i = 1; i <= 50; ++i) {
+        progress.SetCurrent(i * 2);
+        progress.AddEntry();
+        progress.Publish();
+    }
+
+    // The first call is due, the rest fall within the interval
+    ASSERT_EQ(delivered.size(), 1u);
+    EXPECT_EQ(delivered[0].current, 2u);
+    EXPECT_EQ(delivered[0].total, 100u);
+    EXPECT_EQ(delivered[0].entries, 1u);
+    EXPECT_EQ(delivered[0].phase, ProgressPhase::Extracting);
+
+    progress.Finish();
+    ASSERT_EQ(delivered.size(), 2u);
+    EXPECT_EQ(delivered[1].current, 100u);
+    EXPECT_EQ(delivered[1].entries, 50u);
+    EXPECT_EQ(delivered[1].phase, ProgressPhase::Done);
+
+    progress.Unsubscribe();
+    progress.Reset();
+    progress.Publish();
+    progress.Finish();
+    EXPECT_EQ(delivered.size(), 2u);
+    EXPECT_EQ(progress.Snapshot().entries, 0u);
+    EXPECT_EQ(progress.Snapshot().phase, ProgressPhase::Done);
+}
+
+TEST(ExtractionProgress, ThrottleIsDueOncePerInterval) {
+    ProgressThrottle always(std::chrono::milliseconds(0));
+    EXPECT_TRUE(always.Due());
+    EXPECT_TRUE(always.Due());
+
+    ProgressThrottle throttle(std::chrono::milliseconds(50));
+    EXPECT_TRUE(throttle.Due());
+    EXPECT_FALSE(throttle.Due());
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    EXPECT_TRUE(throttle.Due());
+}
+
+TEST(ExtractionProgress, IsReportedForTarExtractions) {
+    TempDirectory temp;
+    TarBuilder tar;
+    tar.AddDirectory("d/");
+    for (uint32_t i = 0; i < 40; ++i) {
+        tar.AddFile("d/f" + std::to_string(i), SampleData(1000 + i, 193 + i));
+    }
+    WriteFile(temp / "progress.tar", tar.Finish());
+
+    ExtractionOptions options;
+    options.progress = std::make_shared<ExtractionProgress>();
+    std::vector<ProgressSnapshot> delivered;
+    options.progress->Subscribe([&delivered](const ProgressSnapshot& snapshot) { delivered.push_back(snapshot); },
+                                std::chrono::milliseconds(0));
+
+    ExtractionResult result = TarExtractor().Extract(temp / "progress.tar", temp / "out", options);
+    ASSERT_TRUE(result.success);
+    ProgressSnapshot last = options.progress->Snapshot();
+    EXPECT_EQ(last.phase, ProgressPhase::Done);
+    EXPECT_EQ(last.entries, 41u);
+    EXPECT_EQ(last.current, last.total);
+    EXPECT_EQ(last.total, result.totalUncompressedSize);
+
+    // Every entry publishes with a zero interval, and Finish adds the last snapshot
+    ASSERT_EQ(delivered.size(), 42u);
+    EXPECT_EQ(delivered.front().entries, 1u);
+    EXPECT_EQ(delivered.back().phase, ProgressPhase::Done);
+    for (size_t i = 1; i < delivered.size(); ++i) {
+        EXPECT_GE(delivered[i].current, delivered[i - 1].current);
+    }
+}
+
+TEST(ExtractionProgress, IntervalThrottlesTheCallback) {
+    TempDirectory temp;
+    TarBuilder tar;
+    for (uint32_t i = 0; i < 200; ++i) {
+        tar.AddFile("f" + std::to_string(i), "x");
+    }
+    WriteFile(temp / "many.tar", tar.Finish());
+
+    ExtractionOptions options;
+    options.progressInterval = 60 * 60 * 1000;
+    size_t extracting = 0;
+    size_t complete = 0;
+    ExtractionResult result = TarExtractor().Extract(
+        temp / "many.tar", temp / "out", options,
+        [&](uint64_t, uint64_t, const std::wstring&, const std::wstring& status) {
+            (status == L"Complete" ? complete : extracting)++;
+            return true;
+        });
+    ASSERT_TRUE(result.success);
+    EXPECT_EQ(result.extractedFiles.size(), 200u);
+    EXPECT_EQ(extracting, 1u);
+    EXPECT_EQ(complete, 1u);
+}
@@ -0,0 +1,94 @@
+#include "TestArchives.h"
+#include "extraction-engine/ExtractionStats.h"
+#include "extraction-engine/TarExtractor.h"
+#include <gtest/gtest.h>
+
+using namespace ArchiveEngine;
+using namespace ArchiveEngine::Testing;
+
+TEST(ExtractionStats, ReportsLatencyPercentiles) {
+    ExtractionStatsRecorder recorder;
+    for (uint64_t i = 1; i <= 1000; ++i) {
+        recorder.AddFileLatency(i * 1000);
+    }
+    recorder.Add(ExtractionPhase::WriteData, 500, 4096, 3);
+    recorder.Add(ExtractionPhase::WriteData, 700, 1024, 1);
+
+    ExtractionStats stats;
+    recorder.Fill(stats);
+    EXPECT_EQ(stats.fileLatency.files, 1000u);
+    EXPECT_EQ(stats.fileLatency.minNanoseconds, 1000u);
+    EXPECT_EQ(stats.fileLatency.maxNanoseconds, 1000000u);
+
+    // Percentiles are bucket upper ends, no more than 1/8 above the true value
+    auto near = [](uint64_t value, uint64_t expected) { return value >= expected && value <= expected + expected / 8; };
+    EXPECT_TRUE(near(stats.fileLatency.p50Nanoseconds, 500000)) << stats.fileLatency.p50Nanoseconds;
+    EXPECT_TRUE(near(stats.fileLatency.p90Nanoseconds, 900000)) << stats.fileLatency.p90Nanoseconds;
+    EXPECT_TRUE(near(stats.fileLatency.p99Nanoseconds, 990000)) << stats.fileLatency.p99Nanoseconds;
+
+    const PhaseStats& write = stats.Phase(ExtractionPhase::WriteData);
+    EXPECT_EQ(write.count, 2u);
+    EXPECT_EQ(write.nanoseconds, 1200u);
+    EXPECT_EQ(write.bytes, 5120u);
+    EXPECT_EQ(write.systemCalls, 4u);
+    EXPECT_EQ(stats.Phase(ExtractionPhase::OpenFile).count, 0u);
+    EXPECT_STREQ(ExtractionStats::PhaseName(ExtractionPhase::ValidatePath), "validate-path");
+    EXPECT_STREQ(ExtractionStats::PhaseName(ExtractionPhase::MakeDirectory), "create-directory");
+}
+
+TEST(ExtractionStats, ScopeCountsSystemCallsOfItsThread) {
+    ExtractionStatsRecorder recorder;
+    {
+        ExtractionStatsRecorder::Scope scope(&recorder, ExtractionPhase::CloseFile, 10);
+        CountSystemCalls(5);
+        scope.AddBytes(6);
+    }
+    {
+        // Without a recorder nothing is kept
+        ExtractionStatsRecorder::Scope scope(nullptr, ExtractionPhase::CloseFile);
+        CountSystemCalls();
+    }
+    ExtractionStats stats;
+    recorder.Fill(stats);
+    EXPECT_EQ(stats.Phase(ExtractionPhase::CloseFile).count, 1u);
+    EXPECT_EQ(stats.Phase(ExtractionPhase::CloseFile).bytes, 16u);
+    EXPECT_EQ(stats.Phase(ExtractionPhase::CloseFile).systemCalls, 5u);
+    EXPECT_EQ(stats.fileLatency.files, 0u);
+}
+
+TEST(ExtractionStats, AreCollectedForTarExtractions) {
+    TempDirectory temp;
+    TarBuilder tar;
+    tar.AddDirectory("d/");
+    tar.AddDirectory("d/e/");
+    tar.AddFile("d/a.txt", SampleData(3000, 190));
+    tar.AddFile("d/e/b.txt", SampleData(5000, 191));
+    tar.AddFile("c.txt", "c");
+    WriteFile(temp / "stats.tar", tar.Finish());
+
+    for (unsigned writers : { 0u, 4u }) {
+        ExtractionOptions options;
+        options.writerThreads = writers;
+        options.collectStats = true;
+        ExtractionResult result = TarExtractor().Extract(temp / "stats.tar", temp / ("out" + std::to_string(writers)),
+                                                         options);
+        ASSERT_TRUE(result.success);
+        ASSERT_TRUE(result.stats);
+        const ExtractionStats& stats = *result.stats;
+        EXPECT_GE(stats.Phase(ExtractionPhase::ReadHeader).count, 5u);
+        EXPECT_EQ(stats.Phase(ExtractionPhase::ValidatePath).count, 5u);
+        EXPECT_EQ(stats.Phase(ExtractionPhase::MakeDirectory).count, 2u);
+        EXPECT_EQ(stats.Phase(ExtractionPhase::OpenFile).count, 3u);
+        EXPECT_EQ(stats.Phase(ExtractionPhase::CloseFile).count, 3u);
+        EXPECT_EQ(stats.Phase(ExtractionPhase::WriteData).bytes, 8001u);
+        EXPECT_EQ(stats.Phase(ExtractionPhase::QueueData).count, writers > 0 ? 3u : 0u);
+        EXPECT_EQ(stats.fileLatency.files, 3u);
+#ifndef _WIN32
+        EXPECT_GT(stats.Phase(ExtractionPhase::OpenFile).systemCalls, 0u);
+#endif
+    }
+
+    ExtractionResult plain = TarExtractor().Extract(temp / "stats.tar", temp / "plain", ExtractionOptions());
+    ASSERT_TRUE(plain.success);
+    EXPECT_FALSE(plain.stats);
+}
@@ -0,0 +1,114 @@
+#include "TestArchives.h"
+#include "extraction-engine/FileWriterPool.h"
+#include <gtest/gtest.h>
+
+using namespace ArchiveEngine;
+using namespace ArchiveEngine::Testing;
+
+namespace {
+
+    std::wstring CanonicalRoot(const TempDirectory& temp) {
+        return std::filesystem::canonical(temp.Path()).wstring();
+    }
+
+    // Queues `data` as one file in pieces of `piece` bytes
+    void QueueFile(FileWriterPool& pool, const std::wstring& path, const std::string& data,
+                   size_t piece = 1024 * 1024) {
+        pool.BeginFile(path, path, OutputFileAttributes());
+        for (size_t offset = 0; offset < data.size(); offset += piece) {
+            size_t length = std::min(piece, data.size() - offset);
+            pool.Write(offset, data.data() + offset, length);
+        }
+        pool.EndFile(data.size());
+    }
+
+} // namespace
+
+TEST(FileWriterPool, WritesFilesInParallel) {
+    TempDirectory temp;
+    std::wstring root = CanonicalRoot(temp);
+    OutputTree output(root);
+    std::vector<std::string> contents;
+    {
+        FileWriterPool pool(4, 4 * 1024 * 1024, output);
+        for (uint32_t i = 0; i < 20; ++i) {
+            contents.push_back(SampleData(1000 + i * 50000, 100 + i));
+            QueueFile(pool, root + L"/d" + std::to_wstring(i % 3) + L"/f" + std::to_wstring(i), contents.back(), 64 * 1024);
+        }
+        std::wstring failedName;
+        ASSERT_TRUE(pool.Finish(failedName));
+        EXPECT_TRUE(failedName.empty());
+    }
+    for (uint32_t i = 0; i < 20; ++i) {
+        EXPECT_EQ(ReadFile(root + L"/d" + std::to_wstring(i % 3) + L"/f" + std::to_wstring(i)), contents[i]) << i;
+    }
+}
+
+TEST(FileWriterPool, LaterCopyOfPathWins) {
+    TempDirectory temp;
+    std::wstring root = CanonicalRoot(temp);
+    OutputTree output(root);
+    std::string large = SampleData(24 * 1024 * 1024, 120, false);
+
+    // The budget holds the reader back while the large copy is written, so the small
+    // one reaches an idle writer before the large one is closed
+    for (int round = 0; round < 3; ++round) {
+        FileWriterPool pool(4, 2 * 1024 * 1024, output);
+        std::wstring path = root + L"/dup" + std::to_wstring(round);
+        QueueFile(pool, path, large);
+        QueueFile(pool, path, "small");
+        std::wstring failedName;
+        ASSERT_TRUE(pool.Finish(failedName));
+        EXPECT_TRUE(ReadFile(path) == "small") << round;
+    }
+}
+
+TEST(FileWriterPool, ReportsFilesThatCannotBeWritten) {
+    TempDirectory temp;
+    std::wstring root = CanonicalRoot(temp);
+    WriteFile(root + L"/blocker", "not a directory");
+    OutputTree output(root);
+    FileWriterPool pool(2, 1024 * 1024, output);
+    QueueFile(pool, root + L"/ok.txt", "ok");
+    QueueFile(pool, root + L"/blocker/file.txt", "lost");
+    std::wstring failedName;
+    EXPECT_FALSE(pool.Finish(failedName));
+    EXPECT_EQ(failedName, root + L"/blocker/file.txt");
+    EXPECT_TRUE(pool.Failed());
+    EXPECT_EQ(ReadFile(root + L"/ok.txt"), "ok");
+}
+
+TEST(FileWriterPool, RemovesFilesCutShortByCancellation) {
+    TempDirectory temp;
+    std::wstring root = CanonicalRoot(temp);
+    CancellationToken cancellation;
+    OutputTree output(root, nullptr, nullptr, &cancellation);
+    FileWriterPool pool(2, 1024 * 1024, output);
+    QueueFile(pool, root + L"/done.txt", "done");
+    std::wstring failedName;
+    ASSERT_TRUE(pool.Finish(failedName));
+
+    std::string data = SampleData(256 * 1024, 121);
+    pool.BeginFile(root + L"/partial.bin", L"partial.bin", OutputFileAttributes());
+    pool.Write(0, data.data(), data.size());
+    cancellation.Cancel();
+    pool.EndFile(2 * data.size());
+    EXPECT_FALSE(pool.Finish(failedName));
+
+    EXPECT_EQ(ReadFile(root + L"/done.txt"), "done");
+    EXPECT_FALSE(std::filesystem::exists(root + L"/partial.bin"));
+}
+
+TEST(FileWriterPool, RemovesUnfinishedFilesWhenDestroyed) {
+    TempDirectory temp;
+    std::wstring root = CanonicalRoot(temp);
+    OutputTree output(root);
+    {
+        FileWriterPool pool(1, 1024 * 1024, output);
+        std::string data = SampleData(100000, 122);
+        pool.BeginFile(root + L"/open.bin", L"open.bin", OutputFileAttributes());
+        pool.Write(0, data.data(), data.size());
+        // Destroyed without EndFile, as when the reader gives up on the archive
+    }
+    EXPECT_FALSE(std::filesystem::exists(root + L"/open.bin"));
+}
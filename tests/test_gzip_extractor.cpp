@@ -0,0 +1,122 @@
+#include "TestArchives.h"
+#include "extraction-engine/GzipExtractor.h"
+#include "extraction-engine/ParallelGzip.h"
+#include <gtest/gtest.h>
+
+using namespace ArchiveEngine;
+using namespace ArchiveEngine::Testing;
+
+namespace {
+
+    // Small chunks make the parallel decoder split test-sized inputs
+    constexpr size_t TestChunkSize = 64 * 1024;
+
+    std::string DecodeSequential(const std::wstring& path) {
+        GzipArchiveSource source;
+        EXPECT_TRUE(source.Open(path));
+        return ReadAll(source);
+    }
+
+    std::string DecodeParallel(const std::wstring& path, unsigned threads) {
+        ParallelGzipArchiveSource source(threads, TestChunkSize);
+        EXPECT_TRUE(source.Open(path));
+        return ReadAll(source);
+    }
+
+    ExtractionResult ExtractGzip(const std::wstring& archive, const std::wstring& destination) {
+        GzipExtractor extractor;
+        return extractor.Extract(archive, destination, ExtractionOptions());
+    }
+
+} // namespace
+
+TEST(GzipExtractor, DecodesZlibOutputAtEveryLevel) {
+    TempDirectory temp;
+    std::string text = SampleData(300 * 1024, 1);
+    std::string binary = SampleData(200 * 1024, 2, false);
+    for (int level : { 0, 1, 6, 9 }) {
+        WriteFile(temp / "text.gz", GzipCompress(text, level));
+        WriteFile(temp / "binary.gz", GzipCompress(binary, level));
+        EXPECT_EQ(DecodeSequential(temp / "text.gz"), text) << "level " << level;
+        EXPECT_EQ(DecodeSequential(temp / "binary.gz"), binary) << "level " << level;
+    }
+}
+
+TEST(GzipExtractor, DecodesEmptyInput) {
+    TempDirectory temp;
+    WriteFile(temp / "empty.gz", GzipCompress(std::string()));
+    EXPECT_EQ(DecodeSequential(temp / "empty.gz"), std::string());
+}
+
+TEST(GzipExtractor, ReadsInSmallPieces) {
+    TempDirectory temp;
+    std::string data = SampleData(100 * 1024, 3);
+    WriteFile(temp / "data.gz", GzipCompress(data));
+    GzipArchiveSource source;
+    ASSERT_TRUE(source.Open(temp / "data.gz"));
+    EXPECT_EQ(ReadAll(source, 7), data);
+}
+
+TEST(GzipExtractor, ParallelDecoderMatchesSequential) {
+    TempDirectory temp;
+    std::string data = SampleData(2 * 1024 * 1024, 4) + SampleData(512 * 1024, 5, false);
+    WriteFile(temp / "data.gz", GzipCompress(data, 6));
+    for (unsigned threads : { 2u, 4u }) {
+        EXPECT_EQ(DecodeParallel(temp / "data.gz", threads), data) << threads << " threads";
+    }
+}
+
+TEST(GzipExtractor, DecodesConcatenatedMembers) {
+    TempDirectory temp;
+    std::string first = SampleData(400 * 1024, 6);
+    std::string second = SampleData(50 * 1024, 7, false);
+    std::string third = SampleData(300 * 1024, 8);
+    WriteFile(temp / "multi.gz", GzipCompress(first, 1) + GzipCompress(second, 9) + GzipCompress(third));
+    EXPECT_EQ(DecodeSequential(temp / "multi.gz"), first + second + third);
+    EXPECT_EQ(DecodeParallel(temp / "multi.gz", 4), first + second + third);
+}
+
+TEST(GzipExtractor, ExtractsUnderTheArchiveNameWithoutExtension) {
+    TempDirectory temp;
+    std::string data = SampleData(64 * 1024, 9);
+    WriteFile(temp / "notes.txt.gz", GzipCompress(data));
+    ExtractionResult result = ExtractGzip(temp / "notes.txt.gz", temp / "out");
+    ASSERT_TRUE(result.success);
+    EXPECT_EQ(result.bytesProcessed, data.size());
+    EXPECT_EQ(ReadFile(temp / "out/notes.txt"), data);
+}
+
+TEST(GzipExtractor, RejectsCorruptData) {
+    TempDirectory temp;
+    std::string data = SampleData(256 * 1024, 10);
+    std::string compressed = GzipCompress(data);
+
+    // A flipped bit inside the DEFLATE stream, then one in the CRC-32 of the trailer
+    std::string damaged = compressed;
+    damaged[damaged.size() / 2] ^= 0x10;
+    WriteFile(temp / "body.gz", damaged);
+    EXPECT_FALSE(ExtractGzip(temp / "body.gz", temp / "out").success);
+
+    damaged = compressed;
+    damaged[damaged.size() - 8] ^= 0x01;
+    WriteFile(temp / "crc.gz", damaged);
+    EXPECT_FALSE(ExtractGzip(temp / "crc.gz", temp / "out").success);
+}
+
+TEST(GzipExtractor, RejectsTruncatedData) {
+    TempDirectory temp;
+    std::string compressed = GzipCompress(SampleData(256 * 1024, 11));
+    for (size_t cut : { size_t(4), size_t(100), compressed.size() / 2 }) {
+        WriteFile(temp / "cut.gz", compressed.substr(0, compressed.size() - cut));
+        EXPECT_FALSE(ExtractGzip(temp / "cut.gz", temp / "out").success) << cut << " bytes cut";
+    }
+}
+
+TEST(GzipExtractor, RejectsTruncatedDataInParallel) {
+    TempDirectory temp;
+    std::string compressed = GzipCompress(SampleData(1024 * 1024, 12, false));
+    WriteFile(temp / "cut.gz", compressed.substr(0, compressed.size() - 1000));
+    ParallelGzipArchiveSource source(4, TestChunkSize);
+    ASSERT_TRUE(source.Open(temp / "cut.gz"));
+    EXPECT_THROW(ReadAll(source), ExtractionException);
+}
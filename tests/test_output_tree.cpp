@@ -0,0 +1,209 @@
+#include "TestArchives.h"
+#include "extraction-engine/OutputTree.h"
+#include <gtest/gtest.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace ArchiveEngine;
+using namespace ArchiveEngine::Testing;
+
+namespace {
+
+    std::wstring CanonicalRoot(const TempDirectory& temp) {
+        return std::filesystem::canonical(temp.Path()).wstring();
+    }
+
+    bool WriteOutput(OutputTree& output, const std::wstring& path, const std::string& data,
+                     const OutputFileAttributes& attributes = OutputFileAttributes()) {
+        OutputFile file;
+        return output.OpenFile(path, attributes, file) && file.Write(0, data.data(), data.size()) &&
+               file.Close(data.size());
+    }
+
+#ifndef _WIN32
+    size_t OpenDescriptors() {
+        size_t count = 0;
+        for (auto it = std::filesystem::directory_iterator("/proc/self/fd"); it != std::filesystem::directory_iterator(); ++it) {
+            ++count;
+        }
+        return count;
+    }
+#endif
+
+} // namespace
+
+TEST(OutputTree, CreatesFilesWithMissingParents) {
+    TempDirectory temp;
+    std::wstring root = CanonicalRoot(temp);
+    OutputTree output(root);
+    ASSERT_TRUE(output.MakeDirectory(root + L"/empty/dir"));
+    EXPECT_TRUE(std::filesystem::is_directory(root + L"/empty/dir"));
+
+    // Gaps between writes and up to the final size read back as zeros
+    OutputFileAttributes attributes;
+    attributes.permissions = 0640;
+    attributes.mtime = 1600000000;
+    OutputFile file;
+    ASSERT_TRUE(output.OpenFile(root + L"/a/b/c.bin", attributes, file));
+    EXPECT_TRUE(file.IsOpen());
+    ASSERT_TRUE(file.Write(0, "head", 4));
+    ASSERT_TRUE(file.Write(10, "tail", 4));
+    ASSERT_TRUE(file.Close(20));
+    EXPECT_FALSE(file.IsOpen());
+    EXPECT_EQ(ReadFile(root + L"/a/b/c.bin"), std::string("head\0\0\0\0\0\0tail\0\0\0\0\0\0", 20));
+
+#ifndef _WIN32
+    struct stat st;
+    ASSERT_EQ(::stat(std::filesystem::path(root + L"/a/b/c.bin").c_str(), &st), 0);
+    EXPECT_EQ(st.st_mode & 0777, output.FileMode(0640));
+    EXPECT_EQ(st.st_mtime, 1600000000);
+#endif
+}
+
+TEST(OutputTree, ReplacesAndRemovesFiles) {
+    TempDirectory temp;
+    std::wstring root = CanonicalRoot(temp);
+    OutputTree output(root);
+    ASSERT_TRUE(WriteOutput(output, root + L"/f.txt", "a longer first version"));
+    ASSERT_TRUE(WriteOutput(output, root + L"/f.txt", "short"));
+    EXPECT_EQ(ReadFile(root + L"/f.txt"), "short");
+
+    OutputFile file;
+    ASSERT_TRUE(output.OpenFile(root + L"/d/partial.txt", OutputFileAttributes(), file));
+    ASSERT_TRUE(file.Write(0, "part", 4));
+    output.RemoveFile(root + L"/d/partial.txt", file);
+    EXPECT_FALSE(file.IsOpen());
+    EXPECT_FALSE(std::filesystem::exists(root + L"/d/partial.txt"));
+    EXPECT_TRUE(std::filesystem::is_directory(root + L"/d"));
+}
+
+TEST(OutputTree, DirectWritesMatchBufferedOnes) {
+    TempDirectory temp;
+    std::wstring root = CanonicalRoot(temp);
+    OutputTree output(root);
+    std::string data = SampleData(9 * 1024 * 1024 + 123, 140, false);
+
+    // Preallocated and written with O_DIRECT where supported, in pieces that are not
+    // multiples of the alignment, then a write out of order that ends direct writing
+    OutputFileAttributes attributes;
+    attributes.direct = true;
+    attributes.preallocate = data.size();
+    OutputFile file;
+    ASSERT_TRUE(output.OpenFile(root + L"/direct.bin", attributes, file));
+    const size_t piece = 1000 * 1000 + 7;
+    for (size_t offset = 0; offset + piece < data.size(); offset += piece) {
+        ASSERT_TRUE(file.Write(offset, data.data() + offset, piece));
+    }
+    size_t tail = data.size() / piece * piece;
+    ASSERT_TRUE(file.Write(tail, data.data() + tail, data.size() - tail));
+    ASSERT_TRUE(file.Write(5, data.data() + 5, 10));
+    ASSERT_TRUE(file.Close(data.size()));
+    EXPECT_TRUE(ReadFile(root + L"/direct.bin") == data);
+}
+
+#ifndef _WIN32
+TEST(OutputTree, DoesNotFollowSymbolicLinks) {
+    TempDirectory temp;
+    std::filesystem::create_directories(temp.Path() / "dest");
+    std::filesystem::create_directories(temp.Path() / "outside");
+    WriteFile(temp / "outside/target.txt", "untouched");
+    std::wstring root = std::filesystem::canonical(temp.Path() / "dest").wstring();
+    std::filesystem::create_directory_symlink(temp.Path() / "outside", temp.Path() / "dest/linkdir");
+    std::filesystem::create_symlink(temp.Path() / "outside/target.txt", temp.Path() / "dest/linkfile");
+
+    OutputTree output(root);
+    EXPECT_FALSE(output.MakeDirectory(root + L"/linkdir"));
+    EXPECT_FALSE(WriteOutput(output, root + L"/linkdir/new.txt", "escaped"));
+    EXPECT_FALSE(WriteOutput(output, root + L"/linkfile", "escaped"));
+    EXPECT_FALSE(std::filesystem::exists(temp / "outside/new.txt"));
+    EXPECT_EQ(ReadFile(temp / "outside/target.txt"), "untouched");
+}
+
+TEST(OutputTree, KeepsRecentlyUsedDirectoriesOpen) {
+    TempDirectory temp;
+    std::wstring root = CanonicalRoot(temp);
+    size_t before = OpenDescriptors();
+    {
+        OutputTree output(root);
+        ASSERT_TRUE(output.MakeDirectory(root + L"/hot"));
+        std::string name;
+        OutputTree::DirectoryPtr held = output.OpenParent(root + L"/held/file", name);
+        ASSERT_TRUE(held);
+        EXPECT_EQ(name, "file");
+
+        // A directory used between every other one stays cached: using it again makes
+        // no system call, while far more directories than are kept open pass through
+        for (int i = 0; i < 600; ++i) {
+            ASSERT_TRUE(output.MakeDirectory(root + L"/cold/" + std::to_wstring(i)));
+            uint64_t calls = ThreadSystemCalls();
+            ASSERT_TRUE(output.MakeDirectory(root + L"/hot"));
+            ASSERT_EQ(ThreadSystemCalls(), calls) << i;
+        }
+        EXPECT_LT(OpenDescriptors(), before + 300);
+
+        // A handle dropped from the cache stays valid while it is in use
+        struct stat st;
+        EXPECT_EQ(::fstat(held->fd, &st), 0);
+        EXPECT_TRUE(S_ISDIR(st.st_mode));
+        ASSERT_TRUE(WriteOutput(output, root + L"/held/file", "ok"));
+        EXPECT_EQ(ReadFile(root + L"/held/file"), "ok");
+    }
+    EXPECT_EQ(OpenDescriptors(), before);
+}
+
+TEST(OutputTree, MakesEachDirectoryOnce) {
+    TempDirectory temp;
+    std::wstring root = CanonicalRoot(temp);
+    OutputTree output(root);
+
+    // Files spread round robin over more directories than stay open, as in an archive
+    // not grouped by directory: a new directory costs a mkdir and an open, and one
+    // dropped from the cache only an open
+    const int directories = 600;
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < directories; ++i) {
+            std::string name;
+            uint64_t calls = ThreadSystemCalls();
+            ASSERT_TRUE(output.OpenParent(root + L"/d" + std::to_wstring(i) + L"/f" + std::to_wstring(round), name));
+            ASSERT_EQ(ThreadSystemCalls() - calls, round == 0 ? 2u : 1u) << round << " " << i;
+        }
+    }
+
+    // Directories already on disk are found once, then only reopened
+    std::filesystem::create_directories(temp / "existing");
+    for (int i = 0; i < 2; ++i) {
+        uint64_t calls = ThreadSystemCalls();
+        ASSERT_TRUE(output.MakeDirectory(root + L"/existing"));
+        EXPECT_EQ(ThreadSystemCalls() - calls, i == 0 ? 2u : 0u);
+    }
+}
+
+TEST(OutputTree, CopiesRangesBetweenFiles) {
+    TempDirectory temp;
+    std::wstring root = CanonicalRoot(temp);
+    std::string source = SampleData(3 * 1024 * 1024, 170, false);
+    WriteFile(root + L"/source.bin", source);
+    int descriptor = ::open(std::filesystem::path(root + L"/source.bin").c_str(), O_RDONLY | O_CLOEXEC);
+    ASSERT_GE(descriptor, 0);
+    OutputTree output(root);
+
+    // Block-aligned ranges may be cloned, unaligned ones are copied; either way the
+    // bytes land where asked and the gap before them reads back as zeros
+    for (uint64_t sourceOffset : { 0ull, 512ull, 4096ull + 7 }) {
+        std::wstring path = root + L"/copy" + std::to_wstring(sourceOffset);
+        OutputFile file;
+        ASSERT_TRUE(output.OpenFile(path, OutputFileAttributes(), file));
+        const uint64_t length = 2 * 1024 * 1024 + 300;
+        ASSERT_TRUE(file.Write(0, "lead", 4));
+        ASSERT_TRUE(file.CopyFrom(descriptor, sourceOffset, 8192, length));
+        ASSERT_TRUE(file.Close(8192 + length));
+        std::string expected = std::string("lead") + std::string(8188, '\0') + source.substr(sourceOffset, length);
+        EXPECT_TRUE(ReadFile(path) == expected) << sourceOffset;
+    }
+    ::close(descriptor);
+}
+#endif
@@ -0,0 +1,104 @@
+#include "extraction-engine/PathMatcher.h"
+#include <gtest/gtest.h>
+
+using namespace ArchiveEngine;
+
+TEST(PathMatcher, ExactPathSelectsItselfAndEverythingBelow) {
+    PathMatcher matcher({ L"docs/guide" });
+    EXPECT_TRUE(matcher.ExactOnly());
+    EXPECT_TRUE(matcher.Matches(std::string_view("docs/guide")));
+    EXPECT_TRUE(matcher.Matches(std::string_view("docs/guide/intro.md")));
+    EXPECT_TRUE(matcher.Matches(std::string_view("docs/guide/")));
+    EXPECT_FALSE(matcher.Matches(std::string_view("docs")));
+    EXPECT_FALSE(matcher.Matches(std::string_view("docs/guidebook")));
+    EXPECT_FALSE(matcher.Matches(std::string_view("other/docs/guide")));
+}
+
+TEST(PathMatcher, IgnoresLeadingDotSlashAndTrailingSlash) {
+    PathMatcher matcher({ L"./src/", L"lib\\core" });
+    EXPECT_TRUE(matcher.Matches(std::string_view("src/main.cpp")));
+    EXPECT_TRUE(matcher.Matches(std::string_view("./src/main.cpp")));
+    EXPECT_TRUE(matcher.Matches(std::string_view("src/")));
+    EXPECT_TRUE(matcher.Matches(std::string_view("lib/core/a.h")));
+    EXPECT_FALSE(matcher.Matches(std::string_view("lib")));
+    EXPECT_FALSE(matcher.Matches(std::string_view(".")));
+}
+
+TEST(PathMatcher, StarStaysWithinOneComponent) {
+    PathMatcher matcher({ L"src/*.cpp" });
+    EXPECT_FALSE(matcher.ExactOnly());
+    EXPECT_TRUE(matcher.Matches(std::string_view("src/main.cpp")));
+    EXPECT_TRUE(matcher.Matches(std::string_view("src/.cpp")));
+    EXPECT_FALSE(matcher.Matches(std::string_view("src/sub/main.cpp")));
+    EXPECT_FALSE(matcher.Matches(std::string_view("src/main.h")));
+}
+
+TEST(PathMatcher, QuestionMarkMatchesOneCharacterButNotASeparator) {
+    PathMatcher matcher({ L"v?/data" });
+    EXPECT_TRUE(matcher.Matches(std::string_view("v1/data")));
+    EXPECT_TRUE(matcher.Matches(std::string_view("v2/data/file")));
+    EXPECT_FALSE(matcher.Matches(std::string_view("v/data")));
+    EXPECT_FALSE(matcher.Matches(std::string_view("v10/data")));
+    EXPECT_FALSE(matcher.Matches(std::string_view("v//data")));
+}
+
+TEST(PathMatcher, DoubleStarCrossesComponents) {
+    PathMatcher matcher({ L"**/*.txt" });
+    EXPECT_TRUE(matcher.Matches(std::string_view("a.txt")));
+    EXPECT_TRUE(matcher.Matches(std::string_view("x/a.txt")));
+    EXPECT_TRUE(matcher.Matches(std::string_view("x/y/z/a.txt")));
+    EXPECT_FALSE(matcher.Matches(std::string_view("x/a.txt.bak")));
+
+    PathMatcher middle({ L"src/**/test" });
+    EXPECT_TRUE(middle.Matches(std::string_view("src/test")));
+    EXPECT_TRUE(middle.Matches(std::string_view("src/a/b/test/case.cpp")));
+    EXPECT_FALSE(middle.Matches(std::string_view("src/atest")));
+
+    PathMatcher trailing({ L"build/**" });
+    EXPECT_TRUE(trailing.Matches(std::string_view("build/out/bin")));
+    EXPECT_FALSE(trailing.Matches(std::string_view("builder/x")));
+}
+
+TEST(PathMatcher, GlobOnADirectorySelectsItsContents) {
+    PathMatcher matcher({ L"pkg/*/" });
+    EXPECT_TRUE(matcher.Matches(std::string_view("pkg/a")));
+    EXPECT_TRUE(matcher.Matches(std::string_view("pkg/a/b/c")));
+    EXPECT_FALSE(matcher.Matches(std::string_view("pkg")));
+}
+
+TEST(PathMatcher, ReportsExactPathsNothingSelected) {
+    PathMatcher matcher({ L"b", L"a/x", L"a/x/", L"c/*" });
+    ASSERT_EQ(matcher.ExactCount(), 2u);
+    EXPECT_EQ(matcher.Exact(0), "a/x");
+    EXPECT_EQ(matcher.Exact(1), "b");
+
+    std::vector<bool> found(matcher.ExactCount());
+    matcher.MarkExact(std::string_view("a/x/file"), found);
+    matcher.MarkExact(std::string_view("c/y"), found);
+    EXPECT_TRUE(found[0]);
+    EXPECT_FALSE(found[1]);
+    EXPECT_EQ(matcher.Unmatched(found), L"b");
+
+    matcher.MarkExact(std::wstring(L"./b/"), found);
+    EXPECT_EQ(matcher.Unmatched(found), L"");
+}
+
+TEST(PathMatcher, StarsDoNotBacktrackExponentially) {
+    // A recursive matcher retries every split of the path between the stars
+    PathMatcher matcher({ L"**/**/**/a*a*a*b" });
+    std::string path;
+    for (int i = 0; i < 40; ++i) {
+        path += "aaaa/";
+    }
+    path += std::string(200, 'a');
+    EXPECT_FALSE(matcher.Matches(std::string_view(path)));
+    EXPECT_TRUE(matcher.Matches(std::string_view(path + "b")));
+
+    PathMatcher longPath({ L"**/x*y" });
+    std::string deep(1000, 'x');
+    for (int i = 0; i < 200; ++i) {
+        deep += "/xx";
+    }
+    EXPECT_FALSE(longPath.Matches(std::string_view(deep)));
+    EXPECT_TRUE(longPath.Matches(std::string_view(deep + "y")));
+}
@@ -0,0 +1,84 @@
+#include "TestArchives.h"
+#include "extraction-engine/PathValidator.h"
+#include "extraction-engine/TarExtractor.h"
+#include <gtest/gtest.h>
+
+using namespace ArchiveEngine;
+using namespace ArchiveEngine::Testing;
+
+namespace {
+
+    const std::wstring Sep(1, static_cast<wchar_t>(std::filesystem::path::preferred_separator));
+
+} // namespace
+
+TEST(PathValidator, ResolvesEntriesBelowCanonicalBase) {
+    TempDirectory temp;
+    std::filesystem::create_directories(temp.Path() / "dest");
+    std::wstring base = std::filesystem::canonical(temp.Path() / "dest").wstring();
+
+    // A trailing separator and "." components are dropped from the destination
+    PathValidator paths(temp / "dest/./");
+    EXPECT_EQ(paths.Base(), base);
+
+    std::wstring output;
+    ASSERT_TRUE(paths.Resolve(L"a/b/c.txt", output));
+    EXPECT_EQ(output, base + Sep + L"a" + Sep + L"b" + Sep + L"c.txt");
+    ASSERT_TRUE(paths.Resolve(L"./a//b\\c.txt", output));
+    EXPECT_EQ(output, base + Sep + L"a" + Sep + L"b" + Sep + L"c.txt");
+    ASSERT_TRUE(paths.Resolve(L"dir/", output));
+    EXPECT_EQ(output, base + Sep + L"dir");
+}
+
+#ifndef _WIN32
+TEST(PathValidator, ResolvesSymbolicLinksInTheDestinationOnce) {
+    TempDirectory temp;
+    std::filesystem::create_directories(temp.Path() / "real");
+    std::filesystem::create_directory_symlink(temp.Path() / "real", temp.Path() / "alias");
+
+    PathValidator paths(temp / "alias");
+    EXPECT_EQ(paths.Base(), std::filesystem::canonical(temp.Path() / "real").wstring());
+}
+#endif
+
+TEST(PathValidator, RejectsPathsLeavingTheDestination) {
+    TempDirectory temp;
+    PathValidator paths(temp.Path().wstring());
+    std::wstring output;
+    for (const wchar_t* entry : { L"../escape", L"a/../../escape", L"a/../b", L"..", L"a/...",
+                                  L"/etc/passwd", L"\\windows\\system32", L"a\\..\\..\\b" }) {
+        EXPECT_FALSE(paths.Resolve(entry, output)) << entry;
+    }
+}
+
+TEST(PathValidator, MakesComponentsSafeForWindows) {
+    TempDirectory temp;
+    PathValidator paths(temp.Path().wstring());
+    const std::wstring& base = paths.Base();
+    std::wstring output;
+
+    ASSERT_TRUE(paths.Resolve(L"C:/x", output));
+    EXPECT_EQ(output, base + Sep + L"C_" + Sep + L"x");
+    ASSERT_TRUE(paths.Resolve(L"a<b>|c?*\"d", output));
+    EXPECT_EQ(output, base + Sep + L"a_b__c___d");
+    ASSERT_TRUE(paths.Resolve(L"name. . /x ", output));
+    EXPECT_EQ(output, base + Sep + L"name" + Sep + L"x");
+    ASSERT_TRUE(paths.Resolve(L"dir/CON/aux/com1/lpt9/nul.txt/com0", output));
+    EXPECT_EQ(output, base + Sep + L"dir" + Sep + L"CON_" + Sep + L"aux_" + Sep + L"com1_" + Sep + L"lpt9_" +
+                      Sep + L"nul.txt" + Sep + L"com0");
+    ASSERT_TRUE(paths.Resolve(L" /x", output));
+    EXPECT_EQ(output, base + Sep + L"_" + Sep + L"x");
+}
+
+TEST(PathValidator, ExtractionStopsAtAnEscapingEntry) {
+    TempDirectory temp;
+    TarBuilder tar;
+    tar.AddFile("inside.txt", "inside");
+    tar.AddFile("../outside.txt", "outside");
+    WriteFile(temp / "escape.tar", tar.Finish());
+
+    ExtractionResult result = TarExtractor().Extract(temp / "escape.tar", temp / "out", ExtractionOptions());
+    EXPECT_FALSE(result.success);
+    EXPECT_NE(result.errorMessage.find(L"../outside.txt"), std::wstring::npos);
+    EXPECT_FALSE(std::filesystem::exists(temp.Path() / "outside.txt"));
+}
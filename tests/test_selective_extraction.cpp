@@ -0,0 +1,77 @@
+#include "TestArchives.h"
+#include "extraction-engine/TarExtractor.h"
+#include <gtest/gtest.h>
+
+using namespace ArchiveEngine;
+using namespace ArchiveEngine::Testing;
+
+namespace {
+
+    ExtractionResult ExtractSelected(const std::wstring& archive, const std::wstring& destination,
+                                     const std::vector<std::wstring>& paths, bool useIndex,
+                                     bool collectStats = false) {
+        TarExtractor extractor;
+        ExtractionOptions options;
+        options.useIndex = useIndex;
+        options.collectStats = collectStats;
+        return extractor.Extract(archive, destination, paths, options);
+    }
+
+} // namespace
+
+TEST(SelectiveExtraction, KeepsLastCopyAndReportsMissingPaths) {
+    TempDirectory temp;
+    TarBuilder tar;
+    // A first copy large enough to still be written when the second one is queued
+    tar.AddFile("a.txt", SampleData(8 * 1024 * 1024, 48, false));
+    tar.AddFile("d/b.txt", "b");
+    tar.AddFile("d/e/f.txt", "f");
+    tar.AddFile("a.txt", "second");
+    WriteFile(temp / "dup.tar", tar.Finish());
+
+    for (bool useIndex : { false, true, true }) {
+        // The second pass with the index reads it back
+        std::wstring out = temp / (useIndex ? "indexed" : "scanned");
+        std::filesystem::remove_all(out);
+        ExtractionResult result = ExtractSelected(temp / "dup.tar", out, { L"a.txt", L"d/e" }, useIndex);
+        ASSERT_TRUE(result.success);
+        EXPECT_TRUE(ReadFile(out + L"/a.txt") == "second") << (useIndex ? "indexed" : "scanned");
+        EXPECT_EQ(ReadFile(out + L"/d/e/f.txt"), "f");
+        EXPECT_FALSE(std::filesystem::exists(out + L"/d/b.txt"));
+
+        result = ExtractSelected(temp / "dup.tar", out, { L"a.txt", L"missing.txt" }, useIndex);
+        EXPECT_FALSE(result.success);
+        EXPECT_NE(result.errorMessage.find(L"missing.txt"), std::wstring::npos);
+    }
+
+    ExtractionResult result = ExtractSelected(temp / "dup.tar", temp / "glob", { L"d/**/?.txt" }, false);
+    ASSERT_TRUE(result.success);
+    EXPECT_TRUE(std::filesystem::exists(temp / "glob/d/b.txt"));
+    EXPECT_TRUE(std::filesystem::exists(temp / "glob/d/e/f.txt"));
+    EXPECT_FALSE(std::filesystem::exists(temp / "glob/a.txt"));
+}
+
+TEST(SelectiveExtraction, IndexedExactPathsVisitOnlyTheirHeaders) {
+    TempDirectory temp;
+    TarBuilder tar;
+    for (int i = 0; i < 50; ++i) {
+        tar.AddFile("d" + std::to_string(i % 5) + "/f" + std::to_string(i), SampleData(2000 + i, 60 + i));
+    }
+    WriteFile(temp / "sel.tar", tar.Finish());
+
+    // The first extraction scans every header and writes the index
+    ExtractionResult scanned = ExtractSelected(temp / "sel.tar", temp / "scanned", { L"d3/f13", L"d1/f41" }, true, true);
+    ASSERT_TRUE(scanned.success);
+    ASSERT_TRUE(scanned.stats);
+    EXPECT_GE(scanned.stats->Phase(ExtractionPhase::ReadHeader).count, 50u);
+
+    // With the index, the two headers are looked up and everything else is skipped
+    ExtractionResult indexed = ExtractSelected(temp / "sel.tar", temp / "indexed", { L"d3/f13", L"d1/f41" }, true, true);
+    ASSERT_TRUE(indexed.success);
+    ASSERT_TRUE(indexed.stats);
+    EXPECT_EQ(indexed.stats->Phase(ExtractionPhase::ReadHeader).count, 2u);
+    EXPECT_EQ(indexed.extractedFiles.size(), 2u);
+    EXPECT_EQ(ReadFile(temp / "indexed/d3/f13"), SampleData(2013, 73));
+    EXPECT_EQ(ReadFile(temp / "indexed/d1/f41"), SampleData(2041, 101));
+    EXPECT_FALSE(std::filesystem::exists(temp / "indexed/d0"));
+}
@@ -0,0 +1,105 @@
+#include "TestArchives.h"
+#include "extraction-engine/TarExtractor.h"
+#include <gtest/gtest.h>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+using namespace ArchiveEngine;
+using namespace ArchiveEngine::Testing;
+
+namespace {
+
+    ExtractionResult ExtractTar(const std::wstring& archive, const std::wstring& destination,
+                                const ExtractionOptions& options = ExtractionOptions()) {
+        TarExtractor extractor;
+        return extractor.Extract(archive, destination, options);
+    }
+
+#ifndef _WIN32
+    // Bytes the file system has allocated for `path`
+    uint64_t AllocatedBytes(const std::wstring& path) {
+        struct stat st;
+        return ::stat(std::filesystem::path(path).c_str(), &st) == 0 ? static_cast<uint64_t>(st.st_blocks) * 512 : 0;
+    }
+#endif
+
+} // namespace
+
+TEST(SparseEntries, ExtractsGnuSparseFiles) {
+    TempDirectory temp;
+    // Six regions need an extension block; the file ends in a hole
+    std::vector<SparseRegion> regions;
+    for (uint64_t i = 0; i < 6; ++i) {
+        regions.emplace_back(i * 300000 + (i % 2) * 1000, SampleData(5000 + i * 700, 36 + static_cast<uint32_t>(i)));
+    }
+    const uint64_t realSize = 2000000;
+    TarBuilder tar;
+    tar.AddGnuSparse("sparse.bin", realSize, regions);
+    tar.AddFile("after.txt", "after");
+    WriteFile(temp / "gnu.tar", tar.Finish());
+
+    ASSERT_TRUE(ExtractTar(temp / "gnu.tar", temp / "out").success);
+    EXPECT_EQ(ReadFile(temp / "out/sparse.bin"), TarBuilder::Expand(realSize, regions));
+    EXPECT_EQ(ReadFile(temp / "out/after.txt"), "after");
+
+    std::vector<ArchiveEntry> entries;
+    ASSERT_TRUE(TarExtractor().GetArchiveInfo(temp / "gnu.tar", entries));
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[0].size, realSize);
+}
+
+TEST(SparseEntries, ExtractsPaxSparseFiles) {
+    TempDirectory temp;
+    std::vector<SparseRegion> regions = {
+        { 0, SampleData(4096, 42) },
+        { 1 << 20, SampleData(10000, 43, false) },
+        { (3 << 20) - 1, "z" },
+    };
+    const uint64_t realSize = 3 << 20;
+    TarBuilder tar;
+    tar.AddPaxSparse("dir/sparse.img", realSize, regions);
+    tar.AddFile("after.txt", "after");
+    WriteFile(temp / "pax.tar", tar.Finish());
+
+    for (bool holes : { false, true }) {
+        ExtractionOptions options;
+        options.writeHoles = holes;
+        std::wstring out = temp / (holes ? "holes" : "plain");
+        ASSERT_TRUE(ExtractTar(temp / "pax.tar", out, options).success);
+        EXPECT_EQ(ReadFile(out + L"/dir/sparse.img"), TarBuilder::Expand(realSize, regions));
+        EXPECT_EQ(ReadFile(out + L"/after.txt"), "after");
+        EXPECT_FALSE(std::filesystem::exists(out + L"/GNUSparseFile.0"));
+    }
+}
+
+#ifndef _WIN32
+TEST(SparseEntries, LeaveHolesInsteadOfWritingZeros) {
+    TempDirectory temp;
+    const uint64_t realSize = 64 << 20;
+    std::vector<SparseRegion> regions = { { 1 << 20, SampleData(8192, 55, false) }, { realSize - 4096, "end" } };
+    std::string zeros = std::string(8 << 20, '\0') + SampleData(4096, 56, false) + std::string(8 << 20, '\0');
+    TarBuilder tar;
+    tar.AddPaxSparse("sparse.img", realSize, regions);
+    tar.AddFile("zeros.bin", zeros);
+    WriteFile(temp / "holes.tar", tar.Finish());
+
+    for (unsigned writers : { 0u, 4u }) {
+        ExtractionOptions options;
+        options.writerThreads = writers;
+        options.writeHoles = true;
+        options.kernelCopyThreshold = 0;
+        std::wstring out = temp / ("out" + std::to_string(writers));
+        ASSERT_TRUE(ExtractTar(temp / "holes.tar", out, options).success);
+        EXPECT_EQ(std::filesystem::file_size(out + L"/sparse.img"), realSize);
+        EXPECT_TRUE(ReadFile(out + L"/zeros.bin") == zeros);
+        if (AllocatedBytes(out + L"/sparse.img") >= realSize) {
+            GTEST_SKIP() << "The file system does not keep holes";
+        }
+        // The gaps of the sparse entry and the zero runs of the plain one are never written
+        EXPECT_LT(AllocatedBytes(out + L"/sparse.img"), 1u << 20) << writers;
+        EXPECT_LT(AllocatedBytes(out + L"/zeros.bin"), 1u << 20) << writers;
+    }
+}
+#endif
@@ -0,0 +1,221 @@
+#include "TestArchives.h"
+#include "extraction-engine/Bzip2Extractor.h"
+#include "extraction-engine/GzipExtractor.h"
+#include "extraction-engine/TarExtractor.h"
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <fstream>
+
+using namespace ArchiveEngine;
+using namespace ArchiveEngine::Testing;
+
+namespace {
+
+    ExtractionResult ExtractTar(const std::wstring& archive, const std::wstring& destination,
+                                const ExtractionOptions& options = ExtractionOptions()) {
+        TarExtractor extractor;
+        return extractor.Extract(archive, destination, options);
+    }
+
+#ifndef _WIN32
+    // Reads a file named by bytes, which need not convert to a wide string
+    std::string ReadPath(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+#endif
+
+} // namespace
+
+TEST(TarExtractor, ExtractsFilesAndDirectories) {
+    TempDirectory temp;
+    std::string small = SampleData(100, 31);
+    std::string large = SampleData(3 * 1024 * 1024, 32, false);
+    TarBuilder tar;
+    tar.AddDirectory("top/", 0755);
+    tar.AddFile("top/small.txt", small, 0640);
+    tar.AddFile("top/sub/large.bin", large, 0600);
+    tar.AddFile("top/empty", std::string());
+    WriteFile(temp / "files.tar", tar.Finish());
+
+    for (unsigned writers : { 0u, 4u }) {
+        ExtractionOptions options;
+        options.writerThreads = writers;
+        std::wstring out = temp / ("out" + std::to_string(writers));
+        ExtractionResult result = ExtractTar(temp / "files.tar", out, options);
+        ASSERT_TRUE(result.success) << writers << " writers";
+        EXPECT_EQ(ReadFile(out + L"/top/small.txt"), small);
+        EXPECT_EQ(ReadFile(out + L"/top/sub/large.bin"), large);
+        EXPECT_TRUE(std::filesystem::is_regular_file(out + L"/top/empty"));
+        EXPECT_EQ(std::filesystem::file_size(out + L"/top/empty"), 0u);
+#ifndef _WIN32
+        auto permissions = std::filesystem::status(out + L"/top/sub/large.bin").permissions();
+        EXPECT_EQ(permissions & std::filesystem::perms::all,
+                  std::filesystem::perms::owner_read | std::filesystem::perms::owner_write);
+#endif
+    }
+}
+
+TEST(TarExtractor, SinglePassReportsArchiveOffsets) {
+    TempDirectory temp;
+    TarBuilder tar;
+    tar.AddFile("a.bin", SampleData(10000, 51, false));
+    tar.AddFile("b.bin", SampleData(30000, 52, false));
+    tar.AddFile("c.txt", "c");
+    std::string archive = tar.Finish();
+    WriteFile(temp / "offsets.tar", archive);
+    const uint64_t uncompressed = 40001;
+
+    for (bool singlePass : { false, true }) {
+        ExtractionOptions options;
+        options.singlePass = singlePass;
+        std::vector<std::pair<uint64_t, uint64_t>> reports;
+        ExtractionResult result = TarExtractor().Extract(
+            temp / "offsets.tar", temp / (singlePass ? "single" : "scanned"), options,
+            [&reports](uint64_t current, uint64_t total, const std::wstring&, const std::wstring&) {
+                reports.emplace_back(current, total);
+                return true;
+            });
+        ASSERT_TRUE(result.success);
+        EXPECT_EQ(result.totalUncompressedSize, uncompressed);
+        ASSERT_EQ(reports.size(), 4u);
+
+        // Without the pre-scan, progress is the archive offset against the archive size
+        if (singlePass) {
+            EXPECT_EQ(reports[0].second, archive.size());
+            EXPECT_GE(reports[0].first, 512u);
+            EXPECT_GT(reports[2].first, 10000u + 30000u);
+        } else {
+            EXPECT_EQ(reports[0], std::make_pair(uint64_t(0), uncompressed));
+            EXPECT_EQ(reports[2].first, 40000u);
+        }
+
+        // The exact total is known at the end either way
+        EXPECT_EQ(reports.back(), std::make_pair(uncompressed, uncompressed));
+    }
+}
+
+#ifndef _WIN32
+TEST(TarExtractor, KeepsNonAsciiNamesApart) {
+    TempDirectory temp;
+    // UTF-8 names of the same length that differ only in their non-ASCII bytes
+    const std::string first = "caf\xC3\xA9.txt";
+    const std::string second = "caf\xC3\xBC.txt";
+    const std::string directory = "\xC3\xB1";
+    TarBuilder tar;
+    tar.AddFile(first, "first");
+    tar.AddFile(second, "second");
+    tar.AddFile(directory + "/" + first, "nested");
+    WriteFile(temp / "names.tar", tar.Finish());
+
+    for (unsigned writers : { 0u, 4u }) {
+        ExtractionOptions options;
+        options.writerThreads = writers;
+        std::filesystem::path out = temp.Path() / ("out" + std::to_string(writers));
+        ExtractionResult result = ExtractTar(temp / "names.tar", out.wstring(), options);
+        ASSERT_TRUE(result.success) << writers;
+        EXPECT_EQ(result.extractedFiles.size(), 3u);
+
+        // The file system sees the archive's bytes unchanged
+        std::vector<std::string> names;
+        for (const auto& item : std::filesystem::directory_iterator(out)) {
+            names.push_back(item.path().filename().string());
+        }
+        std::sort(names.begin(), names.end());
+        EXPECT_EQ(names, (std::vector<std::string>{ first, second, directory }));
+        EXPECT_EQ(ReadPath(out / first), "first");
+        EXPECT_EQ(ReadPath(out / second), "second");
+        EXPECT_EQ(ReadPath(out / directory / first), "nested");
+    }
+
+    // Listings and selections use the same one-byte-per-character names
+    std::vector<ArchiveEntry> entries;
+    ASSERT_TRUE(TarExtractor().GetArchiveInfo(temp / "names.tar", entries));
+    ASSERT_EQ(entries.size(), 3u);
+    EXPECT_EQ(Utils::NarrowBytes(entries[1].name), second);
+    ExtractionResult selected = TarExtractor().Extract(temp / "names.tar", temp / "selected", { entries[1].name },
+                                                       ExtractionOptions());
+    ASSERT_TRUE(selected.success);
+    EXPECT_EQ(ReadPath(temp.Path() / "selected" / second), "second");
+    EXPECT_FALSE(std::filesystem::exists(temp.Path() / "selected" / first));
+}
+#endif
+
+TEST(TarExtractor, RejectsTruncatedArchive) {
+    TempDirectory temp;
+    TarBuilder tar;
+    tar.AddFile("first.txt", SampleData(2000, 34));
+    tar.AddFile("second.bin", SampleData(100000, 35, false));
+    std::string archive = tar.Finish();
+    WriteFile(temp / "cut.tar", archive.substr(0, 512 * 8 + 50000));
+
+    ExtractionResult result = ExtractTar(temp / "cut.tar", temp / "out");
+    EXPECT_FALSE(result.success);
+    // The file cut short is not left behind
+    EXPECT_FALSE(std::filesystem::exists(temp / "out/second.bin"));
+}
+
+TEST(TarExtractor, ExtractsCompressedArchives) {
+    TempDirectory temp;
+    std::string data = SampleData(700 * 1024, 44);
+    TarBuilder tar;
+    tar.AddFile("a/data.txt", data);
+    tar.AddFile("a/b/c.txt", "c");
+    std::string archive = tar.Finish();
+    WriteFile(temp / "x.tar.gz", GzipCompress(archive));
+    WriteFile(temp / "x.tar.bz2", Bzip2Compress(archive));
+
+    ASSERT_TRUE(TarGzipExtractor().Extract(temp / "x.tar.gz", temp / "gz", ExtractionOptions()).success);
+    EXPECT_EQ(ReadFile(temp / "gz/a/data.txt"), data);
+    EXPECT_EQ(ReadFile(temp / "gz/a/b/c.txt"), "c");
+
+    ASSERT_TRUE(TarBzip2Extractor().Extract(temp / "x.tar.bz2", temp / "bz2", ExtractionOptions()).success);
+    EXPECT_EQ(ReadFile(temp / "bz2/a/data.txt"), data);
+    EXPECT_EQ(ReadFile(temp / "bz2/a/b/c.txt"), "c");
+}
+
+TEST(TarExtractor, CopiesLargePayloadsInsideTheKernel) {
+    TempDirectory temp;
+    std::string large = SampleData(3 * 1024 * 1024 + 5, 49, false);
+    std::string medium = SampleData(70000, 50, false);
+    TarBuilder tar;
+    tar.AddFile("small.txt", "small");
+    tar.AddFile("large.bin", large);
+    tar.AddFile("medium.bin", medium);
+    WriteFile(temp / "plain.tar", tar.Finish());
+
+    // Payloads above the threshold are copied from the archive file; the rest are
+    // written from the mapping
+    for (unsigned writers : { 0u, 4u }) {
+        ExtractionOptions options;
+        options.writerThreads = writers;
+        options.kernelCopyThreshold = 64 * 1024;
+        std::wstring out = temp / ("out" + std::to_string(writers));
+        ASSERT_TRUE(ExtractTar(temp / "plain.tar", out, options).success) << writers;
+        EXPECT_EQ(ReadFile(out + L"/small.txt"), "small");
+        EXPECT_TRUE(ReadFile(out + L"/large.bin") == large) << writers;
+        EXPECT_TRUE(ReadFile(out + L"/medium.bin") == medium) << writers;
+    }
+
+    // Reading ahead, copied payloads are skipped in the window and the reader moves past them
+    ExtractionOptions options;
+    options.readAheadWindow = 1024 * 1024;
+    options.kernelCopyThreshold = 64 * 1024;
+    ASSERT_TRUE(ExtractTar(temp / "plain.tar", temp / "buffered", options).success);
+    EXPECT_TRUE(ReadFile(temp / "buffered/large.bin") == large);
+}
+
+TEST(TarExtractor, ListingFailsOnCorruptCompressedData) {
+    TempDirectory temp;
+    TarBuilder tar;
+    tar.AddFile("a.txt", SampleData(5000, 46));
+    tar.AddFile("b.bin", SampleData(200000, 47, false));
+    std::string gzip = GzipCompress(tar.Finish());
+    WriteFile(temp / "cut.tar.gz", gzip.substr(0, gzip.size() / 2));
+
+    std::vector<ArchiveEntry> entries;
+    EXPECT_FALSE(TarGzipExtractor().GetArchiveInfo(temp / "cut.tar.gz", entries));
+    EXPECT_FALSE(TarGzipExtractor().VisitEntries(temp / "cut.tar.gz", ExtractionOptions(),
+                                                 [](const ArchiveEntryView&) { return true; }));
+}
@@ -0,0 +1,170 @@
+#include "TestArchives.h"
+#include "extraction-engine/TarExtractor.h"
+#include "extraction-engine/TarHeaderDecoder.h"
+#include <cstdio>
+#include <cstring>
+#include <gtest/gtest.h>
+
+using namespace ArchiveEngine;
+using namespace ArchiveEngine::Testing;
+
+namespace {
+
+    ExtractionResult ExtractTar(const std::wstring& archive, const std::wstring& destination) {
+        TarExtractor extractor;
+        return extractor.Extract(archive, destination, ExtractionOptions());
+    }
+
+    // A header with a 16-byte tail, as ParseTarNumber may read past a field
+    struct HeaderBlock {
+        char data[512 + 16] = {};
+
+        explicit HeaderBlock(const std::string& header) { std::memcpy(data, header.data(), 512); }
+    };
+
+} // namespace
+
+TEST(TarHeaderDecoder, DecodesNumericFields) {
+    HeaderBlock block(TarBuilder::Header("file", 1000, '0', 0751, 1234567890));
+    TarHeaderFields fields;
+    ASSERT_TRUE(DecodeTarHeader(block.data, fields));
+    EXPECT_EQ(fields.size, 1000u);
+    EXPECT_EQ(fields.mtime, 1234567890u);
+    EXPECT_EQ(fields.permissions, 0751u);
+}
+
+TEST(TarHeaderDecoder, RejectsChecksumMismatch) {
+    HeaderBlock block(TarBuilder::Header("file", 10, '0'));
+    block.data[0] = 'g';
+    TarHeaderFields fields;
+    EXPECT_FALSE(DecodeTarHeader(block.data, fields));
+
+    // A checksum field that is not a number at all
+    HeaderBlock garbage(TarBuilder::Header("file", 10, '0'));
+    std::memcpy(garbage.data + 148, "zzzzzz", 6);
+    EXPECT_FALSE(DecodeTarHeader(garbage.data, fields));
+}
+
+TEST(TarHeaderDecoder, AcceptsSignedChecksum) {
+    std::string header = TarBuilder::Header("caf\xe9\xff", 10, '0');
+    std::memset(&header[148], ' ', 8);
+    int64_t signedSum = 0;
+    for (char ch : header) {
+        signedSum += static_cast<signed char>(ch);
+    }
+    ASSERT_NE(signedSum, 0);
+    std::snprintf(&header[148], 8, "%06llo", static_cast<unsigned long long>(signedSum));
+
+    HeaderBlock block(header);
+    TarHeaderFields fields;
+    EXPECT_TRUE(DecodeTarHeader(block.data, fields));
+}
+
+TEST(TarHeaderDecoder, AcceptsPaddedOctal) {
+    std::string header = TarBuilder::Header("file", 0, '0');
+    // Leading spaces, space terminator
+    std::memcpy(&header[124], "      1750 ", 12);
+    TarBuilder::SetChecksum(header);
+    HeaderBlock block(header);
+    TarHeaderFields fields;
+    ASSERT_TRUE(DecodeTarHeader(block.data, fields));
+    EXPECT_EQ(fields.size, 01750u);
+}
+
+TEST(TarHeaderDecoder, RejectsMalformedNumbers) {
+    std::string header = TarBuilder::Header("file", 0, '0');
+    std::memcpy(&header[124], "00000000009", 11);
+    TarBuilder::SetChecksum(header);
+    HeaderBlock block(header);
+    TarHeaderFields fields;
+    EXPECT_FALSE(DecodeTarHeader(block.data, fields));
+}
+
+TEST(TarHeaderDecoder, DecodesBase256) {
+    // 10 GiB does not fit in 11 octal digits
+    const uint64_t size = 10ull << 30;
+    std::string header = TarBuilder::Header("big", 0, '0', 0644, 0, true);
+    std::memset(&header[124], 0, 12);
+    header[124] = static_cast<char>(0x80);
+    for (int i = 0; i < 8; ++i) {
+        header[124 + 11 - i] = static_cast<char>((size >> (8 * i)) & 0xFF);
+    }
+    std::memset(&header[136], 0, 12);
+    header[136] = static_cast<char>(0x80);
+    header[147] = 0x7F;
+    TarBuilder::SetChecksum(header);
+
+    HeaderBlock block(header);
+    TarHeaderFields fields;
+    ASSERT_TRUE(DecodeTarHeader(block.data, fields));
+    EXPECT_EQ(fields.size, size);
+    EXPECT_EQ(fields.mtime, 0x7Fu);
+
+    uint64_t value = 0;
+    EXPECT_TRUE(ParseTarNumber(block.data + 124, 12, value));
+    EXPECT_EQ(value, size);
+}
+
+TEST(TarHeaderDecoder, ExtractsBase256Sizes) {
+    TempDirectory temp;
+    std::string data = SampleData(5000, 33);
+    TarBuilder tar;
+    tar.AddBase256File("base256.txt", data);
+    tar.AddFile("after.txt", "after");
+    WriteFile(temp / "base256.tar", tar.Finish());
+
+    ASSERT_TRUE(ExtractTar(temp / "base256.tar", temp / "out").success);
+    EXPECT_EQ(ReadFile(temp / "out/base256.txt"), data);
+    EXPECT_EQ(ReadFile(temp / "out/after.txt"), "after");
+}
+
+TEST(TarHeaderDecoder, ExtractionStopsAtACorruptHeader) {
+    TempDirectory temp;
+    TarBuilder tar;
+    tar.AddFile("good.txt", "good");
+    std::string bad = TarBuilder::Header("bad.txt", 3, '0');
+    bad[0] = 'B';  // Checksum no longer matches
+    tar.AddRaw(bad);
+    tar.AddRaw(std::string(512, 'x'));
+    WriteFile(temp / "corrupt.tar", tar.Finish());
+
+    ExtractionResult result = ExtractTar(temp / "corrupt.tar", temp / "out");
+    EXPECT_FALSE(result.success);
+    EXPECT_FALSE(std::filesystem::exists(temp / "out/bad.txt"));
+    EXPECT_FALSE(std::filesystem::exists(temp / "out/Bad.txt"));
+}
+
+TEST(TarHeaderDecoder, RejectsAnyChangedByte) {
+    HeaderBlock original(TarBuilder::Header("dir/file.txt", 123456, '0', 0640, 1700000123));
+    TarHeaderFields fields;
+    ASSERT_TRUE(DecodeTarHeader(original.data, fields));
+
+    // Every byte counts towards the sum, whichever lane of the vector it lands in
+    for (size_t i = 0; i < 512; ++i) {
+        if (i >= 148 && i < 156) {
+            continue;  // The checksum field itself
+        }
+        HeaderBlock changed = original;
+        changed.data[i] = static_cast<char>(changed.data[i] + 1);
+        EXPECT_FALSE(DecodeTarHeader(changed.data, fields)) << "byte " << i;
+    }
+}
+
+TEST(TarHeaderDecoder, BadFirstHeaderFailsBeforeAnythingIsWritten) {
+    TempDirectory temp;
+    TarBuilder tar;
+    std::string bad = TarBuilder::Header("first.txt", 5, '0');
+    bad[120] = '7';  // Inside the unused part of the name field; the sum no longer matches
+    tar.AddRaw(bad);
+    tar.AddRaw(std::string("first") + std::string(507, '\0'));
+    tar.AddFile("second.txt", "second");
+    WriteFile(temp / "bad.tar", tar.Finish());
+
+    ExtractionResult result = ExtractTar(temp / "bad.tar", temp / "out");
+    EXPECT_FALSE(result.success);
+    EXPECT_TRUE(result.extractedFiles.empty());
+    EXPECT_TRUE(std::filesystem::is_empty(temp / "out"));
+
+    std::vector<ArchiveEntry> entries;
+    EXPECT_FALSE(TarExtractor().GetArchiveInfo(temp / "bad.tar", entries));
+}
@@ -0,0 +1,70 @@
+#include "TestArchives.h"
+#include "extraction-engine/TarExtractor.h"
+#include "extraction-engine/TraceRecorder.h"
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace ArchiveEngine;
+using namespace ArchiveEngine::Testing;
+
+namespace {
+
+    size_t CountOccurrences(const std::string& text, const std::string& needle) {
+        size_t count = 0;
+        for (size_t at = text.find(needle); at != std::string::npos; at = text.find(needle, at + needle.size())) {
+            ++count;
+        }
+        return count;
+    }
+
+} // namespace
+
+TEST(TraceRecorder, KeepsTheNewestSpansOfEachThread) {
+    TempDirectory temp;
+    TraceRecorder recorder(4);
+    TraceRecorder::Clock::time_point start = TraceRecorder::Clock::now();
+    for (uint64_t i = 0; i < 10; ++i) {
+        recorder.Record(i < 6 ? "old-span" : "new-span", start, start + std::chrono::microseconds(2), i);
+    }
+    std::thread([&recorder] { TraceRecorder::Span span(&recorder, "other-thread", 7); }).join();
+    {
+        TraceRecorder::Span ignored(nullptr, "no-recorder");
+    }
+
+    ASSERT_TRUE(recorder.Write(temp / "trace.json"));
+    std::string json = ReadFile(temp / "trace.json");
+    EXPECT_EQ(json.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0), 0u);
+    EXPECT_EQ(CountOccurrences(json, "\"name\":\"old-span\""), 0u);
+    EXPECT_EQ(CountOccurrences(json, "\"name\":\"new-span\""), 4u);
+    EXPECT_EQ(CountOccurrences(json, "\"name\":\"other-thread\""), 1u);
+    EXPECT_EQ(CountOccurrences(json, "no-recorder"), 0u);
+    EXPECT_EQ(CountOccurrences(json, "\"tid\":1,"), 4u);
+    EXPECT_EQ(CountOccurrences(json, "\"tid\":2,"), 1u);
+    EXPECT_NE(json.find("\"dur\":2.000,\"args\":{\"bytes\":9}"), std::string::npos);
+    EXPECT_NE(json.find("\"args\":{\"bytes\":7}"), std::string::npos);
+    EXPECT_NE(json.find("\"otherData\":{\"droppedSpans\":6}"), std::string::npos);
+}
+
+TEST(TraceRecorder, IsWrittenForTarExtractions) {
+    TempDirectory temp;
+    TarBuilder tar;
+    tar.AddDirectory("d/");
+    tar.AddFile("d/a.txt", SampleData(3000, 192));
+    tar.AddFile("d/b.txt", "b");
+    WriteFile(temp / "trace.tar", tar.Finish());
+
+    ExtractionOptions options;
+    options.writerThreads = 2;
+    options.tracePath = temp / "extract.json";
+    ExtractionResult result = TarExtractor().Extract(temp / "trace.tar", temp / "out", options);
+    ASSERT_TRUE(result.success);
+
+    std::string json = ReadFile(temp / "extract.json");
+    EXPECT_GE(CountOccurrences(json, "\"name\":\"read-header\""), 3u);
+    EXPECT_EQ(CountOccurrences(json, "\"name\":\"create-directory\""), 1u);
+    EXPECT_EQ(CountOccurrences(json, "\"name\":\"open-file\""), 2u);
+    EXPECT_EQ(CountOccurrences(json, "\"name\":\"close-file\""), 2u);
+    // Files are written on the pool's threads, not the reader's
+    EXPECT_NE(json.find("\"tid\":2,"), std::string::npos);
+    EXPECT_NE(json.find("\"droppedSpans\":0}"), std::string::npos);
+}
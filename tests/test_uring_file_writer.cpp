@@ -0,0 +1,144 @@
+#include "TestArchives.h"
+#include "extraction-engine/TarExtractor.h"
+#include "extraction-engine/UringFileWriter.h"
+#include <gtest/gtest.h>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+using namespace ArchiveEngine;
+using namespace ArchiveEngine::Testing;
+
+namespace {
+
+    std::wstring CanonicalRoot(const TempDirectory& temp) {
+        return std::filesystem::canonical(temp.Path()).wstring();
+    }
+
+    bool AddFile(UringFileWriter& batch, const std::wstring& path, const std::string& data,
+                 const OutputFileAttributes& attributes = OutputFileAttributes()) {
+        char* buffer = nullptr;
+        if (!batch.AddFile(path, path, attributes, data.size(), buffer)) {
+            return false;
+        }
+        std::copy(data.begin(), data.end(), buffer);
+        return true;
+    }
+
+    bool UringAvailable() {
+        TempDirectory temp;
+        OutputTree output(CanonicalRoot(temp));
+        return UringFileWriter(output).IsAvailable();
+    }
+
+} // namespace
+
+TEST(UringFileWriter, WritesBatchesOfSmallFiles) {
+    if (!UringAvailable()) {
+        GTEST_SKIP() << "io_uring unavailable";
+    }
+    TempDirectory temp;
+    std::wstring root = CanonicalRoot(temp);
+    OutputTree output(root);
+    UringFileWriter batch(output);
+
+    // Enough files and bytes to fill several batches
+    std::vector<std::string> contents;
+    OutputFileAttributes attributes;
+    attributes.permissions = 0600;
+    attributes.mtime = 1650000000;
+    for (uint32_t i = 0; i < 400; ++i) {
+        contents.push_back(SampleData(i * 97 % UringFileWriter::MaxFileSize, 150 + i));
+        ASSERT_TRUE(AddFile(batch, root + L"/d" + std::to_wstring(i % 7) + L"/f" + std::to_wstring(i),
+                            contents.back(), attributes));
+    }
+    std::wstring failedName;
+    ASSERT_TRUE(batch.Finish(failedName));
+    EXPECT_FALSE(batch.Failed());
+
+    for (uint32_t i = 0; i < 400; ++i) {
+        std::wstring path = root + L"/d" + std::to_wstring(i % 7) + L"/f" + std::to_wstring(i);
+        ASSERT_EQ(ReadFile(path), contents[i]) << i;
+    }
+#ifndef _WIN32
+    struct stat st;
+    ASSERT_EQ(::stat(std::filesystem::path(root + L"/d3/f3").c_str(), &st), 0);
+    EXPECT_EQ(st.st_mode & 0777, output.FileMode(0600));
+    EXPECT_EQ(st.st_mtime, 1650000000);
+#endif
+}
+
+TEST(UringFileWriter, ReplacesExistingFilesInOrder) {
+    if (!UringAvailable()) {
+        GTEST_SKIP() << "io_uring unavailable";
+    }
+    TempDirectory temp;
+    std::wstring root = CanonicalRoot(temp);
+    WriteFile(root + L"/existing.txt", "a longer file already there");
+    std::filesystem::permissions(root + L"/existing.txt", std::filesystem::perms::owner_all);
+    OutputTree output(root);
+    UringFileWriter batch(output);
+
+    OutputFileAttributes attributes;
+    attributes.permissions = 0640;
+    ASSERT_TRUE(AddFile(batch, root + L"/existing.txt", "new", attributes));
+    ASSERT_TRUE(AddFile(batch, root + L"/twice.txt", "first"));
+    ASSERT_TRUE(AddFile(batch, root + L"/twice.txt", "second"));
+    std::wstring failedName;
+    ASSERT_TRUE(batch.Finish(failedName));
+
+    EXPECT_EQ(ReadFile(root + L"/existing.txt"), "new");
+    EXPECT_EQ(ReadFile(root + L"/twice.txt"), "second");
+#ifndef _WIN32
+    struct stat st;
+    ASSERT_EQ(::stat(std::filesystem::path(root + L"/existing.txt").c_str(), &st), 0);
+    EXPECT_EQ(st.st_mode & 0777, output.FileMode(0640));
+#endif
+}
+
+TEST(UringFileWriter, ReportsFilesThatCannotBeWritten) {
+    if (!UringAvailable()) {
+        GTEST_SKIP() << "io_uring unavailable";
+    }
+    TempDirectory temp;
+    std::wstring root = CanonicalRoot(temp);
+    std::filesystem::create_directories(root + L"/taken");
+    OutputTree output(root);
+    UringFileWriter batch(output);
+
+    // A directory where the file should go fails the open and then the replacement
+    ASSERT_TRUE(AddFile(batch, root + L"/ok.txt", "ok"));
+    ASSERT_TRUE(AddFile(batch, root + L"/taken", "lost"));
+    std::wstring failedName;
+    EXPECT_FALSE(batch.Finish(failedName));
+    EXPECT_EQ(failedName, root + L"/taken");
+    EXPECT_EQ(ReadFile(root + L"/ok.txt"), "ok");
+}
+
+TEST(UringFileWriter, LastCopyWinsAcrossWriteBackEnds) {
+    if (!UringAvailable()) {
+        GTEST_SKIP() << "io_uring unavailable";
+    }
+    TempDirectory temp;
+    std::string large = SampleData(4 * 1024 * 1024, 160, false);
+    std::string largeB = SampleData(200 * 1024, 161);
+    TarBuilder tar;
+    // Small copies are batched, large ones go through the writers or are written inline
+    tar.AddFile("a.txt", "small first");
+    tar.AddFile("a.txt", large);
+    tar.AddFile("b.txt", largeB);
+    tar.AddFile("b.txt", "small second");
+    WriteFile(temp / "mixed.tar", tar.Finish());
+
+    for (unsigned writers : { 0u, 4u }) {
+        ExtractionOptions options;
+        options.batchSmallFiles = true;
+        options.writerThreads = writers;
+        std::wstring out = temp / ("out" + std::to_string(writers));
+        ExtractionResult result = TarExtractor().Extract(temp / "mixed.tar", out, options);
+        ASSERT_TRUE(result.success) << writers;
+        EXPECT_TRUE(ReadFile(out + L"/a.txt") == large) << writers << " writers";
+        EXPECT_EQ(ReadFile(out + L"/b.txt"), "small second") << writers << " writers";
+    }
+}